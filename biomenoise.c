@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <float.h>
+#include <limits.h>
 
 
 //==============================================================================
@@ -44,6 +45,46 @@ void initSurfaceNoise(SurfaceNoise *sn, int dim, uint64_t seed)
     }
 }
 
+// The blended noise of the 1.18+ Overworld initializes its octaves in the
+// legacy order (highest frequency first), but with xoroshiro128++.
+static void xOctaveInitLegacy(OctaveNoise *noise, Xoroshiro *xr,
+        PerlinNoise *octaves, int len)
+{
+    int i;
+    double persist = 1.0 / ((1LL << len) - 1.0);
+    double lacuna = 1.0;
+
+    for (i = 0; i < len; i++)
+    {
+        xPerlinInit(&octaves[i], xr);
+        octaves[i].amplitude = persist;
+        octaves[i].lacunarity = lacuna;
+        persist *= 2.0;
+        lacuna *= 0.5;
+    }
+    noise->octaves = octaves;
+    noise->octcnt = len;
+}
+
+void initSurfaceNoise118(SurfaceNoise *sn, uint64_t seed)
+{
+    Xoroshiro xr;
+    xSetSeed(&xr, seed);
+    uint64_t xlo = xNextLong(&xr);
+    uint64_t xhi = xNextLong(&xr);
+    xr.lo = xlo ^ 0x1ee555222ef96f14; // md5 "minecraft:terrain"
+    xr.hi = xhi ^ 0xe2bedfdbebe43d33;
+    xOctaveInitLegacy(&sn->octmin, &xr, sn->oct+0, 16);
+    xOctaveInitLegacy(&sn->octmax, &xr, sn->oct+16, 16);
+    xOctaveInitLegacy(&sn->octmain, &xr, sn->oct+32, 8);
+    memset(&sn->octsurf, 0, sizeof(sn->octsurf));
+    memset(&sn->octdepth, 0, sizeof(sn->octdepth));
+    sn->xzScale = 1.0;
+    sn->yScale = 1.0;
+    sn->xzFactor = 80;
+    sn->yFactor = 160;
+}
+
 void initSurfaceNoiseBeta(SurfaceNoiseBeta *snb, uint64_t seed)
 {
     uint64_t s;
@@ -170,17 +211,19 @@ void setNetherSeed(NetherNoise *nn, uint64_t seed)
     doublePerlinInit(&nn->humidity, &s, &nn->oct[4], &nn->oct[6], -7, 2);
 }
 
+static const float g_nether_points[5][4] = {
+    { 0,    0,      0,              nether_wastes       },
+    { 0,   -0.5,    0,              soul_sand_valley    },
+    { 0.4,  0,      0,              crimson_forest      },
+    { 0,    0.5,    0.375*0.375,    warped_forest       },
+    {-0.5,  0,      0.175*0.175,    basalt_deltas       },
+};
+
 /* Gets the 3D nether biome at scale 1:4 (for 1.16+).
  */
 int getNetherBiome(const NetherNoise *nn, int x, int y, int z, float *ndel)
 {
-    const float npoints[5][4] = {
-        { 0,    0,      0,              nether_wastes       },
-        { 0,   -0.5,    0,              soul_sand_valley    },
-        { 0.4,  0,      0,              crimson_forest      },
-        { 0,    0.5,    0.375*0.375,    warped_forest       },
-        {-0.5,  0,      0.175*0.175,    basalt_deltas       },
-    };
+    const float (*npoints)[4] = g_nether_points;
 
     y = 0;
     float temp = sampleDoublePerlin(&nn->temperature, x, y, z);
@@ -211,6 +254,43 @@ int getNetherBiome(const NetherNoise *nn, int x, int y, int z, float *ndel)
     return id;
 }
 
+/* Batched getNetherBiome() for up to PERLIN_LANES points (x[k], 0, z) of a
+ * row. The noise is sampled for all points together and the nearest point
+ * search is done with selects rather than branches, so it runs across lanes.
+ */
+static void getNetherBiomeLanes(const NetherNoise *nn, int *ids, float *ndel,
+    const double *x, double z, int n)
+{
+    const float (*npoints)[4] = g_nether_points;
+    double vt[PERLIN_LANES], vh[PERLIN_LANES];
+    int i, k;
+
+    sampleDoublePerlinRow(&nn->temperature, vt, x, 0, z, n);
+    sampleDoublePerlinRow(&nn->humidity, vh, x, 0, z, n);
+
+    for (k = 0; k < n; k++)
+    {
+        float temp = vt[k];
+        float humidity = vh[k];
+        float dmin = FLT_MAX;
+        float dmin2 = FLT_MAX;
+        int id = 0;
+        for (i = 0; i < 5; i++)
+        {
+            float dx = npoints[i][0] - temp;
+            float dy = npoints[i][1] - humidity;
+            float dsq = dx*dx + dy*dy + npoints[i][2];
+            int lt = dsq < dmin;
+            float d2 = dsq < dmin2 ? dsq : dmin2;
+            dmin2 = lt ? dmin : d2;
+            dmin = lt ? dsq : dmin;
+            id = lt ? i : id;
+        }
+        ndel[k] = sqrtf(dmin2) - sqrtf(dmin);
+        ids[k] = (int) npoints[id][3];
+    }
+}
+
 
 static void fillRad3D(int *out, int x, int y, int z, int sx, int sy, int sz,
     int id, float rad)
@@ -271,26 +351,56 @@ int mapNether3D(const NetherNoise *nn, int *out, Range r, float confidence)
     // cell that will have the same biome.
     float invgrad = 1.0 / (confidence * 0.05 * 2) / scale;
 
+    // Cells are sampled in batches of the next few unfilled cells of a row.
+    // Where the fills cover the neighbouring cells, part of a batch would be
+    // wasted, so the batch size adapts to the fraction of samples used.
+    double bx[PERLIN_LANES];
+    int bi[PERLIN_LANES], bv[PERLIN_LANES];
+    float bdel[PERLIN_LANES];
+    int lanes = PERLIN_LANES;
+
     for (k = 0; k < r.sy; k++)
     {
         int *yout = &out[k*r.sx*r.sz];
 
         for (j = 0; j < r.sz; j++)
         {
+            int zj = (r.z+j)*scale;
+            int bn = 0, bk = 0, used = 0;
+
             for (i = 0; i < r.sx; i++)
             {
                 if (yout[j*r.sx+i])
                     continue;
-                //yout[j*w+i] = getNetherBiome(nn, x+i, y+k, z+j, NULL);
-                //continue;
-
-                float noisedelta;
-                int xi = (r.x+i)*scale;
-                int yk = (r.y+k);
-                int zj = (r.z+j)*scale;
-                int v = getNetherBiome(nn, xi, yk, zj, &noisedelta);
+
+                while (bk < bn && bi[bk] < i)
+                    bk++;
+                if (bk >= bn)
+                {   // fetch the next batch of unfilled cells
+                    int64_t ii;
+                    if (bn)
+                    {
+                        if (used < bn)
+                            lanes = lanes > 1 ? lanes >> 1 : 1;
+                        else if (lanes < PERLIN_LANES)
+                            lanes <<= 1;
+                    }
+                    bn = bk = used = 0;
+                    for (ii = i; ii < r.sx && bn < lanes; ii++)
+                    {
+                        if (yout[j*r.sx+ii])
+                            continue;
+                        bi[bn] = ii;
+                        bx[bn] = (r.x+ii)*scale;
+                        bn++;
+                    }
+                    getNetherBiomeLanes(nn, bv, bdel, bx, zj, bn);
+                }
+
+                int v = bv[bk];
                 yout[j*r.sx+i] = v;
-                float cellrad = noisedelta * invgrad;
+                used++;
+                float cellrad = bdel[bk] * invgrad;
                 fillRad3D(out, i, j, k, r.sx, r.sy, r.sz, v, cellrad);
             }
         }
@@ -322,41 +432,20 @@ int genNetherScaled(const NetherNoise *nn, int *out, Range r, int mc, uint64_t s
     if (r.scale == 1)
     {
         Range s = getVoronoiSrcRange(r);
-        int *src;
         if (siz > 1)
         {   // the source range is large enough that we can try optimizing
-            src = out + siz;
+            int *src = out + siz;
             int err = mapNether3D(nn, src, s, 1.0);
             if (err)
                 return err;
+            mapVoronoi3D(sha, out, src, r.x, r.y, r.z, r.sx, r.sy, r.sz,
+                s.x, s.y, s.z, s.sx, s.sy, s.sz);
         }
-        else
+        else if (siz == 1)
         {
-            src = NULL;
-        }
-
-        int i, j, k;
-        int *p = out;
-        for (k = 0; k < r.sy; k++)
-        {
-            for (j = 0; j < r.sz; j++)
-            {
-                for (i = 0; i < r.sx; i++)
-                {
-                    int x4, z4, y4;
-                    voronoiAccess3D(sha, r.x+i, r.y+k, r.z+j, &x4, &y4, &z4);
-                    if (src)
-                    {
-                        x4 -= s.x; y4 -= s.y; z4 -= s.z;
-                        *p = src[(int64_t)y4*s.sx*s.sz + (int64_t)z4*s.sx + x4];
-                    }
-                    else
-                    {
-                        *p = getNetherBiome(nn, x4, y4, z4, NULL);
-                    }
-                    p++;
-                }
-            }
+            int x4, z4, y4;
+            voronoiAccess3D(sha, r.x, r.y, r.z, &x4, &y4, &z4);
+            *out = getNetherBiome(nn, x4, y4, z4, NULL);
         }
         return 0;
     }
@@ -374,9 +463,15 @@ void setEndSeed(EndNoise *en, int mc, uint64_t seed)
     skipNextN(&s, 17292);
     perlinInit(&en->perlin, &s);
     en->mc = mc;
+    en->seed = seed;
 }
 
-static int getEndBiome(int hx, int hz, const uint16_t *hmap, int hw)
+/* Determines the End biome from the 25x25 elevation neighbourhood at 'hmap'.
+ * The 'hcnt' array holds running counts of islands along the elevation rows,
+ * such that rows without any island in the window can be skipped.
+ */
+static int getEndBiome(int hx, int hz, const uint16_t *hmap,
+    const uint16_t *hcnt, int hw)
 {
     int i, j;
     const uint16_t ds[26] = { // (25-2*i)*(25-2*i)
@@ -388,35 +483,38 @@ static int getEndBiome(int hx, int hz, const uint16_t *hmap, int hw)
 
     const uint16_t *p_dsi = ds + (hx < 0);
     const uint16_t *p_dsj = ds + (hz < 0);
-    const uint16_t *p_elev = hmap;
-    uint32_t h;
+    uint32_t h, hrow[25];
 
     if (abs(hx) <= 15 && abs(hz) <= 15)
         h = 64 * (hx*hx + hz*hz);
     else
         h = 14401;
 
+    // Lane-wise minimum over the rows of the neighbourhood. Cells without an
+    // island have zero elevation and are masked out rather than branched on,
+    // so each row is a plain vectorizable min-reduction.
+    for (i = 0; i < 25; i++)
+        hrow[i] = h;
+
     for (j = 0; j < 25; j++)
     {
-        uint16_t dsj = p_dsj[j];
-        uint16_t e;
-        uint32_t u;
-
-        // force unroll for(i=0;i<25;i++) in a cross compatible way
-        #define x5(i,x)    { x; i++; x; i++; x; i++; x; i++; x; i++; }
-        #define for25(i,x) { i = 0; x5(i,x) x5(i,x) x5(i,x) x5(i,x) x5(i,x) }
-        for25(i,
-            if unlikely(e = p_elev[i])
-            {
-                if ((u = (p_dsi[i] + (uint32_t)dsj) * e) < h)
-                    h = u;
-            }
-        );
-        #undef for25
-        #undef x5
-        p_elev += hw;
+        const uint16_t *p_elev = hmap + (int64_t)j * hw;
+        const uint16_t *p_cnt = hcnt + (int64_t)j * (hw+1);
+        if ((uint16_t)(p_cnt[25] - p_cnt[0]) == 0)
+            continue;
+        uint32_t dsj = p_dsj[j];
+        for (i = 0; i < 25; i++)
+        {
+            uint32_t e = p_elev[i];
+            uint32_t u = (p_dsi[i] + dsj) * e;
+            u |= (uint32_t)0 - (e == 0);
+            hrow[i] = u < hrow[i] ? u : hrow[i];
+        }
     }
 
+    for (i = 0; i < 25; i++)
+        h = hrow[i] < h ? hrow[i] : h;
+
     if (h < 3600)
         return end_highlands;
     else if (h <= 10000)
@@ -427,32 +525,147 @@ static int getEndBiome(int hx, int hz, const uint16_t *hmap, int hw)
     return small_end_islands;
 }
 
-int mapEndBiome(const EndNoise *en, int *out, int x, int z, int w, int h)
+static inline uint16_t getEndElevation(const EndNoise *en, int64_t rx, int64_t rz)
+{
+    uint64_t rsq = rx * rx + rz * rz;
+    uint16_t v = 0;
+    if (rsq > 4096 && sampleSimplex2D(&en->perlin, rx, rz) < -0.9f)
+    {
+        //v = (llabs(rx) * 3439 + llabs(rz) * 147) % 13 + 9;
+        v = (unsigned int)(
+                fabsf((float)rx) * 3439.0f + fabsf((float)rz) * 147.0f
+            ) % 13 + 9;
+        v *= v;
+    }
+    return v;
+}
+
+static void fillEndElevation(const EndNoise *en, uint16_t *hmap, int64_t hw,
+    int64_t x, int64_t z, int w, int h)
 {
     int64_t i, j;
-    int64_t hw = w + 26;
-    int64_t hh = h + 26;
-    uint16_t *hmap = (uint16_t*) malloc(sizeof(*hmap) * hw * hh);
+    for (j = 0; j < h; j++)
+        for (i = 0; i < w; i++)
+            hmap[j*hw+i] = getEndElevation(en, x + i, z + j);
+}
 
-    for (j = 0; j < hh; j++)
+void initEndCache(EndCache *ec)
+{
+    int i;
+    for (i = 0; i < END_CACHE_SLOTS; i++)
     {
-        for (i = 0; i < hw; i++)
+        ec->tiles[i].seq = 0;
+        ec->tiles[i].x = ec->tiles[i].z = 0;
+        ec->tiles[i].seed = 0;
+    }
+}
+
+static EndTile *getEndTileSlot(EndCache *ec, int tx, int tz)
+{
+    uint32_t hash = (uint32_t)tx * 0x9e3779b1 ^ (uint32_t)tz * 0x85ebca77;
+    hash ^= hash >> 16;
+    return &ec->tiles[hash & (END_CACHE_SLOTS-1)];
+}
+
+/* Copies the elevation tile (tx,tz) of the seed from the cache, or generates
+ * it and attempts to publish it. Each slot is guarded by a sequence counter
+ * which is odd while a writer is active, so readers can validate their copy
+ * without taking a lock, and a busy slot simply results in an uncached tile.
+ */
+static void getEndTile(const EndNoise *en, EndCache *ec, uint16_t *tile,
+    int tx, int tz)
+{
+    const size_t tsiz = sizeof(uint16_t) * END_TILE * END_TILE;
+    EndTile *t = getEndTileSlot(ec, tx, tz);
+    uint32_t seq = ATOMIC_LOAD(&t->seq);
+
+    if (seq && !(seq & 1) && t->x == tx && t->z == tz &&
+        t->seed == en->seed)
+    {
+        memcpy(tile, t->elev, tsiz);
+        ATOMIC_FENCE();
+        if (ATOMIC_LOAD(&t->seq) == seq)
+            return;
+    }
+
+    fillEndElevation(en, tile, END_TILE,
+        (int64_t)tx * END_TILE, (int64_t)tz * END_TILE, END_TILE, END_TILE);
+
+    seq = ATOMIC_LOAD(&t->seq);
+    if (!(seq & 1) && ATOMIC_CAS(&t->seq, seq, seq+1))
+    {
+        t->x = tx;
+        t->z = tz;
+        t->seed = en->seed;
+        memcpy(t->elev, tile, tsiz);
+        ATOMIC_STORE(&t->seq, seq+2);
+    }
+}
+
+size_t getEndScratchSize(int w, int h)
+{   // elevation map and its running row counts
+    return (size_t)(w + 26) * (h + 26) + (size_t)(w + 27) * (h + 26);
+}
+
+/* Fills the island elevation map of (w x h) cells at (x0,z0), from the cached
+ * tiles if a cache is given.
+ */
+static void getEndElevationMap(const EndNoise *en, EndCache *ec, uint16_t *hmap,
+    int64_t x0, int64_t z0, int64_t hw, int64_t hh)
+{
+    int64_t j;
+    if (!ec)
+    {
+        fillEndElevation(en, hmap, hw, x0, z0, hw, hh);
+        return;
+    }
+
+    // assemble the elevation map from the overlapping cached tiles
+    uint16_t tile[END_TILE * END_TILE];
+    int tx0 = floordiv(x0, END_TILE), tx1 = floordiv(x0 + hw-1, END_TILE);
+    int tz0 = floordiv(z0, END_TILE), tz1 = floordiv(z0 + hh-1, END_TILE);
+    int tx, tz;
+    for (tz = tz0; tz <= tz1; tz++)
+    {
+        for (tx = tx0; tx <= tx1; tx++)
         {
-            int64_t rx = x + i - 12;
-            int64_t rz = z + j - 12;
-            uint64_t rsq = rx * rx + rz * rz;
-            uint16_t v = 0;
-            if (rsq > 4096 && sampleSimplex2D(&en->perlin, rx, rz) < -0.9f)
+            int64_t bx = (int64_t)tx * END_TILE, bz = (int64_t)tz * END_TILE;
+            int64_t ia = bx > x0 ? bx - x0 : 0;
+            int64_t ib = bx + END_TILE < x0 + hw ? bx + END_TILE - x0 : hw;
+            int64_t ja = bz > z0 ? bz - z0 : 0;
+            int64_t jb = bz + END_TILE < z0 + hh ? bz + END_TILE - z0 : hh;
+            getEndTile(en, ec, tile, tx, tz);
+            for (j = ja; j < jb; j++)
             {
-                //v = (llabs(rx) * 3439 + llabs(rz) * 147) % 13 + 9;
-                v = (unsigned int)(
-                        fabsf((float)rx) * 3439.0f + fabsf((float)rz) * 147.0f
-                    ) % 13 + 9;
-                v *= v;
+                memcpy(hmap + j*hw + ia,
+                    tile + (z0 + j - bz) * END_TILE + (x0 + ia - bx),
+                    sizeof(*hmap) * (ib - ia));
             }
-            hmap[(int64_t)j*hw+i] = v;
         }
     }
+}
+
+int mapEndBiomeCached(const EndNoise *en, EndCache *ec, int *out,
+    int x, int z, int w, int h, uint16_t *scratch)
+{
+    int64_t i, j;
+    int64_t hw = w + 26;
+    int64_t hh = h + 26;
+    uint16_t *hmap = scratch;
+    if (!hmap)
+        hmap = (uint16_t*) malloc(sizeof(*hmap) * getEndScratchSize(w, h));
+
+    getEndElevationMap(en, ec, hmap, x - 12, z - 12, hw, hh);
+
+    // the counts only need to be exact modulo 2^16 for windows of 25 cells
+    uint16_t *hcnt = hmap + hw * hh;
+    for (j = 0; j < hh; j++)
+    {
+        uint16_t c = 0, *p = hcnt + j * (hw+1);
+        p[0] = 0;
+        for (i = 0; i < hw; i++)
+            p[i+1] = c += (hmap[j*hw+i] != 0);
+    }
 
     for (j = 0; j < h; j++)
     {
@@ -477,16 +690,23 @@ int mapEndBiome(const EndNoise *en, int *out, int x, int z, int w, int h)
                         continue;
                     }
                 }
-                uint16_t *p_elev = &hmap[(hz/2-z)*hw + (hx/2-x)];
-                out[j*w+i] = getEndBiome(hx, hz, p_elev, hw);
+                int64_t ei = hx/2-x, ej = hz/2-z;
+                out[j*w+i] = getEndBiome(hx, hz, hmap + ej*hw + ei,
+                    hcnt + ej*(hw+1) + ei, hw);
             }
         }
     }
 
-    free(hmap);
+    if (hmap != scratch)
+        free(hmap);
     return 0;
 }
 
+int mapEndBiome(const EndNoise *en, int *out, int x, int z, int w, int h)
+{
+    return mapEndBiomeCached(en, NULL, out, x, z, w, h, NULL);
+}
+
 int mapEnd(const EndNoise *en, int *out, int x, int z, int w, int h)
 {
     int cx = x >> 2;
@@ -560,60 +780,177 @@ float getEndHeightNoise(const EndNoise *en, int x, int z, int range)
     return ret;
 }
 
-void sampleNoiseColumnEnd(double column[],
-    const SurfaceNoise *sn, const EndNoise *en, int x, int z,
-    int colymin, int colymax)
+// clamped (32 + 46 - y) / 64.0
+static const double g_end_upper_drop[] = {
+       1.0,    1.0,    1.0,    1.0,    1.0,    1.0,    1.0,    1.0, // 0-7
+       1.0,    1.0,    1.0,    1.0,    1.0,    1.0,    1.0, 63./64, // 8-15
+    62./64, 61./64, 60./64, 59./64, 58./64, 57./64, 56./64, 55./64, // 16-23
+    54./64, 53./64, 52./64, 51./64, 50./64, 49./64, 48./64, 47./64, // 24-31
+    46./64 // 32
+};
+// clamped (y - 1) / 7.0
+static const double g_end_lower_drop[] = {
+      0.0,  0.0, 1./7, 2./7, 3./7, 4./7, 5./7, 6./7, // 0-7
+      1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0, // 8-15
+      1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0, // 16-23
+      1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0, // 24-31
+      1.0, // 32
+};
+
+// depth is between [-108, +72]
+// noise is between [-128, +128]
+// for a sold block we need the upper drop as:
+//  (72 + 128) * u - 3000 * (1-u) > 0 => upper_drop = u < 15/16
+// which occurs at y = 18 for the highest relevant noise cell
+// for the lower drop we need:
+//  (72 + 128) * l - 30 * (1-l) > 0 => lower_drop = l > 3/23
+// which occurs at y = 3 for the lowest relevant noise cell
+static double sampleEndDensity(const SurfaceNoise *sn, int x, int y, int z,
+    double depth)
 {
-    // clamped (32 + 46 - y) / 64.0
-    static const double upper_drop[] = {
-           1.0,    1.0,    1.0,    1.0,    1.0,    1.0,    1.0,    1.0, // 0-7
-           1.0,    1.0,    1.0,    1.0,    1.0,    1.0,    1.0, 63./64, // 8-15
-        62./64, 61./64, 60./64, 59./64, 58./64, 57./64, 56./64, 55./64, // 16-23
-        54./64, 53./64, 52./64, 51./64, 50./64, 49./64, 48./64, 47./64, // 24-31
-        46./64 // 32
-    };
-    // clamped (y - 1) / 7.0
-    static const double lower_drop[] = {
-          0.0,  0.0, 1./7, 2./7, 3./7, 4./7, 5./7, 6./7, // 0-7
-          1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0, // 8-15
-          1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0, // 16-23
-          1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0, // 24-31
-          1.0, // 32
-    };
+    if (g_end_lower_drop[y] == 0.0)
+        return -30;
+    double noise = sampleSurfaceNoiseBetween(sn, x, y, z, -128, +128);
+    double clamped = noise + depth;
+    clamped = lerp(g_end_upper_drop[y], -3000, clamped);
+    clamped = lerp(g_end_lower_drop[y], -30, clamped);
+    return clamped;
+}
 
-    int y;
+static int isEndRingColumn(const EndNoise *en, int x, int z)
+{
     if (en->mc > MC_1_13)
-    {   // add outer end rings
+    {   // outer end rings
         uint64_t rsq = (uint64_t) x * x + (uint64_t) z * z;
         if ((int)rsq < 0)
+            return 1;
+    }
+    return 0;
+}
+
+void sampleNoiseColumnEnd(double column[],
+    const SurfaceNoise *sn, const EndNoise *en, int x, int z,
+    int colymin, int colymax)
+{
+    int y;
+    if (isEndRingColumn(en, x, z))
+    {
+        for (y = colymin; y <= colymax; y++)
+            column[y - colymin] = nan("");
+        return;
+    }
+
+    double depth = getEndHeightNoise(en, x, z, 0) - 8.0f;
+    for (y = colymin; y <= colymax; y++)
+        column[y - colymin] = sampleEndDensity(sn, x, y, z, depth);
+}
+
+void initEndTerrain(EndTerrain *et, const EndNoise *en, const SurfaceNoise *sn,
+    EndCache *ec)
+{
+    int i;
+    et->sn = sn;
+    et->en = en;
+    et->ec = ec;
+    et->ex = et->ez = INT_MIN;
+    for (i = 0; i < END_COL_GRID * END_COL_GRID; i++)
+    {
+        et->cols[i].x = et->cols[i].z = INT_MIN;
+        et->cols[i].mask = 0;
+    }
+}
+
+/* Equivalent to getEndHeightNoise(en, x, z, 0) - 8, but reads the island
+ * elevations from the window of the terrain context, which is moved (and
+ * refilled) when the 25x25 elevations around the cell are not inside it.
+ */
+static double getEndDepthWindow(EndTerrain *et, int x, int z)
+{
+    enum { R = 12 };
+    int hx = x / 2;
+    int hz = z / 2;
+    int oddx = x % 2;
+    int oddz = z % 2;
+    int i, j;
+
+    if (et->ex == INT_MIN ||
+        hx - R < et->ex || hx + R >= et->ex + END_ELEV_W ||
+        hz - R < et->ez || hz + R >= et->ez + END_ELEV_W)
+    {
+        et->ex = hx - END_ELEV_W / 2;
+        et->ez = hz - END_ELEV_W / 2;
+        getEndElevationMap(et->en, et->ec, et->elev, et->ex, et->ez,
+            END_ELEV_W, END_ELEV_W);
+    }
+
+    int64_t h = 64 * (x*(int64_t)x + z*(int64_t)z);
+    for (j = -R; j <= R; j++)
+    {
+        const uint16_t *row = et->elev + (hz + j - et->ez) * END_ELEV_W;
+        for (i = -R; i <= R; i++)
         {
-            for (y = colymin; y <= colymax; y++)
-                column[y - colymin] = nan("");
-            return;
+            uint16_t v = row[hx + i - et->ex]; // squared elevation
+            if (v == 0)
+                continue;
+            int64_t rx = (oddx - i * 2);
+            int64_t rz = (oddz - j * 2);
+            int64_t noise = (rx*rx + rz*rz) * v;
+            if (noise < h)
+                h = noise;
         }
     }
 
-    // depth is between [-108, +72]
-    // noise is between [-128, +128]
-    // for a sold block we need the upper drop as:
-    //  (72 + 128) * u - 3000 * (1-u) > 0 => upper_drop = u < 15/16
-    // which occurs at y = 18 for the highest relevant noise cell
-    // for the lower drop we need:
-    //  (72 + 128) * l - 30 * (1-l) > 0 => lower_drop = l > 3/23
-    // which occurs at y = 3 for the lowest relevant noise cell
+    float ret = 100 - sqrtf((float) h);
+    if (ret < -100) ret = -100;
+    if (ret > 80) ret = 80;
+    return ret - 8.0f;
+}
 
-    double depth = getEndHeightNoise(en, x, z, 0) - 8.0f;
+static EndColumn *getEndColumn(EndTerrain *et, int x, int z)
+{
+    int i = (z & (END_COL_GRID-1)) * END_COL_GRID + (x & (END_COL_GRID-1));
+    EndColumn *c = &et->cols[i];
+    if (c->x != x || c->z != z)
+    {
+        c->x = x;
+        c->z = z;
+        c->mask = 0;
+        c->depth = getEndDepthWindow(et, x, z);
+    }
+    return c;
+}
+
+double getEndDepthCached(EndTerrain *et, int x, int z)
+{
+    return getEndColumn(et, x, z)->depth;
+}
+
+void sampleNoiseColumnEndCached(double column[], EndTerrain *et, int x, int z,
+    int colymin, int colymax)
+{
+    int y;
+    if (isEndRingColumn(et->en, x, z))
+    {
+        for (y = colymin; y <= colymax; y++)
+            column[y - colymin] = nan("");
+        return;
+    }
+
+    EndColumn *c = getEndColumn(et, x, z);
     for (y = colymin; y <= colymax; y++)
     {
-        if (lower_drop[y] == 0.0) {
-            column[y - colymin] = -30;
+        if (y < END_COL_Y0 || y > END_COL_Y1)
+        {
+            column[y - colymin] = sampleEndDensity(et->sn, x, y, z, c->depth);
             continue;
         }
-        double noise = sampleSurfaceNoiseBetween(sn, x, y, z, -128, +128);
-        double clamped = noise + depth;
-        clamped = lerp(upper_drop[y], -3000, clamped);
-        clamped = lerp(lower_drop[y], -30, clamped);
-        column[y - colymin] = clamped;
+        uint32_t b = 1u << (y - END_COL_Y0);
+        if (!(c->mask & b))
+        {
+            c->v[y - END_COL_Y0] = sampleEndDensity(et->sn, x, y, z, c->depth);
+            c->mask |= b;
+        }
+        column[y - colymin] = c->v[y - END_COL_Y0];
     }
 }
 
@@ -680,7 +1017,17 @@ int getEndSurfaceHeight(int mc, uint64_t seed, int x, int z)
     return getSurfaceHeight(ncol00, ncol01, ncol10, ncol11, y0, y1, 4, dx, dz);
 }
 
-int mapEndSurfaceHeight(float *y, const EndNoise *en, const SurfaceNoise *sn,
+void sampleEndColumn(double column[], EndTerrain *et,
+    const SurfaceNoise *sn, const EndNoise *en, int x, int z, int y0, int y1)
+{
+    if (et)
+        sampleNoiseColumnEndCached(column, et, x, z, y0, y1);
+    else
+        sampleNoiseColumnEnd(column, sn, en, x, z, y0, y1);
+}
+
+static int mapEndSurfaceHeightImpl(float *y, const EndNoise *en,
+    const SurfaceNoise *sn, EndTerrain *et,
     int x, int z, int w, int h, int scale, int ymin)
 {
     if (scale != 1 && scale != 2 && scale != 4 && scale != 8)
@@ -704,7 +1051,7 @@ int mapEndSurfaceHeight(float *y, const EndNoise *en, const SurfaceNoise *sn,
     ncol[1] = buf + yn * cw;
 
     for (i = 0; i < cw; i++)
-        sampleNoiseColumnEnd(ncol[1]+i*yn, sn, en, cx+i, cz+0, y0, y1);
+        sampleEndColumn(ncol[1]+i*yn, et, sn, en, cx+i, cz+0, y0, y1);
 
     for (j = 0; j < h; j++)
     {
@@ -716,7 +1063,7 @@ int mapEndSurfaceHeight(float *y, const EndNoise *en, const SurfaceNoise *sn,
             ncol[0] = ncol[1];
             ncol[1] = tmp;
             for (i = 0; i < cw; i++)
-                sampleNoiseColumnEnd(ncol[1]+i*yn, sn, en, cx+i, cj+1, y0, y1);
+                sampleEndColumn(ncol[1]+i*yn, et, sn, en, cx+i, cj+1, y0, y1);
         }
 
         for (i = 0; i < w; i++)
@@ -736,6 +1083,193 @@ int mapEndSurfaceHeight(float *y, const EndNoise *en, const SurfaceNoise *sn,
     return 0;
 }
 
+int mapEndSurfaceHeight(float *y, const EndNoise *en, const SurfaceNoise *sn,
+    int x, int z, int w, int h, int scale, int ymin)
+{
+    return mapEndSurfaceHeightImpl(y, en, sn, NULL, x, z, w, h, scale, ymin);
+}
+
+int mapEndSurfaceHeightCached(float *y, EndTerrain *et,
+    int x, int z, int w, int h, int scale, int ymin)
+{
+    return mapEndSurfaceHeightImpl(y, et->en, et->sn, et,
+        x, z, w, h, scale, ymin);
+}
+
+// The terrain factor of the 1.18+ Overworld is given by a spline that is not
+// modelled here, so a typical value is assumed for the density gradient.
+static const double g_ow_factor = 4.0;
+
+/* Height at which the depth of the 1.18+ Overworld crosses zero, i.e. the
+ * surface without the 3D noise. The depth at y = 0 is 1 - 83/160 + 0.015 +
+ * spline = 0.49625 + spline, so the surface is at 128 * (0.49625 + spline).
+ */
+static double getDepthSurface118(const BiomeNoise *bn, int x, int z, int *id)
+{
+    int64_t np[NP_MAX];
+    double d;
+    if (bn->nptype == NP_DEPTH)
+    {
+        d = sampleBiomeNoise(bn, NULL, x, 0, z, NULL, 0) / 10000.0;
+        if (id) *id = none;
+    }
+    else
+    {
+        uint32_t flags = id ? 0 : SAMPLE_NO_BIOME;
+        int v = sampleBiomeNoise(bn, np, x, 0, z, NULL, flags);
+        if (id) *id = v;
+        d = np[NP_DEPTH] / 10000.0;
+    }
+    return 128.0 * d;
+}
+
+void sampleNoiseColumn118(double column[], const SurfaceNoise *sn,
+    double ydepth, int cellx, int cellz, int colymin, int colymax)
+{
+    const double f = g_ow_factor;
+    int y;
+    for (y = colymin; y <= colymax; y++)
+    {
+        // the depth term in units of the blended noise, [-128, +128], which
+        // is sampled within one cell of where it can change the sign
+        double v = f * (ydepth - 8 * y);
+        if (v > 0)
+            v *= 4; // quarter negative
+        if (v > -128 - 8*f && v < 128 + 32*f)
+            v += sampleSurfaceNoiseBetween(sn, cellx, y, cellz, -128, +128);
+        column[y - colymin] = v;
+    }
+}
+
+// Fractional height where the interpolated density of the columns drops
+// below zero for the last time, searching down from the top.
+static double getSurfaceCrossing(
+        const double ncol00[], const double ncol01[],
+        const double ncol10[], const double ncol11[],
+        int colymin, int colymax, int blockspercell, double dx, double dz)
+{
+    int celly = colymax, idx = colymax - colymin;
+    double v1 = lerp2(dx, dz,
+        ncol00[idx], ncol10[idx], ncol01[idx], ncol11[idx]);
+    if (v1 > 0)
+        return colymax * blockspercell;
+    for (celly = colymax-1; celly >= colymin; celly--)
+    {
+        idx = celly - colymin;
+        double v0 = lerp2(dx, dz,
+            ncol00[idx], ncol10[idx], ncol01[idx], ncol11[idx]);
+        if (v0 > 0)
+            return (celly + v0 / (v0 - v1)) * blockspercell;
+        v1 = v0;
+    }
+    return colymin * blockspercell;
+}
+
+// initSurfaceNoise118() leaves the surface and depth octaves of the legacy
+// Overworld unset and uses unit scales, which initSurfaceNoise() does not.
+int isSurfaceNoise118(const SurfaceNoise *sn)
+{
+    return sn->xzScale == 1.0 && sn->yScale == 1.0 &&
+        sn->octsurf.octcnt == 0 && sn->octdepth.octcnt == 0;
+}
+
+int mapSurfaceHeight118(float *y, int *ids, const BiomeNoise *bn,
+    const SurfaceNoise *sn, int x, int z, int w, int h, int coarse)
+{
+    const double f = g_ow_factor;
+    int cw = w + 1, ch = h + 1; // the outputs are between the columns
+    int i, j, k;
+    double dmin = DBL_MAX, dmax = -DBL_MAX;
+
+    if (!isSurfaceNoise118(sn))
+        return 1;
+    double *ydepth = (double*) malloc(sizeof(double) * cw * ch);
+    if (!ydepth)
+        return -1;
+
+    for (j = 0; j < ch; j++)
+    {
+        for (i = 0; i < cw; i++)
+        {
+            int id, *pid = (ids && i < w && j < h) ? &id : NULL;
+            double d = getDepthSurface118(bn, x+i, z+j, pid);
+            if (pid)
+                ids[j*w+i] = id;
+            ydepth[j*cw+i] = d;
+            if (d < dmin) dmin = d;
+            if (d > dmax) dmax = d;
+        }
+    }
+
+    if (coarse)
+    {   // a single noise sample near the depth surface of each column
+        for (k = 0; k < cw * ch; k++)
+        {
+            int celly = (int) floor(ydepth[k] / 8 + 0.5);
+            if (celly < -8) celly = -8;
+            if (celly > 40) celly = 40;
+            double n = sampleSurfaceNoiseBetween(sn, x + k % cw, celly,
+                z + k / cw, -128, +128);
+            ydepth[k] += n > 0 ? n / f : n / (4*f);
+        }
+        for (j = 0; j < h; j++)
+        {
+            for (i = 0; i < w; i++)
+            {
+                const double *d = ydepth + j*cw + i;
+                y[j*w+i] = 0.25 * (d[0] + d[1] + d[cw] + d[cw+1]);
+            }
+        }
+        free(ydepth);
+        return 0;
+    }
+
+    // the surface is within the range where the noise can change the sign
+    // of the density, on a cell grid of 4 blocks wide and 8 blocks high
+    int y0 = (int) floor((dmin - 128 / (4*f)) / 8) - 1;
+    int y1 = (int) ceil((dmax + 128 / f) / 8) + 1;
+    if (y0 < -8) y0 = -8;
+    if (y1 > 40) y1 = 40;
+    if (y1 <= y0) y1 = y0 + 1;
+    int yn = y1 - y0 + 1;
+
+    double *buf = (double*) malloc(sizeof(double) * yn * cw * 2);
+    double *ncol[2];
+    if (!buf)
+    {
+        free(ydepth);
+        return -1;
+    }
+    ncol[0] = buf;
+    ncol[1] = buf + yn * cw;
+
+    for (i = 0; i < cw; i++)
+        sampleNoiseColumn118(ncol[1]+i*yn, sn, ydepth[i], x+i, z, y0, y1);
+
+    for (j = 0; j < h; j++)
+    {
+        double *tmp = ncol[0];
+        ncol[0] = ncol[1];
+        ncol[1] = tmp;
+        for (i = 0; i < cw; i++)
+        {
+            sampleNoiseColumn118(ncol[1]+i*yn, sn, ydepth[(j+1)*cw+i],
+                x+i, z+j+1, y0, y1);
+        }
+        for (i = 0; i < w; i++)
+        {
+            double *ncol0 = ncol[0] + i * yn;
+            double *ncol1 = ncol[1] + i * yn;
+            y[j*w+i] = getSurfaceCrossing(ncol0, ncol1, ncol0+yn, ncol1+yn,
+                y0, y1, 8, 0.5, 0.5);
+        }
+    }
+
+    free(buf);
+    free(ydepth);
+    return 0;
+}
+
 int genEndScaled(const EndNoise *en, int *out, Range r, int mc, uint64_t sha)
 {
     if (mc < MC_1_0)
@@ -1591,43 +2125,22 @@ int genBiomeNoiseScaled(const BiomeNoise *bn, int *out, Range r, uint64_t sha)
         r.sy = 1;
 
     uint64_t siz = (uint64_t)r.sx*r.sy*r.sz;
-    int i, j, k;
 
     if (r.scale == 1)
     {
         Range s = getVoronoiSrcRange(r);
-        int *src;
         if (siz > 1)
         {   // the source range is large enough that we can try optimizing
-            src = out + siz;
+            int *src = out + siz;
             genBiomeNoise3D(bn, src, s, 0);
+            mapVoronoi3D(sha, out, src, r.x, r.y, r.z, r.sx, r.sy, r.sz,
+                s.x, s.y, s.z, s.sx, s.sy, s.sz);
         }
         else
         {
-            src = NULL;
-        }
-
-        int *p = out;
-        for (k = 0; k < r.sy; k++)
-        {
-            for (j = 0; j < r.sz; j++)
-            {
-                for (i = 0; i < r.sx; i++)
-                {
-                    int x4, z4, y4;
-                    voronoiAccess3D(sha, r.x+i, r.y+k, r.z+j, &x4, &y4, &z4);
-                    if (src)
-                    {
-                        x4 -= s.x; y4 -= s.y; z4 -= s.z;
-                        *p = src[(int64_t)y4*s.sx*s.sz + (int64_t)z4*s.sx + x4];
-                    }
-                    else
-                    {
-                        *p = sampleBiomeNoise(bn, 0, x4, y4, z4, 0, 0);
-                    }
-                    p++;
-                }
-            }
+            int x4, z4, y4;
+            voronoiAccess3D(sha, r.x, r.y, r.z, &x4, &y4, &z4);
+            *out = sampleBiomeNoise(bn, 0, x4, y4, z4, 0, 0);
         }
     }
     else
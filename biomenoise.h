@@ -60,6 +60,21 @@ STRUCT(EndNoise)
 {
     PerlinNoise perlin;
     int mc;
+    uint64_t seed;
+};
+
+// Cache of End island elevation tiles that can be shared between threads
+enum { END_TILE = 32, END_CACHE_SLOTS = 256 };
+STRUCT(EndTile)
+{
+    volatile uint32_t seq; // odd while being written, zero when empty
+    int x, z;
+    uint64_t seed;
+    uint16_t elev[END_TILE * END_TILE];
+};
+STRUCT(EndCache)
+{
+    EndTile tiles[END_CACHE_SLOTS];
 };
 
 STRUCT(SurfaceNoise)
@@ -74,6 +89,29 @@ STRUCT(SurfaceNoise)
     PerlinNoise oct[16+16+8+4+16];
 };
 
+// Cache of End terrain noise columns by cell, for use by a single thread
+enum {
+    END_COL_GRID = 32,  // columns are kept on a grid of this many cells
+    END_COL_Y0 = 2, END_COL_Y1 = 18, // cell heights that can hold terrain
+    END_ELEV_W = 48,    // width of the local island elevation window
+};
+STRUCT(EndColumn)
+{
+    int x, z;       // cell coordinates, x is INT_MIN when empty
+    uint32_t mask;  // sampled cell heights, bit (y - END_COL_Y0)
+    double depth;
+    double v[END_COL_Y1 - END_COL_Y0 + 1];
+};
+STRUCT(EndTerrain)
+{
+    const SurfaceNoise *sn;
+    const EndNoise *en;
+    EndCache *ec;   // optional shared elevation cache
+    int ex, ez;     // origin of the elevation window, ex is INT_MIN if unset
+    uint16_t elev[END_ELEV_W * END_ELEV_W];
+    EndColumn cols[END_COL_GRID * END_COL_GRID];
+};
+
 STRUCT(SurfaceNoiseBeta)
 {
     OctaveNoise octmin;
@@ -164,6 +202,8 @@ extern "C"
 //==============================================================================
 
 void initSurfaceNoise(SurfaceNoise *sn, int dim, uint64_t seed);
+void initSurfaceNoise118(SurfaceNoise *sn, uint64_t seed);
+int isSurfaceNoise118(const SurfaceNoise *sn);
 void initSurfaceNoiseBeta(SurfaceNoiseBeta *snb, uint64_t seed);
 double sampleSurfaceNoise(const SurfaceNoise *sn, int x, int y, int z);
 double sampleSurfaceNoiseBetween(const SurfaceNoise *sn, int x, int y, int z,
@@ -214,10 +254,77 @@ int genNetherScaled(const NetherNoise *nn, int *out, Range r, int mc, uint64_t s
  */
 void setEndSeed(EndNoise *en, int mc, uint64_t seed);
 int mapEndBiome(const EndNoise *en, int *out, int x, int z, int w, int h);
+/**
+ * The island elevation map that mapEndBiome() needs extends 13 cells beyond
+ * the area, so adjacent areas recompute most of their borders. An EndCache
+ * keeps generated elevation tiles and can be shared by any number of threads
+ * (the cache is lock-free; a contended tile is just regenerated). The tiles
+ * are keyed by the seed of the EndNoise, so the cache can be used with any
+ * seed without reinitialization: another seed never reads stale elevations,
+ * and its tiles replace the old ones as they are generated.
+ * Without real atomics (see ATOMIC_SAFE) the cache must not be shared between
+ * threads. The cache is large (~0.5MB) and should be allocated on the heap.
+ *
+ * mapEndBiomeCached() is equivalent to mapEndBiome(), with an optional cache
+ * (nullable) and an optional scratch buffer of getEndScratchSize() elements
+ * that avoids the allocation (nullable).
+ */
+void initEndCache(EndCache *ec);
+size_t getEndScratchSize(int w, int h);
+int mapEndBiomeCached(const EndNoise *en, EndCache *ec, int *out,
+    int x, int z, int w, int h, uint16_t *scratch);
 int mapEnd(const EndNoise *en, int *out, int x, int z, int w, int h);
 int getEndSurfaceHeight(int mc, uint64_t seed, int x, int z);
 int mapEndSurfaceHeight(float *y, const EndNoise *en, const SurfaceNoise *sn,
     int x, int z, int w, int h, int scale, int ymin);
+/**
+ * Repeated End terrain queries in the same region sample many of the same
+ * noise columns (one per 8x8 block cell). An EndTerrain keeps the columns it
+ * has sampled, as well as a window of the island elevations that the column
+ * depths are derived from, and can be reused for any number of queries with
+ * the same EndNoise and SurfaceNoise (initialized with initSurfaceNoise() for
+ * DIM_END). The optional EndCache (nullable) supplies the island elevations
+ * and can be shared, but the EndTerrain itself is for use by one thread only.
+ * Reinitialize it when the seed changes. The context is large (~160kB) and
+ * should be allocated on the heap.
+ *
+ * sampleNoiseColumnEndCached() and mapEndSurfaceHeightCached() yield the same
+ * results as their uncached variants, while getEndDepthCached() is equivalent
+ * to getEndHeightNoise(en, x, z, 0) - 8. sampleEndColumn() samples a column
+ * from the EndTerrain if one is given (nullable), or from 'sn' and 'en'.
+ */
+void initEndTerrain(EndTerrain *et, const EndNoise *en, const SurfaceNoise *sn,
+    EndCache *ec);
+double getEndDepthCached(EndTerrain *et, int x, int z);
+void sampleNoiseColumnEndCached(double column[], EndTerrain *et, int x, int z,
+    int colymin, int colymax);
+void sampleEndColumn(double column[], EndTerrain *et, const SurfaceNoise *sn,
+    const EndNoise *en, int x, int z, int colymin, int colymax);
+int mapEndSurfaceHeightCached(float *y, EndTerrain *et,
+    int x, int z, int w, int h, int scale, int ymin);
+
+/**
+ * Approximate terrain of the 1.18+ Overworld, for a SurfaceNoise initialized
+ * with initSurfaceNoise118(). The density is modelled from the depth (given by
+ * the climate spline offset) and the blended 3D noise, with a typical terrain
+ * factor; jaggedness, caves and aquifers are not considered.
+ *
+ * sampleNoiseColumn118() samples the density of the noise cell column at
+ * (cellx, cellz), which are 4 blocks wide, for the cell heights of 8 blocks in
+ * [colymin, colymax], where 'ydepth' is the surface height of the depth alone.
+ *
+ * mapSurfaceHeight118() maps the approximate surface height at scale 1:4,
+ * measured at the cell centers. The density columns are shared between the
+ * neighbouring cells within the one call (nothing is cached between calls).
+ * With 'coarse' set, the noise is only sampled once per column, near the depth
+ * surface, which is several times faster. If non-null, the 'ids' are filled
+ * with the biomes at y = 0. Returns 1 if 'sn' was not initialized with
+ * initSurfaceNoise118() and -1 if the buffers could not be allocated.
+ */
+void sampleNoiseColumn118(double column[], const SurfaceNoise *sn,
+    double ydepth, int cellx, int cellz, int colymin, int colymax);
+int mapSurfaceHeight118(float *y, int *ids, const BiomeNoise *bn,
+    const SurfaceNoise *sn, int x, int z, int w, int h, int coarse);
 
 /**
  * The scaled End generation supports scales 1, 4, 16, and 64.
@@ -1,5 +1,6 @@
 #include "finders.h"
 #include "biomes.h"
+#include "util.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -385,6 +386,177 @@ int getMineshafts(int mc, uint64_t seed, int cx0, int cz0, int cx1, int cz1,
     return n;
 }
 
+// chunks are evaluated in groups of lanes with independent generator states
+enum { CHUNK_LANES = 8 };
+
+static inline void setChunkBit(uint8_t *bits, size_t idx)
+{
+    bits[idx >> 3] |= (uint8_t)(1 << (idx & 7));
+}
+
+int mapMineshaftChunks(uint8_t *bits, int mc, uint64_t seed,
+        int chunkX, int chunkZ, int chunkW, int chunkH)
+{
+    const uint64_t mask = (1ULL << 48) - 1;
+    // nextDouble() < 0.004 as a bound on the 53-bit integer of the double,
+    // of which the first 26 bits come from the first step
+    const uint64_t thresh = (uint64_t) ceil(0.004 * (double)(1ULL << 53));
+    const uint64_t thresh26 = thresh >> 27;
+    uint64_t s;
+    setSeed(&s, seed);
+    uint64_t a = nextLong(&s);
+    uint64_t b = nextLong(&s);
+    int i, j, k, n = 0;
+
+    memset(bits, 0, ((size_t)chunkW * chunkH + 7) / 8);
+
+    for (j = 0; j < chunkH; j++)
+    {
+        uint64_t bz = (uint64_t)(chunkZ + j) * b ^ seed;
+        for (i = 0; i < chunkW; i += CHUNK_LANES)
+        {
+            uint64_t st[CHUNK_LANES];
+            int hit = 0;
+            for (k = 0; k < CHUNK_LANES; k++)
+            {
+                uint64_t v = (uint64_t)(chunkX + i + k) * a ^ bz;
+                v = (v ^ 0x5deece66d) & mask;
+                if (mc < MC_1_13)
+                    v = (v * 0x5deece66d + 0xb) & mask;
+                st[k] = (v * 0x5deece66d + 0xb) & mask;
+                hit |= (st[k] >> 22) <= thresh26;
+            }
+            if likely(!hit)
+                continue;
+
+            for (k = 0; k < CHUNK_LANES && i + k < chunkW; k++)
+            {
+                if ((st[k] >> 22) > thresh26)
+                    continue;
+                int x = chunkX + i + k, z = chunkZ + j;
+                if (getMineshafts(mc, seed, x, z, x, z, NULL, 0))
+                {
+                    setChunkBit(bits, (size_t)j * chunkW + i + k);
+                    n++;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+int mapSlimeChunks(uint8_t *bits, uint64_t seed,
+        int chunkX, int chunkZ, int chunkW, int chunkH)
+{
+    const uint64_t mask = (1ULL << 48) - 1;
+    uint64_t *xs = (uint64_t*) malloc(sizeof(uint64_t) * chunkW);
+    int i, j, n = 0;
+    if (!xs)
+        return -1;
+
+    memset(bits, 0, ((size_t)chunkW * chunkH + 7) / 8);
+
+    // the seed terms of each axis, as in isSlimeChunk()
+    for (i = 0; i < chunkW; i++)
+    {
+        uint32_t x = (uint32_t)(chunkX + i);
+        xs[i] = (uint64_t)(int64_t)(int32_t)(x * 0x5ac0db);
+        xs[i] += (uint64_t)(int64_t)(int32_t)(x * x * 0x4c1906);
+    }
+
+    for (j = 0; j < chunkH; j++)
+    {
+        uint32_t z = (uint32_t)(chunkZ + j);
+        uint64_t zs = seed;
+        zs += (uint64_t)(int64_t)(int32_t)(z * 0x5f24f);
+        zs += (uint64_t)(int64_t)(int32_t)(z * z) * 0x4307a7ULL;
+        size_t idx = (size_t)j * chunkW;
+
+        for (i = 0; i < chunkW; i++, idx++)
+        {
+            uint64_t v = ((zs + xs[i]) ^ 0x3ad8025fULL ^ 0x5deece66d) & mask;
+            v = (v * 0x5deece66d + 0xb) & mask;
+            int r = (int)(v >> 17);
+            int hit = r % 10 == 0;
+            if unlikely(r >= 2147483640) // rejected by nextInt(10)
+                hit = isSlimeChunk(seed, chunkX+i, chunkZ+j);
+            bits[idx >> 3] |= (uint8_t)(hit << (idx & 7));
+            n += hit;
+        }
+    }
+
+    free(xs);
+    return n;
+}
+
+int getBestSlimeChunk(uint64_t seed, int chunkX, int chunkZ,
+        int chunkW, int chunkH, int radius, Pos *best)
+{
+    int r = radius;
+    int w = chunkW + 2*r, h = chunkH + 2*r;
+    uint8_t *bits = (uint8_t*) malloc(((size_t)w * h + 7) / 8);
+    int *hw = (int*) malloc(sizeof(int) * (2*r+1)); // half widths of the disk
+    int i, j, k;
+    int bestcnt = -1;
+    if (!bits || !hw)
+    {
+        free(bits);
+        free(hw);
+        return -1;
+    }
+
+    for (k = -r; k <= r; k++)
+    {
+        int d = (int) floor(sqrt((double)(r*r - k*k)));
+        while ((d+1)*(d+1) + k*k <= r*r) d++;
+        while (d*d + k*k > r*r) d--;
+        hw[k+r] = d;
+    }
+
+    if (mapSlimeChunks(bits, seed, chunkX - r, chunkZ - r, w, h) < 0)
+    {
+        free(bits);
+        free(hw);
+        return -1;
+    }
+
+#define SLIME_BIT(X,Z) ((bits[((size_t)(Z)*w + (X)) >> 3] >> (((size_t)(Z)*w + (X)) & 7)) & 1)
+    for (j = 0; j < chunkH; j++)
+    {
+        int cnt = 0;
+        // count the disk at the start of the row, then slide it along x
+        for (k = -r; k <= r; k++)
+            for (i = -hw[k+r]; i <= hw[k+r]; i++)
+                cnt += SLIME_BIT(r + i, r + j + k);
+
+        for (i = 0; i < chunkW; i++)
+        {
+            if (i > 0)
+            {
+                for (k = -r; k <= r; k++)
+                {
+                    cnt -= SLIME_BIT(r + i - 1 - hw[k+r], r + j + k);
+                    cnt += SLIME_BIT(r + i + hw[k+r], r + j + k);
+                }
+            }
+            if (cnt > bestcnt)
+            {
+                bestcnt = cnt;
+                if (best)
+                {
+                    best->x = chunkX + i;
+                    best->z = chunkZ + j;
+                }
+            }
+        }
+    }
+#undef SLIME_BIT
+
+    free(bits);
+    free(hw);
+    return bestcnt;
+}
+
 int getEndIslands(EndIsland islands[2], int mc, uint64_t seed, int chunkX, int chunkZ)
 {
     StructureConfig sconf;
@@ -520,8 +692,15 @@ int mapEndIslandHeight(float *y, const EndNoise *en, uint64_t seed,
 
 float getEndHeightNoise(const EndNoise *en, int x, int z, int range);
 
-int isEndChunkEmpty(const EndNoise *en, const SurfaceNoise *sn, uint64_t seed,
-    int chunkX, int chunkZ)
+static double getEndDepth(const EndNoise *en, EndTerrain *et, int x, int z)
+{
+    if (et)
+        return getEndDepthCached(et, x, z);
+    return getEndHeightNoise(en, x, z, 0) - 8.0f;
+}
+
+static int isEndChunkEmptyImpl(const EndNoise *en, const SurfaceNoise *sn,
+    EndTerrain *et, uint64_t seed, int chunkX, int chunkZ)
 {
     int i, j, k;
     int x = chunkX * 2;
@@ -579,7 +758,7 @@ int isEndChunkEmpty(const EndNoise *en, const SurfaceNoise *sn, uint64_t seed,
     {
         for (j = 0; j < 2; j++)
         {
-            depth[i][j] = getEndHeightNoise(en, x+i, z+j, 0) - 8.0f;
+            depth[i][j] = getEndDepth(en, et, x+i, z+j);
             for (k = 8; k <= 14; k++)
             {
                 double u = upper_drop[k];
@@ -597,9 +776,9 @@ int isEndChunkEmpty(const EndNoise *en, const SurfaceNoise *sn, uint64_t seed,
 
     // fill in the depth values at the boundaries to neighbouring chunks
     for (i = 0; i < 3; i++)
-        depth[i][2] = getEndHeightNoise(en, x+i, z+2, 0) - 8.0f;
+        depth[i][2] = getEndDepth(en, et, x+i, z+2);
     for (j = 0; j < 2; j++)
-        depth[2][j] = getEndHeightNoise(en, x+2, z+j, 0) - 8.0f;
+        depth[2][j] = getEndDepth(en, et, x+2, z+j);
 
     // see if none of the noise values can generate blocks
     for (i = 0; i < 3; i++)
@@ -623,12 +802,21 @@ int isEndChunkEmpty(const EndNoise *en, const SurfaceNoise *sn, uint64_t seed,
     return 1;
 
 L_check_full:
-    mapEndSurfaceHeight(y, en, sn, chunkX*16, chunkZ*16, 16, 16, 1, 0);
+    if (et)
+        mapEndSurfaceHeightCached(y, et, chunkX*16, chunkZ*16, 16, 16, 1, 0);
+    else
+        mapEndSurfaceHeight(y, en, sn, chunkX*16, chunkZ*16, 16, 16, 1, 0);
     for (k = 0; k < 256; k++)
         if (y[k] != 0) return 0;
     return 1;
 }
 
+int isEndChunkEmpty(const EndNoise *en, const SurfaceNoise *sn, uint64_t seed,
+    int chunkX, int chunkZ)
+{
+    return isEndChunkEmptyImpl(en, sn, NULL, seed, chunkX, chunkZ);
+}
+
 //==============================================================================
 // Checking Biomes & Biome Helper Functions
 //==============================================================================
@@ -642,10 +830,19 @@ static int id_matches(int id, uint64_t b, uint64_t m)
 Pos locateBiome(
     const Generator *g, int x, int y, int z, int radius,
     uint64_t validB, uint64_t validM, uint64_t *rng, int *passes)
+{
+    return locateBiomeCached(g, NULL, x, y, z, radius, validB, validM,
+        rng, passes);
+}
+
+Pos locateBiomeCached(
+    const Generator *g, BiomeCache *bc, int x, int y, int z, int radius,
+    uint64_t validB, uint64_t validM, uint64_t *rng, int *passes)
 {
     Pos out = {x, z};
     int i, j, found;
     found = 0;
+    uint64_t rng0 = *rng;
 
     if (g->mc >= MC_1_18)
     {
@@ -682,6 +879,55 @@ Pos locateBiome(
         int width  = x2 - x1 + 1;
         int height = z2 - z1 + 1;
 
+        if (bc && g->mc >= MC_B1_8 && g->dim == DIM_OVERWORLD)
+        {   // iterate over the rows of the cached tiles in the same order
+            const int *row = NULL;
+            int k = 2;
+            for (j = z1; j <= z2; j++)
+            {
+                int tz = floordiv(j, BIOME_TILE);
+                for (i = x1; i <= x2; i++)
+                {
+                    int tx = floordiv(i, BIOME_TILE);
+                    int ox = i - tx * BIOME_TILE;
+                    if (i == x1 || ox == 0)
+                    {
+                        row = getBiomeTile(g, bc, tx, tz);
+                        if (!row)
+                            goto L_uncached;
+                        row += (j - tz * BIOME_TILE) * BIOME_TILE;
+                    }
+                    if (!id_matches(row[ox], validB, validM))
+                        continue;
+                    if (g->mc >= MC_1_13)
+                    {
+                        if (found == 0 || nextInt(rng, k++) == 0)
+                        {
+                            out.x = i * 4;
+                            out.z = j * 4;
+                            found = 1;
+                        }
+                    }
+                    else if (found == 0 || nextInt(rng, found + 1) == 0)
+                    {
+                        out.x = i * 4;
+                        out.z = j * 4;
+                        ++found;
+                    }
+                }
+            }
+            if (g->mc >= MC_1_13)
+                found = k - 2;
+            goto L_done;
+
+L_uncached:
+            // the tile could not be generated: restart without the cache
+            *rng = rng0;
+            out.x = x;
+            out.z = z;
+            found = 0;
+        }
+
         Range r = {4, x1, z1, width, height, y, 1};
         int *ids = allocCache(g, r);
         genBiomes(g, ids, r);
@@ -719,7 +965,7 @@ Pos locateBiome(
         free(ids);
     }
 
-
+L_done:
     if (passes != NULL)
     {
         *passes = found;
@@ -729,67 +975,6 @@ Pos locateBiome(
 }
 
 
-int areBiomesViable(
-    const Generator *g, int x, int y, int z, int rad,
-    uint64_t validB, uint64_t validM, int approx)
-{
-    int x1 = (x - rad) >> 2, x2 = (x + rad) >> 2, sx = x2 - x1 + 1;
-    int z1 = (z - rad) >> 2, z2 = (z + rad) >> 2, sz = z2 - z1 + 1;
-    int i, j, id, viable = 1;
-    int *ids = NULL;
-
-    // In 1.18+ the area is also checked in y, forming a cube volume.
-    // However, this function is only used for monuments, which need ocean or
-    // river, where we can get away with just checking the lowest y for caves.
-    y = (y - rad) >> 2;
-
-    // check corners
-    Pos corners[4] = { {x1,z1}, {x2,z2}, {x1,z2}, {x2,z1} };
-    for (i = 0; i < 4; i++)
-    {
-        id = getBiomeAt(g, 4, corners[i].x, y, corners[i].z);
-        if (id < 0 || !id_matches(id, validB, validM))
-            goto L_no;
-    }
-    if (approx >= 1) goto L_yes;
-
-    if (g->mc >= MC_1_18)
-    {
-        for (i = 0; i < sx; i++)
-        {
-            uint64_t dat = 0;
-            for (j = 0; j < sz; j++)
-            {
-                if (g->mc >= MC_1_18)
-                    id = sampleBiomeNoise(&g->bn, NULL, x1+i, y, z1+j, &dat, 0);
-                else
-                    id = getBiomeAt(g, 4, x1+i, y, z1+j);
-                if (id < 0 || !id_matches(id, validB, validM))
-                    goto L_no;
-            }
-        }
-    }
-    else
-    {
-        Range r = {4, x1, z1, sx, sz, y, 1};
-        ids = allocCache(g, r);
-        if (genBiomes(g, ids, r))
-            goto L_no;
-        for (i = 0; i < sx*sz; i++)
-        {
-            if (id < 0 || !id_matches(ids[i], validB, validM))
-                goto L_no;
-        }
-    }
-
-    if (0) L_yes: viable = 1;
-    if (0) L_no:  viable = 0;
-    if (ids)
-        free(ids);
-    return viable;
-}
-
-
 //==============================================================================
 // Finding Strongholds and Spawn
 //==============================================================================
@@ -865,17 +1050,28 @@ Pos initFirstStronghold(StrongholdIter *sh, int mc, uint64_t s48)
     return p;
 }
 
-int nextStronghold(StrongholdIter *sh, const Generator *g)
+static void getStrongholdBiomes(int mc, uint64_t *validB, uint64_t *validM)
 {
-    uint64_t validB = 0, validM = 0;
     int i;
+    *validB = *validM = 0;
     for (i = 0; i < 64; i++)
     {
-        if (isStrongholdBiome(sh->mc, i))
-            validB |= (1ULL << i);
-        if (isStrongholdBiome(sh->mc, i+128))
-            validM |= (1ULL << i);
+        if (isStrongholdBiome(mc, i))
+            *validB |= (1ULL << i);
+        if (isStrongholdBiome(mc, i+128))
+            *validM |= (1ULL << i);
     }
+}
+
+int nextStronghold(StrongholdIter *sh, const Generator *g)
+{
+    return nextStrongholdCached(sh, g, NULL);
+}
+
+int nextStrongholdCached(StrongholdIter *sh, const Generator *g, BiomeCache *bc)
+{
+    uint64_t validB, validM;
+    getStrongholdBiomes(sh->mc, &validB, &validM);
 
     if (sh->mc > MC_1_19_2)
     {
@@ -894,8 +1090,8 @@ int nextStronghold(StrongholdIter *sh, const Generator *g)
     }
     else if (sh->mc >= MC_B1_8)
     {
-        sh->pos = locateBiome(g, sh->nextapprox.x, 0, sh->nextapprox.z, 112,
-            validB, validM, &sh->rnds, NULL);
+        sh->pos = locateBiomeCached(g, bc, sh->nextapprox.x, 0,
+            sh->nextapprox.z, 112, validB, validM, &sh->rnds, NULL);
     }
     else
     {
@@ -936,6 +1132,81 @@ int nextStronghold(StrongholdIter *sh, const Generator *g)
 }
 
 
+STRUCT(stronghold_batch_t)
+{
+    const Generator *g;
+    Pos *pos;
+    uint64_t *seeds;
+    uint64_t validB, validM;
+    int n, threads;
+};
+
+static void locateStrongholdShare(void *data, int t)
+{
+    stronghold_batch_t *b = (stronghold_batch_t*) data;
+    int i;
+    for (i = t; i < b->n; i += b->threads)
+    {
+        uint64_t lbr;
+        setSeed(&lbr, b->seeds[i]);
+        Pos p = locateBiome(b->g, b->pos[i].x, 0, b->pos[i].z, 112,
+            b->validB, b->validM, &lbr, NULL);
+        b->pos[i].x = (p.x & ~15) + 4;
+        b->pos[i].z = (p.z & ~15) + 4;
+    }
+}
+
+int getStrongholds(Pos *pos, int n, const Generator *g, int threads)
+{
+    StrongholdIter sh;
+    int i;
+
+    initFirstStronghold(&sh, g->mc, g->seed);
+    if (g->mc <= MC_1_19_2)
+    {   // each biome check advances the random state of the iterator
+        for (i = 0; i < n; i++)
+        {
+            int left = nextStronghold(&sh, g);
+            if (left <= 0)
+                return i;
+            pos[i] = sh.pos;
+            if (left <= 1)
+                return i + 1;
+        }
+        return n;
+    }
+
+    // the approximate positions and the biome check seeds are independent
+    // of the biomes, so the checks can be done for all strongholds together
+    stronghold_batch_t b;
+    b.g = g;
+    b.pos = pos;
+    if (n <= 0)
+        return 0;
+    b.seeds = (uint64_t*) malloc(n * sizeof(uint64_t));
+    if (!b.seeds)
+        return -1;
+    getStrongholdBiomes(g->mc, &b.validB, &b.validM);
+
+    for (i = 0; i < n; i++)
+    {
+        uint64_t rnds = sh.rnds;
+        b.seeds[i] = nextLong(&rnds);
+        pos[i] = sh.nextapprox;
+        if (nextStronghold(&sh, NULL) <= 1)
+        {
+            i++;
+            break;
+        }
+    }
+    b.n = i;
+    b.threads = threads < 1 ? 1 : threads > b.n ? b.n : threads;
+    runThreads(b.threads, locateStrongholdShare, &b);
+    free(b.seeds);
+    return b.n;
+}
+
+
 static
 uint64_t calcFitness(const Generator *g, int x, int z)
 {
@@ -979,36 +1250,100 @@ uint64_t calcFitness(const Generator *g, int x, int z)
     return q;
 }
 
+STRUCT(fitness_batch_t)
+{
+    const Generator *g;
+    const int *x, *z;
+    uint64_t *fit;
+    int n, threads;
+};
+
+static void calcFitnessShare(void *data, int t)
+{
+    fitness_batch_t *b = (fitness_batch_t*) data;
+    int i = (int)((int64_t)b->n * t / b->threads);
+    int e = (int)((int64_t)b->n * (t+1) / b->threads);
+    for (; i < e; i++)
+        b->fit[i] = calcFitness(b->g, b->x[i], b->z[i]);
+}
+
 static
-void findFittest(const Generator *g, Pos *pos, uint64_t *fitness, double maxrad, double step)
+void findFittest(const Generator *g, Pos *pos, uint64_t *fitness,
+    double maxrad, double step, int threads)
 {
     double rad, ang;
     Pos p = *pos;
+    int i, n;
+
+    // The rings are centered on the starting position, so all candidates of
+    // the search are collected first and their fitness is evaluated together.
+    n = 0;
     for (rad = step; rad <= maxrad; rad += step)
-    {
         for (ang = 0; ang <= PI*2; ang += step/rad)
+            n++;
+
+    int *buf = (int*) malloc(n * (2*sizeof(int) + sizeof(uint64_t)));
+    if (!buf)
+    {   // evaluate the candidates one at a time instead
+        for (rad = step; rad <= maxrad; rad += step)
         {
-            int x = p.x + (int)(sin(ang) * rad);
-            int z = p.z + (int)(cos(ang) * rad);
-            uint64_t fit = calcFitness(g, x, z);
-            // Then update pos and fitness if combined total is lower/better
-            if (fit < *fitness)
+            for (ang = 0; ang <= PI*2; ang += step/rad)
             {
-                pos->x = x;
-                pos->z = z;
-                *fitness = fit;
+                int x = p.x + (int)(sin(ang) * rad);
+                int z = p.z + (int)(cos(ang) * rad);
+                uint64_t f = calcFitness(g, x, z);
+                if (f < *fitness)
+                {
+                    pos->x = x;
+                    pos->z = z;
+                    *fitness = f;
+                }
             }
         }
+        return;
     }
+    uint64_t *fit = (uint64_t*) buf;
+    int *xs = (int*) (fit + n);
+    int *zs = xs + n;
+
+    n = 0;
+    for (rad = step; rad <= maxrad; rad += step)
+    {
+        for (ang = 0; ang <= PI*2; ang += step/rad)
+        {
+            xs[n] = p.x + (int)(sin(ang) * rad);
+            zs[n] = p.z + (int)(cos(ang) * rad);
+            n++;
+        }
+    }
+
+    fitness_batch_t batch = { g, xs, zs, fit, n, threads };
+    if (batch.threads > n)
+        batch.threads = n;
+    if (batch.threads < 1)
+        batch.threads = 1;
+    runThreads(batch.threads, calcFitnessShare, &batch);
+
+    for (i = 0; i < n; i++)
+    {
+        // Then update pos and fitness if combined total is lower/better
+        if (fit[i] < *fitness)
+        {
+            pos->x = xs[i];
+            pos->z = zs[i];
+            *fitness = fit[i];
+        }
+    }
+    free(buf);
 }
 
 static
-Pos findFittestPos(const Generator *g)
+Pos findFittestPos(const Generator *g, int threads)
 {
     Pos spawn = {0, 0};
     uint64_t fitness = calcFitness(g, 0, 0);
-    findFittest(g, &spawn, &fitness, 2048.0, 512.0);
-    findFittest(g, &spawn, &fitness, 512.0, 32.0);
+    findFittest(g, &spawn, &fitness, 2048.0, 512.0, threads);
+    findFittest(g, &spawn, &fitness, 512.0, 32.0, threads);
     // center of chunk
     spawn.x = (spawn.x & ~15) + 8;
     spawn.z = (spawn.z & ~15) + 8;
@@ -1027,6 +1362,11 @@ static const uint64_t g_spawn_biomes_17 =
 
 
 Pos estimateSpawn(const Generator *g, uint64_t *rng)
+{
+    return estimateSpawnThreads(g, rng, 1);
+}
+
+Pos estimateSpawnThreads(const Generator *g, uint64_t *rng, int threads)
 {
     Pos spawn = {0, 0};
 
@@ -1051,16 +1391,75 @@ Pos estimateSpawn(const Generator *g, uint64_t *rng)
     }
     else
     {
-        spawn = findFittestPos(g);
+        spawn = findFittestPos(g, threads);
     }
 
     return spawn;
 }
 
+/* Finds the first position in the chunk at (cx0, cz0) that is suitable for
+ * the 1.18+ server spawn.
+ */
+static int findSpawnInChunk(const Generator *g, int cx0, int cz0, Pos *spawn)
+{
+    int ii, jj;
+    for (ii = 0; ii < 4; ii++)
+    {
+        for (jj = 0; jj < 4; jj++)
+        {
+            int64_t np[6];
+            int x = cx0 + ii * 4;
+            int z = cz0 + jj * 4;
+            int id = sampleBiomeNoise(&g->bn, np, x >> 2, 0, z >> 2, 0, 0);
+            // the surface is estimated from the depth parameter alone
+            float y = np[NP_DEPTH] / 76.0;
+            if (y > 63 || id == frozen_ocean ||
+                id == deep_frozen_ocean || id == frozen_river)
+            {
+                spawn->x = x;
+                spawn->z = z;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+STRUCT(spawn_chunks_t)
+{
+    const Generator *g;
+    const Pos *chunks;
+    Pos *spawn;             // spawn position found in each chunk
+    volatile long next;     // next chunk to check
+    volatile long first;    // first chunk with a spawn position so far, or n
+};
+
+// The chunks are claimed in order, so each chunk before the first one with a
+// spawn position gets checked, and the threads stop at the first one found.
+static void findSpawnChunkShare(void *data, int t)
+{
+    spawn_chunks_t *sc = (spawn_chunks_t*) data;
+    long i, f;
+    (void) t;
+    while ((i = ATOMIC_ADD(&sc->next, 1)) < ATOMIC_LOAD(&sc->first))
+    {
+        if (!findSpawnInChunk(sc->g, sc->chunks[i].x, sc->chunks[i].z,
+                &sc->spawn[i]))
+            continue;
+        do f = ATOMIC_LOAD(&sc->first);
+        while (i < f && !ATOMIC_CAS(&sc->first, f, i));
+    }
+}
+
 Pos getSpawn(const Generator *g)
+{
+    return getSpawnThreads(g, 1);
+}
+
+Pos getSpawnThreads(const Generator *g, int threads)
 {
     uint64_t rng;
-    Pos spawn = estimateSpawn(g, &rng);
+    Pos spawn = estimateSpawnThreads(g, &rng, threads);
     int i, j, k, u, v, cx0, cz0;
     uint32_t ii, jj;
 
@@ -1127,33 +1526,18 @@ Pos getSpawn(const Generator *g)
     }
     else
     {
+        Pos chunks[121], found[121];
+        int n = 0;
+
         j = k = u = 0;
         v = -1;
         for (i = 0; i < 121; i++)
         {
             if (j >= -5 && j <= 5 && k >= -5 && k <= 5)
             {
-                // find server spawn point in chunk
-                cx0 = (spawn.x & ~15) + j * 16;
-                cz0 = (spawn.z & ~15) + k * 16;
-                for (ii = 0; ii < 4; ii++)
-                {
-                    for (jj = 0; jj < 4; jj++)
-                    {
-                        float y;
-                        int id;
-                        int x = cx0 + ii * 4;
-                        int z = cz0 + jj * 4;
-                        mapApproxHeight(&y, &id, g, &sn, x >> 2, z >> 2, 1, 1);
-                        if (y > 63 || id == frozen_ocean ||
-                            id == deep_frozen_ocean || id == frozen_river)
-                        {
-                            spawn.x = x;
-                            spawn.z = z;
-                            return spawn;
-                        }
-                    }
-                }
+                chunks[n].x = (spawn.x & ~15) + j * 16;
+                chunks[n].z = (spawn.z & ~15) + k * 16;
+                n++;
             }
             if (j == k || (j < 0 && j == -k) || (j > 0 && j == 1 - k))
             {
@@ -1164,6 +1548,18 @@ Pos getSpawn(const Generator *g)
             j += u;
             k += v;
         }
+
+        // find server spawn point in the chunks of the spiral, where the
+        // threads take the chunks in order and the first one found is used
+        spawn_chunks_t sc;
+        sc.g = g;
+        sc.chunks = chunks;
+        sc.spawn = found;
+        sc.next = 0;
+        sc.first = n;
+        runThreads(threads < 1 ? 1 : threads, findSpawnChunkShare, &sc);
+        if (sc.first < n)
+            return found[sc.first];
         // chunk center
         spawn.x = (spawn.x & ~15) + 8;
         spawn.z = (spawn.z & ~15) + 8;
@@ -1314,13 +1710,27 @@ int isViableFeatureBiome(int mc, int structureType, int biomeID)
 
 static int mapViableBiome(const Layer * l, int * out, int x, int z, int w, int h)
 {
-    int err = mapBiome(l, out, x, z, w, h);
-    if unlikely(err != 0)
-        return err;
-
-    int styp = ((const int*) l->data)[0];
+    const ViableContext *vc = (const ViableContext*) l->data;
     int i, j;
 
+    if (vc->area && x >= vc->ax && z >= vc->az &&
+        x + w <= vc->ax + vc->aw && z + h <= vc->az + vc->ah)
+    {   // the biome layer was generated for a batch of nearby checks
+        for (j = 0; j < h; j++)
+        {
+            const int *src = vc->area + (z - vc->az + j) * (int64_t)vc->aw;
+            memcpy(out + j*(int64_t)w, src + (x - vc->ax), w * sizeof(int));
+        }
+    }
+    else
+    {
+        int err = mapBiome(l, out, x, z, w, h);
+        if unlikely(err != 0)
+            return err;
+    }
+
+    int styp = vc->data[0];
+
     for (j = 0; j < h; j++)
     {
         for (i = 0; i < w; i++)
@@ -1374,8 +1784,9 @@ static int mapViableShore(const Layer * l, int * out, int x, int z, int w, int h
     if unlikely(err != 0)
         return err;
 
-    int styp = ((const int*) l->data)[0];
-    int mc   = ((const int*) l->data)[1];
+    const ViableContext *vc = (const ViableContext*) l->data;
+    int styp = vc->data[0];
+    int mc   = vc->data[1];
     int i, j;
 
     for (j = 0; j < h; j++)
@@ -1406,33 +1817,240 @@ static int mapViableShore(const Layer * l, int * out, int x, int z, int w, int h
         }
     }
 
-    return 1;
+    return 1;
+}
+
+
+static const uint64_t g_monument_biomes2 =
+    (1ULL << deep_frozen_ocean) |
+    (1ULL << deep_cold_ocean) |
+    (1ULL << deep_ocean) |
+    (1ULL << deep_lukewarm_ocean) |
+    (1ULL << deep_warm_ocean);
+
+static const uint64_t g_monument_biomes1 =
+    (1ULL << ocean) |
+    (1ULL << deep_ocean) |
+    (1ULL << river) |
+    (1ULL << frozen_river) |
+    (1ULL << frozen_ocean) |
+    (1ULL << deep_frozen_ocean) |
+    (1ULL << cold_ocean) |
+    (1ULL << deep_cold_ocean) |
+    (1ULL << lukewarm_ocean) |
+    (1ULL << deep_lukewarm_ocean) |
+    (1ULL << warm_ocean) |
+    (1ULL << deep_warm_ocean);
+
+static int isViableLayered(const ViableContext *vc)
+{
+    const Generator *g = vc->g;
+    return g->mc >= MC_B1_8 && g->mc <= MC_1_17 && g->dim == DIM_OVERWORLD;
+}
+
+static Layer *relinkViableLayer(ViableContext *vc, const Layer *l)
+{
+    const Generator *g = vc->g;
+    if (l >= g->ls.layers && l < g->ls.layers + L_NUM)
+        return vc->layers + (l - g->ls.layers);
+    if (l >= g->xlayer && l < g->xlayer + 5)
+        return vc->xlayer + (l - g->xlayer);
+    return (Layer*) l;
+}
+
+// Copies the layer stack of the generator (once per seed and setup), linked
+// among the copies, and installs the viability checks at the biome and shore
+// layers.
+static void syncViableContext(ViableContext *vc)
+{
+    const Generator *g = vc->g;
+    int i;
+    if (vc->synced && vc->seed == g->seed && vc->dim == g->dim &&
+        vc->mc == g->mc && vc->flags == g->flags)
+    {
+        return;
+    }
+    for (i = 0; i < L_NUM; i++)
+    {
+        vc->layers[i] = g->ls.layers[i];
+        vc->layers[i].p = relinkViableLayer(vc, g->ls.layers[i].p);
+        vc->layers[i].p2 = relinkViableLayer(vc, g->ls.layers[i].p2);
+    }
+    for (i = 0; i < 5; i++)
+    {
+        vc->xlayer[i] = g->xlayer[i];
+        vc->xlayer[i].p = relinkViableLayer(vc, g->xlayer[i].p);
+        vc->xlayer[i].p2 = relinkViableLayer(vc, g->xlayer[i].p2);
+    }
+    vc->layers[L_BIOME_256].data = (void*) vc;
+    vc->layers[L_BIOME_256].getMap = mapViableBiome;
+    vc->layers[L_SHORE_16].data = (void*) vc;
+    vc->layers[L_SHORE_16].getMap = mapViableShore;
+    vc->seed = g->seed;
+    vc->mc = g->mc;
+    vc->dim = g->dim;
+    vc->flags = g->flags;
+    vc->synced = 1;
+}
+
+static const Layer *getViableLayerFor(ViableContext *vc, const Layer *l)
+{
+    syncViableContext(vc);
+    return relinkViableLayer(vc, l);
+}
+
+static const Layer *getViableLayer(ViableContext *vc, int layerId)
+{
+    if (!isViableLayered(vc))
+        return NULL;
+    syncViableContext(vc);
+    return &vc->layers[layerId];
+}
+
+static int *getViableBuf(ViableContext *vc, size_t len)
+{
+    if (len > vc->bufsiz)
+    {
+        int *buf = (int*) malloc(len * sizeof(int));
+        if (!buf)
+            return NULL;
+        free(vc->buf);
+        vc->buf = buf;
+        vc->bufsiz = len;
+    }
+    return vc->buf;
+}
+
+// Equivalent to getBiomeAt(), but uses the viability layers of the context
+// for the layered generator, where scale 0 refers to the current entry.
+static int getViableBiomeAt(ViableContext *vc, int scale, int x, int y, int z)
+{
+    const Generator *g = vc->g;
+    if (!isViableLayered(vc))
+    {
+        Range r = {scale, x, z, 1, 1, y, 1};
+        int *buf = getViableBuf(vc, getMinCacheSize(g, scale, 1, 1, 1));
+        if (!buf || genBiomes(g, buf, r))
+            return none;
+        return buf[0];
+    }
+    const Layer *l = scale ? getLayerForScale(g, scale) : vc->entry;
+    if (!l)
+        return none;
+    l = getViableLayerFor(vc, l);
+    int *buf = getViableBuf(vc, getMinLayerCacheSize(l, 1, 1));
+    if (!buf || genArea(l, buf, x, z, 1, 1))
+        return none;
+    return buf[0];
+}
+
+void initViableContext(ViableContext *vc, const Generator *g)
+{
+    vc->g = g;
+    vc->synced = 0;
+    vc->data[0] = vc->data[1] = 0;
+    vc->entry = NULL;
+    vc->buf = NULL;
+    vc->bufsiz = 0;
+    vc->area = NULL;
+    vc->ax = vc->az = vc->aw = vc->ah = 0;
+    if (isViableLayered(vc))
+        vc->entry = relinkViableLayer(vc, g->entry);
+}
+
+void freeViableContext(ViableContext *vc)
+{
+    free(vc->buf);
+    vc->buf = NULL;
+    vc->bufsiz = 0;
+}
+
+static
+int areBiomesViableImpl(ViableContext *vc, const Generator *g,
+    int x, int y, int z, int rad, uint64_t validB, uint64_t validM, int approx)
+{
+    int x1 = (x - rad) >> 2, x2 = (x + rad) >> 2, sx = x2 - x1 + 1;
+    int z1 = (z - rad) >> 2, z2 = (z + rad) >> 2, sz = z2 - z1 + 1;
+    int i, j, id, viable = 1;
+    int *ids = NULL, *buf = NULL;
+
+    // In 1.18+ the area is also checked in y, forming a cube volume.
+    // However, this function is only used for monuments, which need ocean or
+    // river, where we can get away with just checking the lowest y for caves.
+    y = (y - rad) >> 2;
+
+    // check corners
+    Pos corners[4] = { {x1,z1}, {x2,z2}, {x1,z2}, {x2,z1} };
+    for (i = 0; i < 4; i++)
+    {
+        if (vc)
+            id = getViableBiomeAt(vc, 4, corners[i].x, y, corners[i].z);
+        else
+            id = getBiomeAt(g, 4, corners[i].x, y, corners[i].z);
+        if (id < 0 || !id_matches(id, validB, validM))
+            goto L_no;
+    }
+    if (approx >= 1) goto L_yes;
+
+    if (g->mc >= MC_1_18)
+    {
+        for (i = 0; i < sx; i++)
+        {
+            uint64_t dat = 0;
+            for (j = 0; j < sz; j++)
+            {
+                if (g->mc >= MC_1_18)
+                    id = sampleBiomeNoise(&g->bn, NULL, x1+i, y, z1+j, &dat, 0);
+                else
+                    id = getBiomeAt(g, 4, x1+i, y, z1+j);
+                if (id < 0 || !id_matches(id, validB, validM))
+                    goto L_no;
+            }
+        }
+    }
+    else
+    {
+        Range r = {4, x1, z1, sx, sz, y, 1};
+        if (vc && isViableLayered(vc))
+        {
+            const Layer *l = getViableLayerFor(vc, getLayerForScale(g, 4));
+            ids = getViableBuf(vc, getMinLayerCacheSize(l, sx, sz));
+            if (!ids || genArea(l, ids, x1, z1, sx, sz))
+                goto L_no;
+        }
+        else
+        {
+            ids = buf = allocCache(g, r);
+            if (genBiomes(g, ids, r))
+                goto L_no;
+        }
+        for (i = 0; i < sx*sz; i++)
+        {
+            if (id < 0 || !id_matches(ids[i], validB, validM))
+                goto L_no;
+        }
+    }
+
+    if (0) L_yes: viable = 1;
+    if (0) L_no:  viable = 0;
+    if (buf)
+        free(buf);
+    return viable;
 }
 
+int areBiomesViable(
+    const Generator *g, int x, int y, int z, int rad,
+    uint64_t validB, uint64_t validM, int approx)
+{
+    return areBiomesViableImpl(NULL, g, x, y, z, rad, validB, validM, approx);
+}
 
-static const uint64_t g_monument_biomes2 =
-    (1ULL << deep_frozen_ocean) |
-    (1ULL << deep_cold_ocean) |
-    (1ULL << deep_ocean) |
-    (1ULL << deep_lukewarm_ocean) |
-    (1ULL << deep_warm_ocean);
-
-static const uint64_t g_monument_biomes1 =
-    (1ULL << ocean) |
-    (1ULL << deep_ocean) |
-    (1ULL << river) |
-    (1ULL << frozen_river) |
-    (1ULL << frozen_ocean) |
-    (1ULL << deep_frozen_ocean) |
-    (1ULL << cold_ocean) |
-    (1ULL << deep_cold_ocean) |
-    (1ULL << lukewarm_ocean) |
-    (1ULL << deep_lukewarm_ocean) |
-    (1ULL << warm_ocean) |
-    (1ULL << deep_warm_ocean);
 
-int isViableStructurePos(int structureType, Generator *g, int x, int z, uint32_t flags)
+static
+int isViableStructurePosImpl(int structureType, ViableContext *vc,
+    int x, int z, uint32_t flags)
 {
+    const Generator *g = vc->g;
     int approx = 0; // enables approximation levels
     int viable = 0;
 
@@ -1465,7 +2083,7 @@ int isViableStructurePos(int structureType, Generator *g, int x, int z, uint32_t
             };
             if (!getStructurePos(Bastion, g->mc, g->seed, rp.x, rp.z, &rp))
                 return 1;
-            return !isViableStructurePos(Bastion, g, x, z, flags);
+            return !isViableStructurePosImpl(Bastion, vc, x, z, flags);
         }
         sampleY = 0;
         if (g->mc >= MC_1_18 && structureType == Bastion)
@@ -1482,7 +2100,7 @@ int isViableStructurePos(int structureType, Generator *g, int x, int z, uint32_t
             sampleX = (chunkX * 4) + 2;
             sampleZ = (chunkZ * 4) + 2;
         }
-        id = getBiomeAt(g, 4, sampleX, sampleY, sampleZ);
+        id = getViableBiomeAt(vc, 4, sampleX, sampleY, sampleZ);
         return isViableFeatureBiome(g->mc, structureType, id);
     }
     else if (g->dim == DIM_END)
@@ -1501,26 +2119,17 @@ int isViableStructurePos(int structureType, Generator *g, int x, int z, uint32_t
         // End biomes vary only on a per-chunk scale (1:16)
         // voronoi pre-1.15 shouldn't matter for End Cities as the check will
         // be near the chunk center
-        id = getBiomeAt(g, 16, chunkX, 0, chunkZ);
+        id = getViableBiomeAt(vc, 16, chunkX, 0, chunkZ);
         return isViableFeatureBiome(g->mc, structureType, id) ? id : 0;
     }
 
     // Overworld
 
-    Layer lbiome, lshore, *entry = 0;
-    int data[2] = { structureType, g->mc };
-
-    if (g->mc <= MC_1_17)
-    {
-        lbiome = g->ls.layers[L_BIOME_256];
-        lshore = g->ls.layers[L_SHORE_16];
-        entry = g->entry;
-
-        g->ls.layers[L_BIOME_256].data = (void*) data;
-        g->ls.layers[L_BIOME_256].getMap = mapViableBiome;
-        g->ls.layers[L_SHORE_16].data = (void*) data;
-        g->ls.layers[L_SHORE_16].getMap = mapViableShore;
-    }
+    // the viability layers of the context check for this structure type
+    const Layer *entry = vc->entry;
+    int data[2] = { vc->data[0], vc->data[1] };
+    vc->data[0] = structureType;
+    vc->data[1] = g->mc;
 
     switch (structureType)
     {
@@ -1541,18 +2150,18 @@ int isViableStructurePos(int structureType, Generator *g, int x, int z, uint32_t
 L_feature:
         if (g->mc <= MC_1_15)
         {
-            g->entry = &g->ls.layers[L_VORONOI_1];
+            vc->entry = getViableLayer(vc, L_VORONOI_1);
             sampleX = chunkX * 16 + 9;
             sampleZ = chunkZ * 16 + 9;
         }
         else
         {
             if (g->mc <= MC_1_17)
-                g->entry = &g->ls.layers[L_RIVER_MIX_4];
+                vc->entry = getViableLayer(vc, L_RIVER_MIX_4);
             sampleX = chunkX * 4 + 2;
             sampleZ = chunkZ * 4 + 2;
         }
-        id = getBiomeAt(g, 0, sampleX, 319>>2, sampleZ);
+        id = getViableBiomeAt(vc, 0, sampleX, 319>>2, sampleZ);
         if (id < 0 || !isViableFeatureBiome(g->mc, structureType, id))
             goto L_not_viable;
         goto L_viable;
@@ -1560,18 +2169,18 @@ L_feature:
     case Desert_Well:
         if (g->mc <= MC_1_15)
         {
-            g->entry = &g->ls.layers[L_VORONOI_1];
+            vc->entry = getViableLayer(vc, L_VORONOI_1);
             sampleX = x;
             sampleZ = z;
         }
         else
         {
             if (g->mc <= MC_1_17)
-                g->entry = &g->ls.layers[L_RIVER_MIX_4];
+                vc->entry = getViableLayer(vc, L_RIVER_MIX_4);
             sampleX = x >> 2;
             sampleZ = z >> 2;
         }
-        id = getBiomeAt(g, 0, sampleX, 319>>2, sampleZ);
+        id = getViableBiomeAt(vc, 0, sampleX, 319>>2, sampleZ);
         if (id < 0 || !isViableFeatureBiome(g->mc, structureType, id))
             goto L_not_viable;
         goto L_viable;
@@ -1582,17 +2191,17 @@ L_feature:
             if (g->mc == MC_1_15)
             {   // exclusively in MC_1_15, villages used the same biome check
                 // as other structures
-                g->entry = &g->ls.layers[L_VORONOI_1];
+                vc->entry = getViableLayer(vc, L_VORONOI_1);
                 sampleX = chunkX * 16 + 9;
                 sampleZ = chunkZ * 16 + 9;
             }
             else
             {
-                g->entry = &g->ls.layers[L_RIVER_MIX_4];
+                vc->entry = getViableLayer(vc, L_RIVER_MIX_4);
                 sampleX = chunkX * 4 + 2;
                 sampleZ = chunkZ * 4 + 2;
             }
-            id = getBiomeAt(g, 0, sampleX, 0, sampleZ);
+            id = getViableBiomeAt(vc, 0, sampleX, 0, sampleZ);
             if (id < 0 || !isViableFeatureBiome(g->mc, structureType, id))
                 goto L_not_viable;
             if (flags && (uint32_t) id != flags)
@@ -1603,7 +2212,7 @@ L_feature:
                 // check at block (2, 2) in the starting chunk
                 sampleX = chunkX * 16 + 2;
                 sampleZ = chunkZ * 16 + 2;
-                id = getBiomeAt(g, 1, sampleX, 0, sampleZ);
+                id = getViableBiomeAt(vc, 1, sampleX, 0, sampleZ);
                 if (id < 0 || !isViableFeatureBiome(g->mc, structureType, id))
                     goto L_not_viable;
             }
@@ -1622,7 +2231,7 @@ L_feature:
                 sampleX = (chunkX*32 + 2*sv.x + sv.sx-1) / 2 >> 2;
                 sampleZ = (chunkZ*32 + 2*sv.z + sv.sz-1) / 2 >> 2;
                 sampleY = 319 >> 2;
-                id = getBiomeAt(g, 0, sampleX, sampleY, sampleZ);
+                id = getViableBiomeAt(vc, 0, sampleX, sampleY, sampleZ);
                 if (id == vv[i] || (id == meadow && vv[i] == plains)) {
                     viable = vv[i];
                     goto L_viable;
@@ -1660,7 +2269,7 @@ L_feature:
                 {
                     if (g->mc >= MC_1_16_1)
                         goto L_not_viable;
-                    if (isViableStructurePos(Village, g, p.x, p.z, 0))
+                    if (isViableStructurePosImpl(Village, vc, p.x, p.z, 0))
                         goto L_not_viable;
                 }
             }
@@ -1680,17 +2289,17 @@ L_feature:
         }
         else if (g->mc >= MC_1_16_1)
         {
-            g->entry = &g->ls.layers[L_RIVER_MIX_4];
+            vc->entry = getViableLayer(vc, L_RIVER_MIX_4);
             sampleX = chunkX * 4 + 2;
             sampleZ = chunkZ * 4 + 2;
         }
         else
         {
-            g->entry = &g->ls.layers[L_VORONOI_1];
+            vc->entry = getViableLayer(vc, L_VORONOI_1);
             sampleX = chunkX * 16 + 9;
             sampleZ = chunkZ * 16 + 9;
         }
-        id = getBiomeAt(g, 0, sampleX, 319>>2, sampleZ);
+        id = getViableBiomeAt(vc, 0, sampleX, 319>>2, sampleZ);
         if (id < 0 || !isViableFeatureBiome(g->mc, structureType, id))
             goto L_not_viable;
         goto L_viable;
@@ -1701,15 +2310,15 @@ L_feature:
             goto L_not_viable;
         else if (g->mc == MC_1_8)
         {   // In 1.8 monuments require only a single deep ocean block.
-            id = getBiomeAt(g, 1, chunkX * 16 + 8, 0, chunkZ * 16 + 8);
+            id = getViableBiomeAt(vc, 1, chunkX * 16 + 8, 0, chunkZ * 16 + 8);
             if (id < 0 || !isDeepOcean(id))
                 goto L_not_viable;
         }
         else if (g->mc <= MC_1_17)
         {   // Monuments require two viability checks with the ocean layer
             // branch => worth checking for potential deep ocean beforehand.
-            g->entry = &g->ls.layers[L_SHORE_16];
-            id = getBiomeAt(g, 0, chunkX, 0, chunkZ);
+            vc->entry = getViableLayer(vc, L_SHORE_16);
+            id = getViableBiomeAt(vc, 0, chunkX, 0, chunkZ);
             if (id < 0 || !isDeepOcean(id))
                 goto L_not_viable;
         }
@@ -1717,16 +2326,16 @@ L_feature:
         sampleZ = chunkZ * 16 + 8;
         if (g->mc >= MC_1_9 && g->mc <= MC_1_17)
         {   // check for deep ocean center
-            if (!areBiomesViable(g, sampleX, 63, sampleZ, 16, g_monument_biomes2, 0, approx))
+            if (!areBiomesViableImpl(vc, g, sampleX, 63, sampleZ, 16, g_monument_biomes2, 0, approx))
                 goto L_not_viable;
         }
         else if (g->mc >= MC_1_18)
         {   // check is done at y level of ocean floor - approx. with y = 36
-            id = getBiomeAt(g, 4, sampleX>>2, 36>>2, sampleZ>>2);
+            id = getViableBiomeAt(vc, 4, sampleX>>2, 36>>2, sampleZ>>2);
             if (!isDeepOcean(id))
                 goto L_not_viable;
         }
-        if (areBiomesViable(g, sampleX, 63, sampleZ, 29, g_monument_biomes1, 0, approx))
+        if (areBiomesViableImpl(vc, g, sampleX, 63, sampleZ, 29, g_monument_biomes1, 0, approx))
             goto L_viable;
         goto L_not_viable;
 
@@ -1739,7 +2348,7 @@ L_feature:
             sampleZ = chunkZ * 16 + 8;
             uint64_t b = (1ULL << dark_forest);
             uint64_t m = (1ULL << (dark_forest_hills-128));
-            if (!areBiomesViable(g, sampleX, 0, sampleZ, 32, b, m, approx))
+            if (!areBiomesViableImpl(vc, g, sampleX, 0, sampleZ, 32, b, m, approx))
                 goto L_not_viable;
         }
         else
@@ -1750,7 +2359,7 @@ L_feature:
             // TODO: get surface height
             sampleX = chunkX * 16 + 7;
             sampleZ = chunkZ * 16 + 7;
-            id = getBiomeAt(g, 4, sampleX>>2, 319>>2, sampleZ>>2);
+            id = getViableBiomeAt(vc, 4, sampleX>>2, 319>>2, sampleZ>>2);
             if (id < 0 || !isViableFeatureBiome(g->mc, structureType, id))
                 goto L_not_viable;
         }
@@ -1780,7 +2389,7 @@ L_jigsaw:
             sampleX = (chunkX*32 + 2*sv.x + sv.sx - 1) / 2 >> 2;
             sampleZ = (chunkZ*32 + 2*sv.z + sv.sz - 1) / 2 >> 2;
             sampleY = sv.y >> 2;
-            id = getBiomeAt(g, 4, sampleX, sampleY, sampleZ);
+            id = getViableBiomeAt(vc, 4, sampleX, sampleY, sampleZ);
         }
         if (id < 0 || !isViableFeatureBiome(g->mc, structureType, id))
             goto L_not_viable;
@@ -1800,15 +2409,216 @@ L_viable:
     if (!viable)
         viable = 1;
 L_not_viable:
-    if (g->mc <= MC_1_17)
+    vc->data[0] = data[0];
+    vc->data[1] = data[1];
+    vc->entry = entry;
+    return viable;
+}
+
+int isViableStructurePosCtx(int structureType, ViableContext *vc,
+    int x, int z, uint32_t flags)
+{
+    return isViableStructurePosImpl(structureType, vc, x, z, flags);
+}
+
+int isViableStructurePos(int structureType, const Generator *g, int x, int z, uint32_t flags)
+{
+#ifdef THREAD_LOCAL
+    // Each thread keeps its context, so the copy of the layer stack is only
+    // made again when the generator or its seed changes.
+    static THREAD_LOCAL ViableContext vc;
+    int synced = vc.synced && vc.g == g;
+    initViableContext(&vc, g);
+    vc.synced = synced;
+#else
+    ViableContext vc;
+    initViableContext(&vc, g);
+#endif
+    int viable = isViableStructurePosImpl(structureType, &vc, x, z, flags);
+    freeViableContext(&vc);
+    return viable;
+}
+
+// Batched checks are grouped into tiles of 2^VIABLE_TILE blocks, which share
+// the biome layer at 1:256 with a margin for the extent of the layer stack.
+enum { VIABLE_TILE = 12, VIABLE_MARGIN = 4 };
+
+STRUCT(viable_cand_t)
+{
+    int tx, tz;
+    int type, x, z;
+    uint32_t flags;
+    int idx;
+};
+
+STRUCT(viable_batch_t)
+{
+    const Generator *g;
+    viable_cand_t *cand;
+    int *group;
+    int *viable;
+    int ngroups, threads;
+};
+
+static int cmpViableCand(const void *a, const void *b)
+{
+    const viable_cand_t *ca = (const viable_cand_t*) a;
+    const viable_cand_t *cb = (const viable_cand_t*) b;
+    if (ca->tz != cb->tz) return ca->tz < cb->tz ? -1 : 1;
+    if (ca->tx != cb->tx) return ca->tx < cb->tx ? -1 : 1;
+    if (ca->type != cb->type) return ca->type < cb->type ? -1 : 1;
+    if (ca->z != cb->z) return ca->z < cb->z ? -1 : 1;
+    if (ca->x != cb->x) return ca->x < cb->x ? -1 : 1;
+    if (ca->flags != cb->flags) return ca->flags < cb->flags ? -1 : 1;
+    return ca->idx < cb->idx ? -1 : ca->idx > cb->idx;
+}
+
+static void checkViableShare(void *data, int t)
+{
+    viable_batch_t *b = (viable_batch_t*) data;
+    ViableContext vc;
+    int *area = NULL;
+    size_t areasiz = 0;
+    int k, i;
+
+    initViableContext(&vc, b->g);
+    for (k = t; k < b->ngroups; k += b->threads)
+    {
+        const viable_cand_t *c = b->cand + b->group[k];
+        int n = b->group[k+1] - b->group[k];
+
+        vc.area = NULL;
+        if (isViableLayered(&vc))
+        {   // generate the biome layer once for the candidates in the tile
+            int x0 = INT_MAX, z0 = INT_MAX, x1 = INT_MIN, z1 = INT_MIN;
+            for (i = 0; i < n; i++)
+            {
+                if ((c[i].x >> 8) < x0) x0 = c[i].x >> 8;
+                if ((c[i].z >> 8) < z0) z0 = c[i].z >> 8;
+                if ((c[i].x >> 8) > x1) x1 = c[i].x >> 8;
+                if ((c[i].z >> 8) > z1) z1 = c[i].z >> 8;
+            }
+            vc.ax = x0 - VIABLE_MARGIN;
+            vc.az = z0 - VIABLE_MARGIN;
+            vc.aw = x1 - x0 + 1 + 2*VIABLE_MARGIN;
+            vc.ah = z1 - z0 + 1 + 2*VIABLE_MARGIN;
+            const Layer *l = &b->g->ls.layers[L_BIOME_256];
+            size_t len = getMinLayerCacheSize(l, vc.aw, vc.ah);
+            if (len > areasiz)
+            {
+                free(area);
+                area = (int*) malloc(len * sizeof(int));
+                areasiz = area ? len : 0;
+            }
+            // without the area each candidate generates its own biomes
+            if (area && genArea(l, area, vc.ax, vc.az, vc.aw, vc.ah) == 0)
+                vc.area = area;
+        }
+
+        for (i = 0; i < n; i++)
+        {
+            if (i > 0 && c[i].type == c[i-1].type && c[i].x == c[i-1].x &&
+                c[i].z == c[i-1].z && c[i].flags == c[i-1].flags)
+            {   // duplicate candidate
+                b->viable[c[i].idx] = b->viable[c[i-1].idx];
+                continue;
+            }
+            b->viable[c[i].idx] = isViableStructurePosImpl(
+                c[i].type, &vc, c[i].x, c[i].z, c[i].flags);
+        }
+    }
+    free(area);
+    freeViableContext(&vc);
+}
+
+int areViableStructurePos(const Generator *g, int n, const int *types,
+    const Pos *pos, const uint32_t *flags, int *viable, int threads)
+{
+    viable_batch_t b;
+    int i, cnt;
+
+    if (n <= 0)
+        return 0;
+    b.cand = (viable_cand_t*) malloc(n * sizeof(viable_cand_t));
+    b.group = (int*) malloc((n + 1) * sizeof(int));
+    if (!b.cand || !b.group)
     {
-        g->ls.layers[L_BIOME_256] = lbiome;
-        g->ls.layers[L_SHORE_16] = lshore;
-        g->entry = entry;
+        free(b.cand);
+        free(b.group);
+        return -1;
     }
-    return viable;
+
+    for (i = 0; i < n; i++)
+    {
+        viable_cand_t *c = b.cand + i;
+        c->tx = pos[i].x >> VIABLE_TILE;
+        c->tz = pos[i].z >> VIABLE_TILE;
+        c->type = types[i];
+        c->x = pos[i].x;
+        c->z = pos[i].z;
+        c->flags = flags ? flags[i] : 0;
+        c->idx = i;
+    }
+    qsort(b.cand, n, sizeof(viable_cand_t), cmpViableCand);
+
+    b.ngroups = 0;
+    for (i = 0; i < n; i++)
+    {
+        if (i == 0 || b.cand[i].tx != b.cand[i-1].tx ||
+            b.cand[i].tz != b.cand[i-1].tz)
+        {
+            b.group[b.ngroups++] = i;
+        }
+    }
+    b.group[b.ngroups] = n;
+
+    b.g = g;
+    b.viable = viable;
+    b.threads = threads < 1 ? 1 : threads > b.ngroups ? b.ngroups : threads;
+    runThreads(b.threads, checkViableShare, &b);
+
+    for (i = cnt = 0; i < n; i++)
+        cnt += viable[i] != 0;
+    free(b.cand);
+    free(b.group);
+    return cnt;
+}
+
+
+// Surface noise of the 1.18+ Overworld for isViableStructureTerrain(). Each
+// thread keeps the noise of the last seed, as it is slow to initialize.
+#ifdef THREAD_LOCAL
+static THREAD_LOCAL SurfaceNoise g_sn118;
+static THREAD_LOCAL uint64_t g_sn118_seed;
+static THREAD_LOCAL int g_sn118_init;
+#endif
+
+static const SurfaceNoise *getSurfaceNoise118(uint64_t seed)
+{
+#ifdef THREAD_LOCAL
+    if (!g_sn118_init || g_sn118_seed != seed)
+    {
+        initSurfaceNoise118(&g_sn118, seed);
+        g_sn118_seed = seed;
+        g_sn118_init = 1;
+    }
+    return &g_sn118;
+#else
+    SurfaceNoise *sn = (SurfaceNoise*) malloc(sizeof(SurfaceNoise));
+    if (sn)
+        initSurfaceNoise118(sn, seed);
+    return sn;
+#endif
 }
 
+static void releaseSurfaceNoise118(const SurfaceNoise *sn)
+{
+#ifdef THREAD_LOCAL
+    (void) sn;
+#else
+    free((void*) sn);
+#endif
+}
 
 int isViableStructureTerrain(int structType, Generator *g, int x, int z)
 {
@@ -1838,26 +2648,39 @@ int isViableStructureTerrain(int structType, Generator *g, int x, int z)
         return 1;
     }
 
-    // approx surface height using depth parameter (0.5 ~ sea level)
-    double corners[][2] = {
-        {(x+ 0)/4.0, (z+ 0)/4.0},
-        {(x+sx)/4.0, (z+sz)/4.0},
-        {(x+ 0)/4.0, (z+sz)/4.0},
-        {(x+sx)/4.0, (z+ 0)/4.0},
-    };
+    // The lowest corner has to reach sea level for the scattered features and
+    // y=60 for mansions. The coarse surface estimate of the corner cells is
+    // within a few blocks of the full one, so positions are only rejected
+    // when the estimate stays a noise cell (8 blocks) below that. The noise
+    // lowers the surface by at most 8 blocks from the depth alone, so corners
+    // with a depth surface above the limit pass without sampling the noise.
+    int ylim = (structType == Mansion ? 60 : 63);
+    Pos corners[] = { {x, z}, {x+sx, z+sz}, {x, z+sz}, {x+sx, z} };
+    const SurfaceNoise *sn = NULL;
     int nptype = g->bn.nptype;
     int i, ret = 1;
     g->bn.nptype = NP_DEPTH;
     for (i = 0; i < 4; i++)
     {
-        double depth = sampleClimatePara(&g->bn, 0, corners[i][0], corners[i][1]);
-        if (depth < 0.48)
+        double depth = sampleClimatePara(&g->bn, 0,
+            corners[i].x / 4.0, corners[i].z / 4.0);
+        if (128 * depth >= ylim + 4)
+            continue;
+        float y;
+        if (!sn && !(sn = getSurfaceNoise118(g->seed)))
+            break;
+        if (mapApproxHeightFast(&y, NULL, g, sn,
+                corners[i].x >> 2, corners[i].z >> 2, 1, 1) != 0)
+            break;
+        if (y < ylim - 8)
         {
             ret = 0;
             break;
         }
     }
     g->bn.nptype = nptype;
+    if (sn)
+        releaseSurfaceNoise118(sn);
     return ret;
 }
 
@@ -1874,10 +2697,10 @@ int getSurfaceHeight(
 void sampleNoiseColumnEnd(double column[], const SurfaceNoise *sn,
         const EndNoise *en, int x, int z, int colymin, int colymax);
 
-int isViableEndCityTerrain(const Generator *g, const SurfaceNoise *sn,
+static int isViableEndCityTerrainImpl(const EndNoise *en,
+        const SurfaceNoise *sn, EndTerrain *et, uint64_t seed,
         int blockX, int blockZ)
 {
-    const EndNoise *en = &g->en;
     int chunkX = blockX >> 4;
     int chunkZ = blockZ >> 4;
     blockX = chunkX * 16 + 7;
@@ -1888,10 +2711,10 @@ int isViableEndCityTerrain(const Generator *g, const SurfaceNoise *sn,
     enum { y0 = 15, y1 = 18, yn = y1-y0+1 };
     double ncol[3][3][yn];
 
-    sampleNoiseColumnEnd(ncol[0][0], sn, en, cellx, cellz, y0, y1);
-    sampleNoiseColumnEnd(ncol[0][1], sn, en, cellx, cellz+1, y0, y1);
-    sampleNoiseColumnEnd(ncol[1][0], sn, en, cellx+1, cellz, y0, y1);
-    sampleNoiseColumnEnd(ncol[1][1], sn, en, cellx+1, cellz+1, y0, y1);
+    sampleEndColumn(ncol[0][0], et, sn, en, cellx, cellz, y0, y1);
+    sampleEndColumn(ncol[0][1], et, sn, en, cellx, cellz+1, y0, y1);
+    sampleEndColumn(ncol[1][0], et, sn, en, cellx+1, cellz, y0, y1);
+    sampleEndColumn(ncol[1][1], et, sn, en, cellx+1, cellz+1, y0, y1);
 
     int h00, h01, h10, h11;
     h00 = getSurfaceHeight(ncol[0][0], ncol[0][1], ncol[1][0], ncol[1][1],
@@ -1901,16 +2724,16 @@ int isViableEndCityTerrain(const Generator *g, const SurfaceNoise *sn,
     if (en->mc <= MC_1_18)
         setSeed(&cs, chunkX + chunkZ * 10387313ULL);
     else
-        cs = chunkGenerateRnd(g->seed, chunkX, chunkZ);
+        cs = chunkGenerateRnd(seed, chunkX, chunkZ);
 
     switch (nextInt(&cs, 4))
     {
     case 0: // (++) 0
-        sampleNoiseColumnEnd(ncol[0][2], sn, en, cellx+0, cellz+2, y0, y1);
-        sampleNoiseColumnEnd(ncol[1][2], sn, en, cellx+1, cellz+2, y0, y1);
-        sampleNoiseColumnEnd(ncol[2][0], sn, en, cellx+2, cellz+0, y0, y1);
-        sampleNoiseColumnEnd(ncol[2][1], sn, en, cellx+2, cellz+1, y0, y1);
-        sampleNoiseColumnEnd(ncol[2][2], sn, en, cellx+2, cellz+2, y0, y1);
+        sampleEndColumn(ncol[0][2], et, sn, en, cellx+0, cellz+2, y0, y1);
+        sampleEndColumn(ncol[1][2], et, sn, en, cellx+1, cellz+2, y0, y1);
+        sampleEndColumn(ncol[2][0], et, sn, en, cellx+2, cellz+0, y0, y1);
+        sampleEndColumn(ncol[2][1], et, sn, en, cellx+2, cellz+1, y0, y1);
+        sampleEndColumn(ncol[2][2], et, sn, en, cellx+2, cellz+2, y0, y1);
         h01 = getSurfaceHeight(ncol[0][1], ncol[0][2], ncol[1][1], ncol[1][2],
                 y0, y1, 4, ((blockX    ) & 7) / 8.0, ((blockZ + 5) & 7) / 8.0);
         h10 = getSurfaceHeight(ncol[1][0], ncol[1][1], ncol[2][0], ncol[2][1],
@@ -1920,8 +2743,8 @@ int isViableEndCityTerrain(const Generator *g, const SurfaceNoise *sn,
         break;
 
     case 1: // (-+) 90
-        sampleNoiseColumnEnd(ncol[0][2], sn, en, cellx+0, cellz+2, y0, y1);
-        sampleNoiseColumnEnd(ncol[1][2], sn, en, cellx+1, cellz+2, y0, y1);
+        sampleEndColumn(ncol[0][2], et, sn, en, cellx+0, cellz+2, y0, y1);
+        sampleEndColumn(ncol[1][2], et, sn, en, cellx+1, cellz+2, y0, y1);
         h01 = getSurfaceHeight(ncol[0][1], ncol[0][2], ncol[1][1], ncol[1][2],
                 y0, y1, 4, ((blockX    ) & 7) / 8.0, ((blockZ + 5) & 7) / 8.0);
         h10 = getSurfaceHeight(ncol[0][0], ncol[0][1], ncol[1][0], ncol[1][1],
@@ -1940,8 +2763,8 @@ int isViableEndCityTerrain(const Generator *g, const SurfaceNoise *sn,
         break;
 
     case 3: // (+-) 270
-        sampleNoiseColumnEnd(ncol[2][0], sn, en, cellx+2, cellz+0, y0, y1);
-        sampleNoiseColumnEnd(ncol[2][1], sn, en, cellx+2, cellz+1, y0, y1);
+        sampleEndColumn(ncol[2][0], et, sn, en, cellx+2, cellz+0, y0, y1);
+        sampleEndColumn(ncol[2][1], et, sn, en, cellx+2, cellz+1, y0, y1);
         h01 = getSurfaceHeight(ncol[0][0], ncol[0][1], ncol[1][0], ncol[1][1],
                 y0, y1, 4, ((blockX    ) & 7) / 8.0, ((blockZ - 5) & 7) / 8.0);
         h10 = getSurfaceHeight(ncol[1][0], ncol[1][1], ncol[2][0], ncol[2][1],
@@ -1960,6 +2783,104 @@ int isViableEndCityTerrain(const Generator *g, const SurfaceNoise *sn,
     return h00 >= 60 ? h00 : 0;
 }
 
+int isViableEndCityTerrain(const Generator *g, const SurfaceNoise *sn,
+        int blockX, int blockZ)
+{
+    return isViableEndCityTerrainImpl(&g->en, sn, NULL, g->seed, blockX, blockZ);
+}
+
+int isViableEndCityTerrainCached(EndTerrain *et, uint64_t seed,
+        int blockX, int blockZ)
+{
+    return isViableEndCityTerrainImpl(et->en, et->sn, et, seed, blockX, blockZ);
+}
+
+STRUCT(end_query_t)
+{
+    int tx, tz;
+    int idx;
+};
+
+static int cmpEndQuery(const void *a, const void *b)
+{
+    const end_query_t *qa = (const end_query_t*) a;
+    const end_query_t *qb = (const end_query_t*) b;
+    if (qa->tz != qb->tz) return qa->tz < qb->tz ? -1 : 1;
+    if (qa->tx != qb->tx) return qa->tx < qb->tx ? -1 : 1;
+    return qa->idx < qb->idx ? -1 : qa->idx > qb->idx;
+}
+
+/* Orders the positions by the tile of noise cells they occupy in the column
+ * grid of an EndTerrain, so that queries in the same tile share the cache.
+ */
+static end_query_t *sortEndQueries(int n, const Pos *pos)
+{
+    end_query_t *q = (end_query_t*) malloc(n * sizeof(end_query_t));
+    int i;
+    if (!q)
+        return NULL;
+    for (i = 0; i < n; i++)
+    {
+        q[i].tx = floordiv(pos[i].x >> 3, END_COL_GRID);
+        q[i].tz = floordiv(pos[i].z >> 3, END_COL_GRID);
+        q[i].idx = i;
+    }
+    qsort(q, n, sizeof(*q), cmpEndQuery);
+    return q;
+}
+
+int getEndSurfaceHeightsAt(EndTerrain *et, int n, const Pos *pos, float *y)
+{
+    enum { y0 = END_COL_Y0, y1 = END_COL_Y1, yn = y1-y0+1 };
+    double ncol[2][2][yn];
+    int k;
+
+    if (n <= 0)
+        return 0;
+    end_query_t *q = sortEndQueries(n, pos);
+    if (!q)
+        return 1;
+
+    for (k = 0; k < n; k++)
+    {
+        int i = q[k].idx;
+        int cellx = pos[i].x >> 3;
+        int cellz = pos[i].z >> 3;
+        sampleNoiseColumnEndCached(ncol[0][0], et, cellx, cellz, y0, y1);
+        sampleNoiseColumnEndCached(ncol[0][1], et, cellx, cellz+1, y0, y1);
+        sampleNoiseColumnEndCached(ncol[1][0], et, cellx+1, cellz, y0, y1);
+        sampleNoiseColumnEndCached(ncol[1][1], et, cellx+1, cellz+1, y0, y1);
+        y[i] = getSurfaceHeight(ncol[0][0], ncol[0][1], ncol[1][0], ncol[1][1],
+            y0, y1, 4, (pos[i].x & 7) / 8.0, (pos[i].z & 7) / 8.0);
+    }
+
+    free(q);
+    return 0;
+}
+
+int areViableEndCityTerrain(EndTerrain *et, uint64_t seed, int n,
+        const Pos *pos, int *viable)
+{
+    int k, cnt = 0;
+
+    if (n <= 0)
+        return 0;
+    end_query_t *q = sortEndQueries(n, pos);
+    if (!q)
+        return -1;
+
+    for (k = 0; k < n; k++)
+    {
+        int i = q[k].idx;
+        viable[i] = isViableEndCityTerrainImpl(et->en, et->sn, et, seed,
+            pos[i].x, pos[i].z);
+        cnt += !!viable[i];
+    }
+
+    free(q);
+    return cnt;
+}
+
 
 //==============================================================================
 // Finding Properties of Structures
@@ -2646,6 +3567,8 @@ Piece *addFortressPiece(PieceEnv *env, int typ, int x, int y, int z, int depth,
         b1.x += d0.z;       b1.z += d0.x+d1.x;
         break;
     }
+    if (*env->n >= env->nmax)
+        return NULL; // buffer is full
     Piece *p = env->list + *env->n;
     p->name = fortress_info[typ].name;
     p->pos = pos;
@@ -2846,7 +3769,257 @@ int getFortressPieces(Piece *list, int n, int mc, uint64_t seed, int chunkX, int
         q->next = NULL;
         extendFortressPiece(&env, q);
     }
-    return count;
+    return count;
+}
+
+
+void initPieceArena(PieceArena *pa)
+{
+    memset(pa, 0, sizeof(*pa));
+}
+
+void freePieceArena(PieceArena *pa)
+{
+    free(pa->pieces);
+    free(pa->offset);
+    free(pa->start);
+    free(pa->stype);
+    memset(pa, 0, sizeof(*pa));
+}
+
+void clearPieceArena(PieceArena *pa)
+{
+    pa->npieces = 0;
+    pa->nstructs = 0;
+    if (pa->offset)
+        pa->offset[0] = 0;
+}
+
+static int reservePieces(PieceArena *pa, int n)
+{
+    if (pa->npieces + n <= pa->piececap)
+        return 0;
+    int cap = pa->piececap ? pa->piececap : 1024;
+    while (cap < pa->npieces + n)
+        cap *= 2;
+    Piece *pieces = (Piece*) realloc(pa->pieces, cap * sizeof(Piece));
+    if (!pieces)
+        return -1;
+    pa->pieces = pieces;
+    pa->piececap = cap;
+    return 0;
+}
+
+static int reserveStructs(PieceArena *pa)
+{
+    if (pa->offset && pa->nstructs + 1 < pa->structcap)
+        return 0;
+    int cap = pa->structcap ? pa->structcap * 2 : 64;
+    int *offset = (int*) realloc(pa->offset, cap * sizeof(int));
+    if (!offset)
+        return -1;
+    pa->offset = offset;
+    Pos *start = (Pos*) realloc(pa->start, cap * sizeof(Pos));
+    if (!start)
+        return -1;
+    pa->start = start;
+    int *stype = (int*) realloc(pa->stype, cap * sizeof(int));
+    if (!stype)
+        return -1;
+    pa->stype = stype;
+    if (pa->structcap == 0)
+        pa->offset[0] = 0;
+    pa->structcap = cap;
+    return 0;
+}
+
+int addStructurePieces(PieceArena *pa, int structType, int mc, uint64_t seed,
+        int chunkX, int chunkZ)
+{
+    int i, n;
+    if (structType != Fortress && structType != End_City)
+        return -1;
+    if (reserveStructs(pa))
+        return -1;
+
+    if (structType == End_City)
+    {
+        if (reservePieces(pa, END_CITY_PIECES_MAX))
+            return -1;
+        n = getEndCityPieces(pa->pieces + pa->npieces, seed, chunkX, chunkZ);
+    }
+    else
+    {   // regenerate with more room if the fortress reached the buffer limit
+        int nmax = 512;
+        for (;;)
+        {
+            if (reservePieces(pa, nmax))
+                return -1;
+            n = getFortressPieces(pa->pieces + pa->npieces, nmax, mc, seed,
+                chunkX, chunkZ);
+            if (n < nmax)
+                break;
+            nmax *= 2;
+        }
+    }
+
+    // the links are only valid until the arena grows
+    Piece *p = pa->pieces + pa->npieces;
+    for (i = 0; i < n; i++)
+        p[i].next = NULL;
+
+    pa->npieces += n;
+    pa->start[pa->nstructs].x = chunkX;
+    pa->start[pa->nstructs].z = chunkZ;
+    pa->stype[pa->nstructs] = structType;
+    pa->nstructs++;
+    pa->offset[pa->nstructs] = pa->npieces;
+    return n;
+}
+
+int addStructurePiecesInArea(PieceArena *pa, int structType,
+        const Generator *g, EndTerrain *et, int x0, int z0, int x1, int z1)
+{
+    StructureConfig sconf;
+    if (structType != Fortress && structType != End_City)
+        return -1;
+    if (!getStructureConfig(structType, g->mc, &sconf))
+        return 0;
+
+    int regsiz = sconf.regionSize * 16;
+    int rx0 = floordiv(x0, regsiz), rx1 = floordiv(x1, regsiz);
+    int rz0 = floordiv(z0, regsiz), rz1 = floordiv(z1, regsiz);
+    int rx, rz, cnt = 0;
+
+    for (rz = rz0; rz <= rz1; rz++)
+    {
+        for (rx = rx0; rx <= rx1; rx++)
+        {
+            Pos p;
+            if (!getStructurePos(structType, g->mc, g->seed, rx, rz, &p))
+                continue;
+            if (p.x < x0 || p.x > x1 || p.z < z0 || p.z > z1)
+                continue;
+            if (!isViableStructurePos(structType, g, p.x, p.z, 0))
+                continue;
+            if (structType == End_City && et &&
+                !isViableEndCityTerrainCached(et, g->seed, p.x, p.z))
+                continue;
+            if (addStructurePieces(pa, structType, g->mc, g->seed,
+                    p.x >> 4, p.z >> 4) < 0)
+                return -1;
+            cnt++;
+        }
+    }
+    return cnt;
+}
+
+static int cmpPieceKey(const void *a, const void *b)
+{
+    const PieceKey *ka = (const PieceKey*) a;
+    const PieceKey *kb = (const PieceKey*) b;
+    if (ka->key != kb->key) return ka->key < kb->key ? -1 : 1;
+    return ka->piece < kb->piece ? -1 : ka->piece > kb->piece;
+}
+
+static int64_t getPieceCellKey(int cx, int cz)
+{
+    return (int64_t)cz * 0x100000000LL + ((int64_t)cx + 0x80000000LL);
+}
+
+int buildPieceIndex(PieceIndex *pi, const PieceArena *pa)
+{
+    int i;
+    pi->n = pa->npieces;
+    pi->ext = 0;
+    pi->keys = (PieceKey*) malloc((pi->n ? pi->n : 1) * sizeof(PieceKey));
+    if (!pi->keys)
+        return -1;
+    for (i = 0; i < pi->n; i++)
+    {
+        const Piece *p = pa->pieces + i;
+        int ext = p->bb1.x - p->bb0.x;
+        if (p->bb1.z - p->bb0.z > ext)
+            ext = p->bb1.z - p->bb0.z;
+        if (ext > pi->ext)
+            pi->ext = ext;
+        pi->keys[i].key = getPieceCellKey(
+            p->bb0.x >> PIECE_INDEX_SHIFT, p->bb0.z >> PIECE_INDEX_SHIFT);
+        pi->keys[i].piece = i;
+    }
+    qsort(pi->keys, pi->n, sizeof(PieceKey), cmpPieceKey);
+    return 0;
+}
+
+void freePieceIndex(PieceIndex *pi)
+{
+    free(pi->keys);
+    pi->keys = NULL;
+    pi->n = 0;
+}
+
+int getPieceStructure(const PieceArena *pa, int piece)
+{
+    int lo = 0, hi = pa->nstructs - 1;
+    while (lo < hi)
+    {   // last structure with offset <= piece
+        int mid = (lo + hi + 1) / 2;
+        if (pa->offset[mid] <= piece)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    return lo;
+}
+
+int queryPieceIndex(const PieceIndex *pi, const PieceArena *pa,
+        int structType, int pieceType, int x, int z, int r,
+        int *out, int nmax)
+{
+    // pieces are keyed by their lower corner, which is at most 'ext' blocks
+    // below the other end of the bounding box
+    int cx0 = (x - r - pi->ext) >> PIECE_INDEX_SHIFT;
+    int cz0 = (z - r - pi->ext) >> PIECE_INDEX_SHIFT;
+    int cx1 = (x + r) >> PIECE_INDEX_SHIFT;
+    int cz1 = (z + r) >> PIECE_INDEX_SHIFT;
+    int64_t rsq = (int64_t) r * r;
+    int cz, n = 0;
+
+    for (cz = cz0; cz <= cz1; cz++)
+    {
+        int64_t kmin = getPieceCellKey(cx0, cz);
+        int64_t kmax = getPieceCellKey(cx1, cz);
+        int lo = 0, hi = pi->n;
+        while (lo < hi)
+        {
+            int mid = (lo + hi) / 2;
+            if (pi->keys[mid].key < kmin)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        for (; lo < pi->n && pi->keys[lo].key <= kmax; lo++)
+        {
+            int k = pi->keys[lo].piece;
+            const Piece *p = pa->pieces + k;
+            if (pieceType >= 0 && p->type != pieceType)
+                continue;
+            if (structType >= 0 &&
+                pa->stype[getPieceStructure(pa, k)] != structType)
+                continue;
+            int64_t dx = 0, dz = 0;
+            if (x < p->bb0.x) dx = p->bb0.x - x;
+            else if (x > p->bb1.x) dx = x - p->bb1.x;
+            if (z < p->bb0.z) dz = p->bb0.z - z;
+            else if (z > p->bb1.z) dz = z - p->bb1.z;
+            if (dx*dx + dz*dz > rsq)
+                continue;
+            if (n < nmax)
+                out[n] = k;
+            n++;
+        }
+    }
+    return n;
 }
 
 
@@ -2899,8 +4072,8 @@ void getFixedEndGateways(int mc, uint64_t seed, Pos src[20])
         src[i] = fixed[ order[i] ];
 }
 
-Pos getLinkedGatewayChunk(const EndNoise *en, const SurfaceNoise *sn, uint64_t seed,
-    Pos src, Pos *dst)
+static Pos getLinkedGatewayChunkImpl(const EndNoise *en,
+    const SurfaceNoise *sn, EndTerrain *et, uint64_t seed, Pos src, Pos *dst)
 {
     double invr = 1.0 / sqrt(src.x * src.x + src.z * src.z);
     double dx = src.x * invr;
@@ -2915,7 +4088,7 @@ Pos getLinkedGatewayChunk(const EndNoise *en, const SurfaceNoise *sn, uint64_t s
     c.x = (int) floor(px) >> 4;
     c.z = (int) floor(pz) >> 4;
 
-    if (isEndChunkEmpty(en, sn, seed, c.x, c.z))
+    if (isEndChunkEmptyImpl(en, sn, et, seed, c.x, c.z))
     {   // look forward for the first non-empty chunk
         for (i = 0; i < 15; i++)
         {
@@ -2925,7 +4098,7 @@ Pos getLinkedGatewayChunk(const EndNoise *en, const SurfaceNoise *sn, uint64_t s
                 continue;
             c.x = qx;
             c.z = qz;
-            if (!isEndChunkEmpty(en, sn, seed, c.x, c.z))
+            if (!isEndChunkEmptyImpl(en, sn, et, seed, c.x, c.z))
                 break;
         }
     }
@@ -2935,7 +4108,7 @@ Pos getLinkedGatewayChunk(const EndNoise *en, const SurfaceNoise *sn, uint64_t s
         {
             int qx = (int) floor(px -= dx) >> 4;
             int qz = (int) floor(pz -= dz) >> 4;
-            if (isEndChunkEmpty(en, sn, seed, qx, qz))
+            if (isEndChunkEmptyImpl(en, sn, et, seed, qx, qz))
                 break;
             c.x = qx;
             c.z = qz;
@@ -2949,14 +4122,27 @@ Pos getLinkedGatewayChunk(const EndNoise *en, const SurfaceNoise *sn, uint64_t s
     return c;
 }
 
-Pos getLinkedGatewayPos(const EndNoise *en, const SurfaceNoise *sn, uint64_t seed, Pos src)
+Pos getLinkedGatewayChunk(const EndNoise *en, const SurfaceNoise *sn, uint64_t seed,
+    Pos src, Pos *dst)
+{
+    return getLinkedGatewayChunkImpl(en, sn, NULL, seed, src, dst);
+}
+
+Pos getLinkedGatewayChunkCached(EndTerrain *et, uint64_t seed,
+    Pos src, Pos *dst)
+{
+    return getLinkedGatewayChunkImpl(et->en, et->sn, et, seed, src, dst);
+}
+
+static Pos getLinkedGatewayPosImpl(const EndNoise *en, const SurfaceNoise *sn,
+    EndTerrain *et, uint64_t seed, Pos src)
 {
     float y[33*33]; // buffer for [16][16] and [33][33]
     int ymin = 0;
     int i, j;
 
     Pos dst;
-    Pos c = getLinkedGatewayChunk(en, sn, seed, src, &dst);
+    Pos c = getLinkedGatewayChunkImpl(en, sn, et, seed, src, &dst);
 
     if (en->mc > MC_1_16)
     {
@@ -2969,7 +4155,10 @@ Pos getLinkedGatewayPos(const EndNoise *en, const SurfaceNoise *sn, uint64_t see
     }
     else
     {
-        mapEndSurfaceHeight(y, en, sn, c.x*16, c.z*16, 16, 16, 1, 30);
+        if (et)
+            mapEndSurfaceHeightCached(y, et, c.x*16, c.z*16, 16, 16, 1, 30);
+        else
+            mapEndSurfaceHeight(y, en, sn, c.x*16, c.z*16, 16, 16, 1, 30);
         mapEndIslandHeight(y, en, seed, c.x*16, c.z*16, 16, 16, 1);
 
         uint64_t d = 0;
@@ -3006,7 +4195,10 @@ Pos getLinkedGatewayPos(const EndNoise *en, const SurfaceNoise *sn, uint64_t see
         if (y[i] > ymin)
             ymin = (int) floor(y[i]);
 
-    mapEndSurfaceHeight(y, en, sn, sp.x, sp.z, 33, 33, 1, ymin);
+    if (et)
+        mapEndSurfaceHeightCached(y, et, sp.x, sp.z, 33, 33, 1, ymin);
+    else
+        mapEndSurfaceHeight(y, en, sn, sp.x, sp.z, 33, 33, 1, ymin);
     mapEndIslandHeight(y, en, seed, sp.x, sp.z, 33, 33, 1);
 
     float v = -1;
@@ -3025,6 +4217,16 @@ Pos getLinkedGatewayPos(const EndNoise *en, const SurfaceNoise *sn, uint64_t see
     return dst;
 }
 
+Pos getLinkedGatewayPos(const EndNoise *en, const SurfaceNoise *sn, uint64_t seed, Pos src)
+{
+    return getLinkedGatewayPosImpl(en, sn, NULL, seed, src);
+}
+
+Pos getLinkedGatewayPosCached(EndTerrain *et, uint64_t seed, Pos src)
+{
+    return getLinkedGatewayPosImpl(et->en, et->sn, et, seed, src);
+}
+
 
 //==============================================================================
 // Seed Filters
@@ -4393,97 +5595,301 @@ int checkForTemps(LayerStack *g, uint64_t seed, int x, int z, int w, int h, cons
 }
 
 
-struct locate_info_t
+STRUCT(biome_label_t)
 {
-    Generator *g;
-    int *ids;
-    Range r;
-    int match, tol;
+    const int *ids;
+    const uint8_t *ids8;
+    const char *interest;
+    int *lab;       // biome of interest | (border distance << 8), or -1
+    int *parent;    // union-find forest over the cell indices
+    int *win;       // per thread scratch for the border distances
+    size_t winsiz;
+    int w, h, tol, threads;
     volatile char *stop;
 };
 
-static
-int floodFillGen(struct locate_info_t *info, int i, int j, Pos *p)
-{
-    typedef struct { int i, j, d; } entry_t;
-    entry_t *queue = (entry_t*) malloc(info->r.sx*info->r.sz * sizeof(*queue));
-    int qn = 1;
-    queue->i = i;
-    queue->j = j;
-    queue->d = 0;
-    int64_t sumx = 0;
-    int64_t sumz = 0;
-    int n = 0;
-    while (--qn >= 0)
+static inline int findLabelRoot(int *parent, int k)
+{
+    while (parent[k] != k)
     {
-        if (info->stop && *info->stop)
+        parent[k] = parent[parent[k]];
+        k = parent[k];
+    }
+    return k;
+}
+
+// Roots always link to the lower index, so the root of each area is its first
+// cell in row-major order and every parent index is at most that of its child.
+static inline void unionLabels(int *parent, int a, int b)
+{
+    a = findLabelRoot(parent, a);
+    b = findLabelRoot(parent, b);
+    if (a < b)
+        parent[b] = a;
+    else if (b < a)
+        parent[a] = b;
+}
+
+// Two neighboring cells are connected when they are labeled for the same
+// biome and the non-matching gap they bridge is shorter than the tolerance.
+static inline int isLabelLinked(int la, int lb, int tol)
+{
+    return la >= 0 && lb >= 0 && (la & 0xff) == (lb & 0xff) &&
+        (la >> 8) + (lb >> 8) < tol;
+}
+
+static inline void relaxLabel(int *lab, int nb, int maxd)
+{
+    if (nb < 0)
+        return;
+    nb += 1 << 8;
+    if ((nb >> 8) > maxd)
+        return;
+    if (*lab < 0 || (nb >> 8) < (*lab >> 8))
+        *lab = nb;
+}
+
+static void labelBiomeStrip(void *data, int t)
+{
+    biome_label_t *b = (biome_label_t*) data;
+    int w = b->w, maxd = b->tol - 1;
+    int y0 = (int)((int64_t)b->h * t / b->threads);
+    int y1 = (int)((int64_t)b->h * (t+1) / b->threads);
+    int i, j, k, id;
+
+    // Labels outside the biomes of interest are the distance to the nearest
+    // one, which is bounded by the tolerance, so a strip only needs that many
+    // extra rows on either side to be labeled the same as the whole buffer.
+    int a = y0 - maxd < 0 ? 0 : y0 - maxd;
+    int e = y1 + maxd > b->h ? b->h : y1 + maxd;
+    int *win = b->lab + (size_t)a * w;
+    if (maxd > 0)
+        win = b->win + b->winsiz * t;
+
+    for (k = 0, j = a; j < e; j++)
+    {
+        for (i = 0; i < w; i++, k++)
         {
-            free(queue);
-            return 0;
+            if (b->ids8)
+                id = b->ids8[(size_t)j * w + i];
+            else
+                id = b->ids[(size_t)j * w + i];
+            win[k] = (id >= 0 && id < 256 && b->interest[id]) ? id : -1;
         }
-        int d = queue[qn].d;
-        i = queue[qn].i;
-        j = queue[qn].j;
-        int k = j * info->r.sx + i;
-        int id = info->ids[k];
-        if (id == INT_MAX)
-            continue;
-        info->ids[k] = INT_MAX;
-        int x = info->r.x + i;
-        int z = info->r.z + j;
-        if (info->g->mc >= MC_1_18)
-            id = getBiomeAt(info->g, info->r.scale, x, info->r.y, z);
-        if (id == info->match)
-        {
-            sumx += x;
-            sumz += z;
-            n++;
-            d = 0;
+    }
+    if (maxd > 0)
+    {
+        for (k = 0, j = a; j < e; j++)
+        {
+            for (i = 0; i < w; i++, k++)
+            {
+                if (j > a)
+                    relaxLabel(win+k, win[k-w], maxd);
+                if (i > 0)
+                    relaxLabel(win+k, win[k-1], maxd);
+            }
         }
-        else
+        for (k = (e - a) * w - 1, j = e-1; j >= a; j--)
         {
-            if (++d >= info->tol)
-                continue;
+            for (i = w-1; i >= 0; i--, k--)
+            {
+                if (j < e-1)
+                    relaxLabel(win+k, win[k+w], maxd);
+                if (i < w-1)
+                    relaxLabel(win+k, win[k+1], maxd);
+            }
         }
-        entry_t next[] = { {i,j-1,d}, {i,j+1,d}, {i-1,j,d}, {i+1,j,d} };
-        for (k = 0; k < 4; k++)
+        memcpy(b->lab + (size_t)y0 * w, win + (size_t)(y0 - a) * w,
+            (size_t)(y1 - y0) * w * sizeof(int));
+    }
+
+    for (j = y0; j < y1; j++)
+    {
+        if (b->stop && *b->stop)
+            return;
+        for (i = 0; i < w; i++)
         {
-            i = next[k].i; j = next[k].j;
-            if (i < 0 || i >= info->r.sx || j < 0 || j >= info->r.sz)
-                continue;
-            if (info->ids[j * info->r.sx + i] == INT_MAX)
+            k = j * w + i;
+            b->parent[k] = k;
+            if (b->lab[k] < 0)
                 continue;
-            queue[qn++] = next[k];
+            if (i > 0 && isLabelLinked(b->lab[k], b->lab[k-1], b->tol))
+                unionLabels(b->parent, k, k-1);
+            if (j > y0 && isLabelLinked(b->lab[k], b->lab[k-w], b->tol))
+                unionLabels(b->parent, k, k-w);
         }
     }
-    free(queue);
-    if (n)
+}
+
+STRUCT(biome_area_t)
+{
+    int64_t sumx, sumz;
+    int n, id;
+};
+
+static
+int labelBiomeCenters(Pos *pos, int *siz, int *bid, int nmax,
+    const int *ids, const uint8_t *ids8, Range r, const char interest[256],
+    int minsiz, int tol, int threads, volatile char *stop)
+{
+    biome_label_t b;
+    biome_area_t *area = NULL;
+    int i, j, k, t, n = 0, na = 0, acap = 0;
+    size_t len = (size_t)r.sx * r.sz;
+    int maxd;
+
+    if (minsiz <= 0)
+        minsiz = 1;
+    if (tol <= 0)
+        tol = 1;
+    if (threads < 1)
+        threads = 1;
+    if (threads > r.sz)
+        threads = r.sz;
+    if (len == 0 || len > INT_MAX)
+        return 0;
+
+    b.ids = ids;
+    b.ids8 = ids8;
+    b.interest = interest;
+    // the strips are extended by the tolerance to label the border distances
+    maxd = tol - 1 < r.sz ? tol - 1 : r.sz;
+    b.winsiz = (size_t)((r.sz + threads-1) / threads + 2 * maxd) * r.sx;
+    b.lab = (int*) malloc(2 * len * sizeof(int));
+    b.win = NULL;
+    if (maxd > 0)
+        b.win = (int*) malloc(b.winsiz * threads * sizeof(int));
+    if (!b.lab || (maxd > 0 && !b.win))
+    {
+        n = -1;
+        goto L_end;
+    }
+    b.parent = b.lab + len;
+    b.w = r.sx;
+    b.h = r.sz;
+    b.tol = tol;
+    b.threads = threads;
+    b.stop = stop;
+    runThreads(threads, labelBiomeStrip, &b);
+    if (stop && *stop)
+        goto L_end;
+
+    // merge the areas that continue across the strip boundaries
+    for (t = 1; t < threads; t++)
+    {
+        j = (int)((int64_t)r.sz * t / threads);
+        for (i = 0; i < r.sx; i++)
+        {
+            k = j * r.sx + i;
+            if (isLabelLinked(b.lab[k], b.lab[k-r.sx], tol))
+                unionLabels(b.parent, k, k-r.sx);
+        }
+    }
+
+    // Parents precede their children, so a single forward pass flattens the
+    // forest, after which each root is replaced by the index of its area.
+    for (k = 0; k < (int)len; k++)
+    {
+        if (b.lab[k] < 0)
+            continue;
+        int p = b.parent[k];
+        if (p == k)
+        {
+            if (na >= acap)
+            {
+                int ncap = acap ? 2 * acap : 256;
+                biome_area_t *tmp = (biome_area_t*)
+                    realloc(area, ncap * sizeof(*area));
+                if (!tmp)
+                {
+                    n = -1;
+                    goto L_end;
+                }
+                area = tmp;
+                acap = ncap;
+            }
+            memset(area + na, 0, sizeof(*area));
+            area[na].id = b.lab[k] & 0xff;
+            b.parent[k] = -(++na);
+            p = k;
+        }
+        else if (b.parent[p] >= 0)
+        {
+            p = b.parent[k] = b.parent[p];
+        }
+        if (b.lab[k] > 0xff)
+            continue; // border cell, not part of the biome
+        biome_area_t *a = area + (-b.parent[p] - 1);
+        a->sumx += r.x + k % r.sx;
+        a->sumz += r.z + k / r.sx;
+        a->n++;
+    }
+
+    for (k = 0; k < na && n < nmax; k++)
     {
-        p->x = (int) round((sumx / (double)n + 0.5) * info->r.scale);
-        p->z = (int) round((sumz / (double)n + 0.5) * info->r.scale);
+        if (area[k].n < minsiz)
+            continue;
+        pos[n].x = (int) round((area[k].sumx / (double)area[k].n + 0.5) * r.scale);
+        pos[n].z = (int) round((area[k].sumz / (double)area[k].n + 0.5) * r.scale);
+        if (siz) siz[n] = area[k].n;
+        if (bid) bid[n] = area[k].id;
+        n++;
     }
+
+L_end:
+    free(area);
+    free(b.win);
+    free(b.lab);
     return n;
 }
 
+static void getInterestMask(char interest[256], uint64_t validB, uint64_t validM)
+{
+    int i;
+    for (i = 0; i < 256; i++)
+    {
+        if (i < 64)
+            interest[i] = (validB >> i) & 1;
+        else if (i >= 128 && i < 192)
+            interest[i] = (validM >> (i-128)) & 1;
+        else
+            interest[i] = 0;
+    }
+}
+
+int getBiomeCentersIds(Pos *pos, int *siz, int *bid, int nmax,
+    const int *ids, Range r, uint64_t validB, uint64_t validM,
+    int minsiz, int tol, int threads, volatile char *stop)
+{
+    char interest[256];
+    getInterestMask(interest, validB, validM);
+    return labelBiomeCenters(pos, siz, bid, nmax, ids, NULL, r, interest,
+        minsiz, tol, threads, stop);
+}
+
+int getBiomeCentersIds8(Pos *pos, int *siz, int *bid, int nmax,
+    const uint8_t *ids, Range r, uint64_t validB, uint64_t validM,
+    int minsiz, int tol, int threads, volatile char *stop)
+{
+    char interest[256];
+    getInterestMask(interest, validB, validM);
+    return labelBiomeCenters(pos, siz, bid, nmax, NULL, ids, r, interest,
+        minsiz, tol, threads, stop);
+}
 
 int getBiomeCenters(Pos *pos, int *siz, int nmax, Generator *g, Range r,
     int match, int minsiz, int tol, volatile char *stop)
 {
     if (minsiz <= 0)
         minsiz = 1;
-    int i, j, k, n = 0;
+    int i, j, k, n;
     int *ids = (int*) malloc(r.sx*r.sz * sizeof(int));
+    if (!ids)
+        return -1;
     memset(ids, -1, r.sx*r.sz * sizeof(int));
     if (tol <= 0)
         tol = 1;
     int step = tol;
-    struct locate_info_t info;
-    info.g = g;
-    info.ids = ids;
-    info.r = r;
-    info.stop = stop;
-    info.match = match;
-    info.tol = tol;
 
     if (g->mc >= MC_1_18)
     {
@@ -4500,12 +5906,37 @@ int getBiomeCenters(Pos *pos, int *siz, int nmax, Generator *g, Range r,
         if (tol == 1)
             step = 1 + floor(sqrt(minsiz) * 0.5);
 
+        // The climate limits of the biome rule out most of the area on a
+        // coarse grid. Only the tiles with candidates get generated, and
+        // they grow into their neighbors while the biome is within the
+        // tolerance of the tile border.
+        int ts = tol > 8 ? tol : 8;
+        int tw = (r.sx + ts-1) / ts;
+        int th = (r.sz + ts-1) / ts;
+        char *queued = (char*) calloc(tw * th, 1);
+        int *queue = (int*) malloc(tw * th * sizeof(int));
+        int *cache = NULL;
+        int qn = 0;
+        Range tr = { r.scale, 0, 0, ts, ts, r.y, 1 };
+        if (queued && queue)
+            cache = allocCache(g, tr);
+        if (!cache)
+        {
+            free(queue);
+            free(queued);
+            free(ids);
+            return -1;
+        }
+
         for (j = 0; j < r.sz; j += step)
         {
             for (i = 0; i < r.sx; i += step)
             {
                 if (stop && *stop)
                     break;
+                int t = (j / ts) * tw + (i / ts);
+                if (queued[t])
+                    continue;
                 for (k = 0; k < npara; k++)
                 {
                     const int *plim = lim + 2*para[k];
@@ -4516,14 +5947,65 @@ int getBiomeCenters(Pos *pos, int *siz, int nmax, Generator *g, Range r,
                     double pz = (r.z+j) * r.scale / 4.0;
                     int p = 10000 * sampleDoublePerlin(dpn, px, 0, pz);
                     if (p < plim[0] || p > plim[1])
-                    {
-                        ids[j*r.sx + i] = -2;
                         break;
-                    }
+                }
+                if (k == npara)
+                {
+                    queued[t] = 1;
+                    queue[qn++] = t;
+                }
+            }
+        }
+
+        while (qn > 0 && !(stop && *stop))
+        {
+            int t = queue[--qn];
+            int ti = t % tw, tj = t / tw;
+            tr.x = r.x + ti * ts;
+            tr.z = r.z + tj * ts;
+            tr.sx = r.sx - ti * ts < ts ? r.sx - ti * ts : ts;
+            tr.sz = r.sz - tj * ts < ts ? r.sz - tj * ts : ts;
+            genBiomes(g, cache, tr);
+
+            int reach = 0; // tile edges that the biome may bridge
+            for (j = 0; j < tr.sz; j++)
+            {
+                for (i = 0; i < tr.sx; i++)
+                {
+                    int id = cache[j*tr.sx + i];
+                    ids[(tj*ts + j) * r.sx + (ti*ts + i)] = id;
+                    if (id != match)
+                        continue;
+                    if (i < tol) reach |= 1;
+                    if (i >= tr.sx - tol) reach |= 2;
+                    if (j < tol) reach |= 4;
+                    if (j >= tr.sz - tol) reach |= 8;
+                }
+            }
+            int di, dj;
+            for (dj = -1; dj <= 1; dj++)
+            {
+                if (dj && !(reach & (dj < 0 ? 4 : 8)))
+                    continue;
+                if (tj + dj < 0 || tj + dj >= th)
+                    continue;
+                for (di = -1; di <= 1; di++)
+                {
+                    if (di && !(reach & (di < 0 ? 1 : 2)))
+                        continue;
+                    if (ti + di < 0 || ti + di >= tw)
+                        continue;
+                    int nt = (tj + dj) * tw + (ti + di);
+                    if (queued[nt])
+                        continue;
+                    queued[nt] = 1;
+                    queue[qn++] = nt;
                 }
             }
         }
-        match = -1; // id entries that are still -1 are our candidates
+        free(cache);
+        free(queue);
+        free(queued);
     }
     else // 1.17-
     {
@@ -4543,6 +6025,11 @@ int getBiomeCenters(Pos *pos, int *siz, int nmax, Generator *g, Range r,
 
         Range tr = { r.scale, 0, 0, ts, ts, 0, 1 };
         int *cache = allocCache(g, r);
+        if (!cache)
+        {
+            free(ids);
+            return -1;
+        }
 
         for (tj = 0; tj < th; tj++)
         {
@@ -4573,30 +6060,14 @@ int getBiomeCenters(Pos *pos, int *siz, int nmax, Generator *g, Range r,
             }
         }
         free(cache);
+        applySeed(g, DIM_OVERWORLD, g->seed);
     }
 
-    applySeed(g, DIM_OVERWORLD, g->seed);
-    for (j = 0; j < r.sz; j += step)
-    {
-        for (i = 0; i < r.sx; i += step)
-        {
-            if (stop && *stop)
-                break;
-            if (ids[j*r.sx + i] != match)
-                continue;
-            Pos center;
-            int area = floodFillGen(&info, i, j, &center);
-            if (area >= minsiz)
-            {
-                pos[n] = center;
-                if (siz) siz[n] = area;
-                if (++n >= nmax)
-                    goto L_end;
-            }
-        }
-    }
-
-L_end:
+    char interest[256] = {0};
+    if (match >= 0 && match < 256)
+        interest[match] = 1;
+    n = labelBiomeCenters(pos, siz, NULL, nmax, ids, NULL, r, interest,
+        minsiz, tol, 1, stop);
     free(ids);
 
     return n;
@@ -5567,53 +7038,313 @@ void getPossibleBiomesForLimits(char ids[256], int mc, int limits[6][2])
     }
 }
 
-int getLargestRec(int match, const int *ids, int sx, int sz, Pos *p0, Pos *p1)
+static inline int isRecMatch(const char *match, int id)
 {
-    typedef struct { int n, j, w; } entry_t;
-    entry_t *meta = (entry_t*) calloc(sx > sz ? sx : sz, sizeof(*meta));
-    int i, j, w, m, ret;
-    ret = m = 0;
+    return id >= 0 && id < 256 && (!match || match[id]);
+}
 
-    for (i = sx-1; i >= 0; i--)
+// Updates the heights of the matching runs that end in the given row, where
+// 'prev' is the row before it (nullable at the start).
+static void updateRecHeights(int *h, const int *row, const int *prev, int sx,
+    const char *match)
+{
+    int i;
+    for (i = 0; i < sx; i++)
     {
-        for (j = 0; j < sz; j++)
+        if (!isRecMatch(match, row[i]))
+            h[i] = 0;
+        else if (prev && prev[i] == row[i])
+            h[i]++;
+        else
+            h[i] = 1;
+    }
+}
+
+// Histogram stack pass over a row with the heights of the runs that end in
+// it. Runs of different biomes are separate histograms, so a change of biome
+// closes all open rectangles. The stack holds (start, height) pairs and needs
+// room for 2*sx entries.
+static void scanRecRow(const int *row, const int *h, int sx, int j,
+    int *stk, int *area, Pos *p0, Pos *p1)
+{
+    int i, m = 0, prev = -1;
+    for (i = 0; i <= sx; i++)
+    {
+        int n = i < sx ? h[i] : 0;
+        int id = n ? row[i] : -1;
+        int cut = id == prev ? n : 0;
+        int start = i;
+        while (m > 0 && stk[2*m-1] > cut)
         {
-            if (ids[j*sx + i] == match)
-                meta[j].n++;
-            else
-                meta[j].n = 0;
+            m--;
+            int si = stk[2*m];
+            int sh = stk[2*m+1];
+            int a = sh * (i - si);
+            if (a > area[prev])
+            {
+                area[prev] = a;
+                p0[prev].x = si;  p0[prev].z = j - sh + 1;
+                p1[prev].x = i-1; p1[prev].z = j;
+            }
+            start = si;
         }
-        for (w = j = 0; j < sz; j++)
+        if (id != prev)
+            start = i;
+        if (n > 0 && (m == 0 || stk[2*m-1] < n))
         {
-            int n = meta[j].n;
-            if (n > w)
+            stk[2*m] = start;
+            stk[2*m+1] = n;
+            m++;
+        }
+        prev = id;
+    }
+}
+
+STRUCT(largest_rec_t)
+{
+    const int *ids;
+    const uint8_t *ids8;
+    const char *match;
+    const Generator *g;
+    Range r;
+    int *band;
+    int sx, sz, threads;
+    int *area;
+    Pos *p0, *p1;
+    int err;
+};
+
+static inline int getRecCell(const largest_rec_t *b, size_t k)
+{
+    if (b->ids8)
+        return b->ids8[k] == 0xff ? -1 : b->ids8[k];
+    return b->ids[k];
+}
+
+static const int *getRecRow(const largest_rec_t *b, int j, int *buf)
+{
+    int i;
+    if (!b->ids8)
+        return b->ids + (size_t)j * b->sx;
+    for (i = 0; i < b->sx; i++)
+        buf[i] = getRecCell(b, (size_t)j * b->sx + i);
+    return buf;
+}
+
+static void getLargestRecShare(void *data, int t)
+{
+    largest_rec_t *b = (largest_rec_t*) data;
+    int sx = b->sx;
+    int j0 = (int)((int64_t)b->sz * t / b->threads);
+    int j1 = (int)((int64_t)b->sz * (t+1) / b->threads);
+    int *area = b->area + 256 * t;
+    Pos *p0 = b->p0 + 256 * t;
+    Pos *p1 = b->p1 + 256 * t;
+    int *h = (int*) malloc(5 * sx * sizeof(int));
+    int *stk = h + sx;
+    int *rows = stk + 2 * sx;
+    const int *row, *prev = NULL;
+    int i, j, k;
+
+    if (!h)
+    {
+        b->err = 1;
+        return;
+    }
+    for (j = j0; j < j1; j++)
+    {
+        row = getRecRow(b, j, rows + (j & 1) * sx);
+        if (j == j0)
+        {   // heights of the runs that continue into this strip from above
+            for (i = 0; i < sx; i++)
             {
-                meta[m].j = j;
-                meta[m].w = w;
-                m++;
-                w = n;
+                h[i] = 0;
+                if (!isRecMatch(b->match, row[i]))
+                    continue;
+                for (k = j; k >= 0 && getRecCell(b, (size_t)k*sx + i) == row[i]; k--)
+                    h[i]++;
             }
-            if (n == w)
-                continue;
-            do
+        }
+        else
+        {
+            updateRecHeights(h, row, prev, sx, b->match);
+        }
+        scanRecRow(row, h, sx, j, stk, area, p0, p1);
+        prev = row;
+    }
+    free(h);
+}
+
+static void genRecBandShare(void *data, int t)
+{
+    largest_rec_t *b = (largest_rec_t*) data;
+    Range r = b->r;
+    int j0 = (int)((int64_t)r.sz * t / b->threads);
+    int j1 = (int)((int64_t)r.sz * (t+1) / b->threads);
+    if (j1 <= j0)
+        return;
+    r.z += j0;
+    r.sz = j1 - j0;
+    int *cache = allocCache(b->g, r);
+    if (!cache || genBiomes(b->g, cache, r))
+    {
+        b->err = 1;
+        free(cache);
+        return;
+    }
+    memcpy(b->band + (size_t)j0 * r.sx, cache,
+        (size_t)r.sx * r.sz * sizeof(int));
+    free(cache);
+}
+
+static int mergeRecs(int *area, Pos *p0, Pos *p1, const largest_rec_t *b)
+{
+    int t, id, n = 0;
+    for (id = 0; id < 256; id++)
+    {
+        area[id] = 0;
+        for (t = 0; t < b->threads; t++)
+        {
+            int k = 256 * t + id;
+            if (b->area[k] > area[id])
             {
-                entry_t e = meta[--m];
-                int area = w * (j - e.j);
-                if (area > ret)
-                {
-                    p0->x = i; p0->z = e.j;
-                    p1->x = i+w-1; p1->z = j-1;
-                    ret = area;
-                }
-                w = e.w;
+                area[id] = b->area[k];
+                p0[id] = b->p0[k];
+                p1[id] = b->p1[k];
             }
-            while (n < w);
-            if ((w = n))
-                m++;
         }
+        n += area[id] > 0;
     }
-    free(meta);
-    return ret;
+    return n;
+}
+
+static int getLargestRecsImpl(int area[256], Pos p0[256], Pos p1[256],
+    const char *match, const int *ids, const uint8_t *ids8, int sx, int sz,
+    int threads)
+{
+    largest_rec_t b;
+    int n;
+
+    memset(area, 0, 256 * sizeof(int));
+    if (sx <= 0 || sz <= 0)
+        return 0;
+    if (threads < 1)
+        threads = 1;
+    if (threads > sz)
+        threads = sz;
+
+    memset(&b, 0, sizeof(b));
+    b.ids = ids;
+    b.ids8 = ids8;
+    b.match = match;
+    b.sx = sx;
+    b.sz = sz;
+    b.threads = threads;
+    b.area = (int*) calloc(256 * threads, sizeof(int) + 2 * sizeof(Pos));
+    if (!b.area)
+        return -1;
+    b.p0 = (Pos*) (b.area + 256 * threads);
+    b.p1 = b.p0 + 256 * threads;
+    runThreads(threads, getLargestRecShare, &b);
+    n = b.err ? -1 : mergeRecs(area, p0, p1, &b);
+    free(b.area);
+    return n;
+}
+
+int getLargestRecs(int area[256], Pos p0[256], Pos p1[256],
+    const char *match, const int *ids, int sx, int sz, int threads)
+{
+    return getLargestRecsImpl(area, p0, p1, match, ids, NULL, sx, sz, threads);
+}
+
+int getLargestRecs8(int area[256], Pos p0[256], Pos p1[256],
+    const char *match, const uint8_t *ids, int sx, int sz, int threads)
+{
+    return getLargestRecsImpl(area, p0, p1, match, NULL, ids, sx, sz, threads);
+}
+
+int getLargestRecsGen(int area[256], Pos p0[256], Pos p1[256],
+    const char *match, const Generator *g, Range r, int threads)
+{
+    enum { REC_BAND = 64 };
+    largest_rec_t b;
+    int i, j, k, n;
+
+    memset(area, 0, 256 * sizeof(int));
+    if (r.sx <= 0 || r.sz <= 0)
+        return 0;
+    if (r.sy < 1)
+        r.sy = 1;
+    if (threads < 1)
+        threads = 1;
+    if (threads > REC_BAND)
+        threads = REC_BAND;
+
+    int sx = r.sx;
+    int *band = (int*) malloc((REC_BAND + 4) * (size_t)sx * sizeof(int));
+    if (!band)
+        return -1;
+    int *prev = band + REC_BAND * (size_t)sx;
+    int *h = prev + sx;
+    int *stk = h + sx;
+
+    memset(&b, 0, sizeof(b));
+    b.band = band;
+    b.g = g;
+    b.r = r;
+    b.r.sy = 1;
+    b.threads = threads;
+
+    for (j = 0; j < r.sz; j += REC_BAND)
+    {
+        b.r.z = r.z + j;
+        b.r.sz = r.sz - j < REC_BAND ? r.sz - j : REC_BAND;
+        b.threads = threads < b.r.sz ? threads : b.r.sz;
+        runThreads(b.threads, genRecBandShare, &b);
+        if (b.err)
+        {
+            memset(area, 0, 256 * sizeof(int));
+            free(band);
+            return -1;
+        }
+
+        for (k = 0; k < b.r.sz; k++)
+        {
+            const int *row = band + (size_t)k * sx;
+            const int *last = k ? row - sx : j ? prev : NULL;
+            updateRecHeights(h, row, last, sx, match);
+            scanRecRow(row, h, sx, j+k, stk, area, p0, p1);
+        }
+        memcpy(prev, band + (size_t)(b.r.sz - 1) * sx, sx * sizeof(int));
+    }
+    free(band);
+
+    for (n = i = 0; i < 256; i++)
+    {
+        if (area[i] <= 0)
+            continue;
+        p0[i].x += r.x; p0[i].z += r.z;
+        p1[i].x += r.x; p1[i].z += r.z;
+        n++;
+    }
+    return n;
+}
+
+int getLargestRec(int match, const int *ids, int sx, int sz, Pos *p0, Pos *p1)
+{
+    char m[256] = {0};
+    int area[256];
+    Pos q0[256], q1[256];
+    if (match < 0 || match >= 256)
+        return 0;
+    m[match] = 1;
+    getLargestRecs(area, q0, q1, m, ids, sx, sz, 1);
+    if (area[match])
+    {
+        *p0 = q0[match];
+        *p1 = q1[match];
+    }
+    return area[match];
 }
 
 
@@ -101,6 +101,31 @@ STRUCT(Piece)
     Piece *next;
 };
 
+// Pieces of many structures, packed contiguously by structure
+STRUCT(PieceArena)
+{
+    Piece *pieces;
+    int npieces, piececap;
+    int *offset;    // structure i has pieces [offset[i], offset[i+1])
+    Pos *start;     // start chunk of each structure
+    int *stype;     // structure type of each structure
+    int nstructs, structcap;
+};
+
+// Index of the pieces in an arena by their bounding boxes
+enum { PIECE_INDEX_SHIFT = 6 }; // grid of 64x64 blocks
+STRUCT(PieceKey)
+{
+    int64_t key;    // grid cell of the lower bounding box corner
+    int piece;
+};
+STRUCT(PieceIndex)
+{
+    PieceKey *keys; // sorted by cell
+    int n;
+    int ext;        // largest horizontal extent of a piece
+};
+
 STRUCT(EndIsland)
 {
     int x, y, z;
@@ -255,6 +280,30 @@ int isSlimeChunk(uint64_t seed, int chunkX, int chunkZ)
     return nextInt(&rnd, 10) == 0;
 }
 
+/* Area maps of Mineshaft and Slime chunks for a rectangle of (chunkW x chunkH)
+ * chunks at (chunkX, chunkZ). The output is a bitmap of ((chunkW*chunkH+7)/8)
+ * bytes, where chunk (chunkX+i, chunkZ+j) is the bit (1 << (k & 7)) of byte
+ * bits[k >> 3] with k = j*chunkW + i. Mineshaft chunks are evaluated several
+ * at a time with integer bounds on the random values, and only the few
+ * possible candidates are resolved individually. Slime chunks share the seed
+ * terms of each row and column. The results are identical to getMineshafts()
+ * and isSlimeChunk(). Returns the number of set chunks (or -1 if allocation
+ * failed).
+ */
+int mapMineshaftChunks(uint8_t *bits, int mc, uint64_t seed,
+        int chunkX, int chunkZ, int chunkW, int chunkH);
+int mapSlimeChunks(uint8_t *bits, uint64_t seed,
+        int chunkX, int chunkZ, int chunkW, int chunkH);
+
+/* Finds the chunk in the rectangle (chunkW x chunkH) at (chunkX, chunkZ) with
+ * the most slime chunks within a distance of 'radius' chunks (a disk centered
+ * on the chunk, including itself). The disk is slid along the rows so that
+ * each step only updates its edges. The chunk is written to 'best' (nullable)
+ * and the number of slime chunks is returned (or -1 if allocation failed).
+ */
+int getBestSlimeChunk(uint64_t seed, int chunkX, int chunkZ,
+        int chunkW, int chunkH, int radius, Pos *best);
+
 /* Finds the position and size of the small end islands in a given chunk.
  * Returns the number of end islands found.
  */
@@ -303,6 +352,29 @@ Pos initFirstStronghold(StrongholdIter *sh, int mc, uint64_t s48);
  */
 int nextStronghold(StrongholdIter *sh, const Generator *g);
 
+/* Same as nextStronghold(), with the biome checks using the tile cache 'bc'
+ * (nullable) for the layered versions (B1.8 - 1.17), while 1.18+ does not use
+ * the cache. See locateBiomeCached().
+ */
+int nextStrongholdCached(StrongholdIter *sh, const Generator *g, BiomeCache *bc);
+
+/* Finds the accurate locations of the first 'n' strongholds of the world, in
+ * the same order as the iteration with nextStronghold().
+ * For 1.19.3+ the approximate positions are determined up front and the biome
+ * checks are split over the given number of 'threads', which share the
+ * generator. For earlier versions the checks depend on each other and are
+ * done in sequence.
+ *
+ * @pos     : output positions, should have room for 'n' entries
+ * @n       : maximum number of strongholds (128 at most, or 3 before 1.9)
+ * @g       : generator, initialized for Overworld generation
+ * @threads : number of threads for the biome checks
+ *
+ * Returns the number of strongholds written to 'pos', or -1 if the memory for
+ * the batched checks could not be allocated.
+ */
+int getStrongholds(Pos *pos, int n, const Generator *g, int threads);
+
 
 /* Finds the approximate spawn point in the world.
  * The random state 'rng' output can be NULL to ignore.
@@ -315,6 +387,12 @@ Pos estimateSpawn(const Generator *g, uint64_t *rng);
  */
 Pos getSpawn(const Generator *g);
 
+/* Variants of estimateSpawn() and getSpawn() that split the search over the
+ * given number of 'threads' (used for 1.18+). The results are the same.
+ */
+Pos estimateSpawnThreads(const Generator *g, uint64_t *rng, int threads);
+Pos getSpawnThreads(const Generator *g, int threads);
+
 
 /* Finds a suitable pseudo-random location in the specified area.
  * This function is used to determine the positions of spawn and strongholds.
@@ -332,6 +410,17 @@ Pos locateBiome(
         const Generator *g, int x, int y, int z, int radius,
         uint64_t validB, uint64_t validM, uint64_t *rng, int *passes);
 
+/* Same as locateBiome(), but the 1:4 biomes of the layered versions
+ * (B1.8 - 1.17) are taken from the tile cache 'bc' (nullable), such that
+ * overlapping searches share their generated areas. If a tile cannot be
+ * generated, the search restarts (with the initial rng) without the cache.
+ * For 1.18+ the biomes are sampled from the noise directly and the cache is
+ * not used. The spawn finders do a single search and do not take a cache.
+ */
+Pos locateBiomeCached(
+        const Generator *g, BiomeCache *bc, int x, int y, int z, int radius,
+        uint64_t validB, uint64_t validM, uint64_t *rng, int *passes);
+
 /* Get the shadow seed.
  */
 static inline uint64_t getShadow(uint64_t seed)
@@ -349,12 +438,62 @@ static inline uint64_t getShadow(uint64_t seed)
  * whether a structure of the given type could spawn there. You can get the
  * block positions using getStructurePos().
  * The generator, 'g', should be initialized for the correct MC version,
- * dimension and seed. The generator may be temporarily modified during the
- * function call, but will be restored upon return.
+ * dimension and seed. The generator is not modified.
  * The 'flags' argument is optional structure specific information, such as the
  * biome variant for villages.
+ * Each thread keeps a ViableContext for the last generator it checked, so the
+ * layer stack is only copied when the generator, seed, version or flags
+ * change. Layers that are modified by hand are therefore not seen until the
+ * seed changes. (Without thread-local storage, the copy is made on every call
+ * and hot loops should use isViableStructurePosCtx() or areViableStructurePos().)
+ */
+int isViableStructurePos(int structType, const Generator *g, int blockX, int blockZ, uint32_t flags);
+
+/* A ViableContext allows a single seeded Generator to be shared between
+ * threads for structure viability checks. For 1.17 and below, the context
+ * holds its own copy of the layer stack, where the biome layers are replaced
+ * with early-out viability checks, along with a scratch buffer, so that the
+ * Generator itself is only read. The copy is made on first use and again
+ * whenever the seed of the Generator changes. Each thread should use its own
+ * context, which should not be copied (the layers link to each other).
+ */
+STRUCT(ViableContext)
+{
+    const Generator *g;
+    int synced;
+    int mc, dim;
+    uint32_t flags;
+    uint64_t seed;
+    Layer layers[L_NUM];
+    Layer xlayer[5];
+    int data[2];            // structure type and version for the checks
+    const Layer *entry;     // entry layer of the current check
+    int *buf;
+    size_t bufsiz;
+    const int *area;        // optional biome layer at 1:256 shared by a batch
+    int ax, az, aw, ah;
+};
+
+void initViableContext(ViableContext *vc, const Generator *g);
+void freeViableContext(ViableContext *vc);
+
+/* Same as isViableStructurePos(), but for the const Generator of the context.
  */
-int isViableStructurePos(int structType, Generator *g, int blockX, int blockZ, uint32_t flags);
+int isViableStructurePosCtx(int structType, ViableContext *vc,
+        int blockX, int blockZ, uint32_t flags);
+
+/* Checks the viability of 'n' structure candidates on the seeded generator,
+ * where candidate i is of type 'types[i]' at block position 'pos[i]', with the
+ * optional 'flags[i]' (flags may be NULL). The result of
+ * isViableStructurePos() for each candidate is written to 'viable[i]'.
+ * Candidates are checked in groups of nearby positions, where each group
+ * shares one generation of the 1:256 biome layer for 1.17 and below, and
+ * duplicate candidates are checked once. The groups are distributed over
+ * 'threads' threads, which share the (unmodified) generator.
+ * Returns the number of viable candidates, or -1 if allocation failed.
+ */
+int areViableStructurePos(const Generator *g, int n, const int *types,
+        const Pos *pos, const uint32_t *flags, int *viable, int threads);
 
 /* Checks if the specified structure type could generate in the given biome.
  */
@@ -363,8 +502,9 @@ int isViableFeatureBiome(int mc, int structureType, int biomeID);
 /* Some structures in 1.18 now only spawn if the surface is sufficiently high
  * at all four bounding box corners. This affects primarily Desert_Pyramids,
  * Jungle_Temples and Mansions.
- * Currently cubiomes does not provide overworld surface height and cannot
- * check it, but we can rule out some unlikely positions based biomes.
+ * This check uses the coarse surface estimate of mapApproxHeightFast() at the
+ * corners, with a margin of 8 blocks, so it only rules out positions that are
+ * clearly too low.
  *
  * This function is meant only for the 1.18 Overworld and is subject to change.
  */
@@ -377,6 +517,24 @@ int isViableStructureTerrain(int structType, Generator *g, int blockX, int block
 int isViableEndCityTerrain(const Generator *g, const SurfaceNoise *sn,
         int blockX, int blockZ);
 
+/* Variants of the End terrain checks that sample the noise columns through an
+ * EndTerrain context (see initEndTerrain()), so that nearby queries of the same
+ * seed reuse them. isViableEndCityTerrainCached() is the same check as
+ * isViableEndCityTerrain(), for the world seed 'seed'.
+ *
+ * getEndSurfaceHeightsAt() gets the surface height (not including the small
+ * End islands, and zero for the void) at each of the 'n' block positions,
+ * and areViableEndCityTerrain() checks the terrain of 'n' End City candidates,
+ * writing the results to 'viable'. Both process the positions in an order
+ * that keeps the cache warm. The former returns zero on success, and the
+ * latter the number of viable candidates, or -1 if allocation failed.
+ */
+int isViableEndCityTerrainCached(EndTerrain *et, uint64_t seed,
+        int blockX, int blockZ);
+int getEndSurfaceHeightsAt(EndTerrain *et, int n, const Pos *pos, float *y);
+int areViableEndCityTerrain(EndTerrain *et, uint64_t seed, int n,
+        const Pos *pos, int *viable);
+
 
 //==============================================================================
 // Finding Properties of Structures
@@ -437,7 +595,8 @@ enum
 };
 
 /* Generate the structure pieces of a Nether Fortress. The maximum number of
- * pieces that are generated is limited to 'n'. A buffer length of around 400
+ * pieces that are generated is limited to 'n' (the generation is incomplete if
+ * the limit is reached). A buffer length of around 400
  * should be sufficient in practice, but a fortress can in theory contain many
  * more than that. The number of generated pieces is given by the return value.
  */
@@ -462,6 +621,48 @@ enum
     PIECE_COUNT,
 };
 
+/* A PieceArena collects the pieces of any number of End Cities and Fortresses
+ * in one growing buffer, without a fixed limit per structure. The pieces of
+ * structure i are pa->pieces[pa->offset[i] .. pa->offset[i+1]-1], and the
+ * Piece.next links are not used (NULL). Initialize an arena with
+ * initPieceArena() and release it with freePieceArena(). A cleared arena keeps
+ * its buffers for reuse.
+ *
+ * addStructurePieces() generates the structure at the start chunk and appends
+ * its pieces, returning their number, or -1 for an unsupported structure type
+ * or if allocation failed.
+ *
+ * addStructurePiecesInArea() appends all viable structures of the type with a
+ * start position in the block area [x0,x1] x [z0,z1] on the seeded generator.
+ * For End Cities the terrain is checked as well if an EndTerrain context is
+ * given (nullable). Returns the number of added structures or -1 on failure.
+ */
+void initPieceArena(PieceArena *pa);
+void freePieceArena(PieceArena *pa);
+void clearPieceArena(PieceArena *pa);
+int addStructurePieces(PieceArena *pa, int structType, int mc, uint64_t seed,
+        int chunkX, int chunkZ);
+int addStructurePiecesInArea(PieceArena *pa, int structType,
+        const Generator *g, EndTerrain *et, int x0, int z0, int x1, int z1);
+
+/* Builds a bounding box index for the current pieces of an arena, which has to
+ * be rebuilt when pieces are added. Returns zero, or -1 if allocation failed.
+ *
+ * queryPieceIndex() finds the pieces whose bounding box is within a horizontal
+ * distance 'r' of the block position (x,z). The search can be restricted to a
+ * structure type and piece type (e.g. End_City and END_SHIP), where a negative
+ * value matches any type. Up to 'nmax' piece indices are written to 'out', and
+ * the total number of matches is returned.
+ *
+ * getPieceStructure() gives the structure in the arena that a piece belongs to.
+ */
+int buildPieceIndex(PieceIndex *pi, const PieceArena *pa);
+void freePieceIndex(PieceIndex *pi);
+int queryPieceIndex(const PieceIndex *pi, const PieceArena *pa,
+        int structType, int pieceType, int x, int z, int r,
+        int *out, int nmax);
+int getPieceStructure(const PieceArena *pa, int piece);
+
 /* Find the 20 fixed inner positions where End Gateways generate upon defeating
  * the Dragon. The positions are written to 'src' in generation order.
  */
@@ -474,6 +675,11 @@ Pos getLinkedGatewayChunk(const EndNoise *en, const SurfaceNoise *sn,
     uint64_t seed, Pos src, Pos *dst);
 Pos getLinkedGatewayPos(const EndNoise *en, const SurfaceNoise *sn,
     uint64_t seed, Pos src);
+/* Same as above, with the terrain sampled through an EndTerrain context.
+ */
+Pos getLinkedGatewayChunkCached(EndTerrain *et, uint64_t seed,
+    Pos src, Pos *dst);
+Pos getLinkedGatewayPosCached(EndTerrain *et, uint64_t seed, Pos src);
 
 
 /* Find the number of each type of house that generate in a village
@@ -628,6 +834,11 @@ int checkForBiomesAtLayer(
 int checkForTemps(LayerStack *g, uint64_t seed, int x, int z, int w, int h, const int tc[9]);
 
 /* Find the center positions for a given biome id.
+ * The areas are connected as in getBiomeCentersIds() and are listed in the
+ * order of their first cell (row-major). Areas of the biome that are separated
+ * by a gap of fewer than 'tol' cells are joined, regardless of the order in
+ * which they are found; the older flood fill could split such areas, so for
+ * tol > 1 there can be fewer, larger areas than before.
  * @pos     : output biome center positions
  * @siz     : output size of biomes (nullable)
  * @nmax    : maximum number of output entries
@@ -637,7 +848,8 @@ int checkForTemps(LayerStack *g, uint64_t seed, int x, int z, int w, int h, cons
  * @minsiz  : minimum size of output biomes
  * @tol     : border tolerance
  * @stop    : stopping flag (nullable)
- * Returns the number of entries written to pos and siz.
+ * Returns the number of entries written to pos and siz, or -1 if the buffers
+ * could not be allocated.
  */
 int getBiomeCenters(
         Pos           * pos,
@@ -651,6 +863,64 @@ int getBiomeCenters(
         volatile char * stop
         );
 
+/* Find the centers of the connected areas of all the biomes of interest in a
+ * pre-generated buffer of biome ids, such as from genBiomes(), in a single
+ * labeling pass. Each cell of another biome is labeled with the nearest biome
+ * of interest by (4-connected) distance, if that is less than the tolerance,
+ * and two neighboring cells connect when they share a label and the sum of
+ * their distances is below 'tol'. Thus areas of the same biome join across
+ * gaps of fewer than 'tol' cells; tol <= 1 only connects adjacent cells. The
+ * border cells do not count towards the size or center, and another biome of
+ * interest is never a border. The rows are labeled in strips on separate
+ * threads, that are merged at the end. Areas are listed in the order of their
+ * first cell in row-major order (z, then x), which is independent of the
+ * number of threads.
+ * @pos     : output biome center positions
+ * @siz     : output size of biomes (nullable)
+ * @bid     : output biome id of each area (nullable)
+ * @nmax    : maximum number of output entries
+ * @ids     : biome ids of the area, with r.sx * r.sz entries
+ * @r       : area of the ids, with sy = 1 (positions are scaled by r.scale)
+ * @validB  : biomes of interest as bitmask for biome ids [0,64)
+ * @validM  : biomes of interest as bitmask for biome ids [128,192)
+ * @minsiz  : minimum size of output biomes
+ * @tol     : border tolerance
+ * @threads : number of threads to use
+ * @stop    : stopping flag (nullable)
+ * Returns the number of entries written to pos, siz and bid, or -1 if the
+ * buffers could not be allocated.
+ */
+int getBiomeCentersIds(
+        Pos           * pos,
+        int           * siz,
+        int           * bid,
+        int             nmax,
+        const int     * ids,
+        Range           r,
+        uint64_t        validB,
+        uint64_t        validM,
+        int             minsiz,
+        int             tol,
+        int             threads,
+        volatile char * stop
+        );
+
+/// same as getBiomeCentersIds() for the compact ids of genBiomes8()
+int getBiomeCentersIds8(
+        Pos           * pos,
+        int           * siz,
+        int           * bid,
+        int             nmax,
+        const uint8_t * ids,
+        Range           r,
+        uint64_t        validB,
+        uint64_t        validM,
+        int             minsiz,
+        int             tol,
+        int             threads,
+        volatile char * stop
+        );
+
 /* Checks if a biome may generate given a version and layer ID as entry point.
  * The supported layers are:
  * L_BIOME_256, L_BAMBOO_256, L_BIOME_EDGE_64, L_HILLS_64, L_SUNFLOWER_64,
@@ -738,6 +1008,33 @@ void getPossibleBiomesForLimits(char ids[256], int mc, int limits[6][2]);
  */
 int getLargestRec(int match, const int *ids, int sx, int sz, Pos *p0, Pos *p1);
 
+/**
+ * Finds the largest rectangle for each biome in ids[sx][sz] in a single pass.
+ * The biomes of interest are marked non-zero in 'match' (nullable for all).
+ * For every biome, its rectangle's area is written to area[id] (or zero if
+ * there is none) and its limit corners to p0[id] and p1[id]. The rows are
+ * split into strips that are processed on separate threads. Returned is the
+ * number of biomes that were found, or -1 if the memory could not be allocated
+ * (with all areas zero).
+ */
+int getLargestRecs(int area[256], Pos p0[256], Pos p1[256],
+        const char *match, const int *ids, int sx, int sz, int threads);
+
+/// same as getLargestRecs() for the compact ids of genBiomes8()
+int getLargestRecs8(int area[256], Pos p0[256], Pos p1[256],
+        const char *match, const uint8_t *ids, int sx, int sz, int threads);
+
+/**
+ * Variant of getLargestRecs() that generates the area 'r' (with sy = 1) in
+ * bands of rows as it goes, so the full buffer of ids is never held in memory.
+ * The threads are used to generate each band. The corners are positions in
+ * the range, i.e. include the offset (r.x, r.z) at scale r.scale. Returns -1
+ * (with all areas zero) if the memory could not be allocated or a band could
+ * not be generated.
+ */
+int getLargestRecsGen(int area[256], Pos p0[256], Pos p1[256],
+        const char *match, const Generator *g, Range r, int threads);
+
 //==============================================================================
 // Implementaions for Functions that Ideally Should be Inlined
 //==============================================================================
@@ -97,7 +97,8 @@ void setupGenerator(Generator *g, int mc, uint32_t flags)
     }
 }
 
-void applySeed(Generator *g, int dim, uint64_t seed)
+static void applySeedImpl(Generator *g, int dim, uint64_t seed,
+    const uint64_t *sha)
 {
     g->dim = dim;
     g->seed = seed;
@@ -112,7 +113,11 @@ void applySeed(Generator *g, int dim, uint64_t seed)
         }
         else if (g->mc <= MC_1_17)
         {
-            setLayerSeed(g->entry ? g->entry : g->ls.entry_1, seed);
+            Layer *entry = g->entry ? g->entry : g->ls.entry_1;
+            if (sha)
+                setLayerSeedSHA(entry, seed, *sha);
+            else
+                setLayerSeed(entry, seed);
         }
         else // if (g->mc >= MC_1_18)
         {
@@ -129,13 +134,25 @@ void applySeed(Generator *g, int dim, uint64_t seed)
     }
     if (g->mc >= MC_1_15)
     {
-        if (g->mc <= MC_1_17 && dim == DIM_OVERWORLD && !g->entry)
+        if (sha)
+            g->sha = *sha;
+        else if (g->mc <= MC_1_17 && dim == DIM_OVERWORLD && !g->entry)
             g->sha = g->ls.entry_1->startSalt;
         else
             g->sha = getVoronoiSHA(seed);
     }
 }
 
+void applySeed(Generator *g, int dim, uint64_t seed)
+{
+    applySeedImpl(g, dim, seed, NULL);
+}
+
+void applySeedSHA(Generator *g, int dim, uint64_t seed, uint64_t sha)
+{
+    applySeedImpl(g, dim, seed, &sha);
+}
+
 
 size_t getMinCacheSize(const Generator *g, int scale, int sx, int sy, int sz)
 {
@@ -248,6 +265,189 @@ int getBiomeAt(const Generator *g, int scale, int x, int y, int z)
     return id;
 }
 
+// Compact generation works in tiles of about COMPACT_TILE^2 cells, so the
+// int scratch for the tile stays small regardless of the size of the range.
+// The Nether fill and the optimized 1.18+ climate search above 1:4 depend on
+// the extent of the range, so these are generated in one piece instead.
+enum { COMPACT_TILE = 512 };
+
+static int getCompactTileSize(const Generator *g, int scale, int sx, int sy,
+    int sz)
+{
+    if ((g->dim == DIM_NETHER && g->mc > MC_1_15) ||
+        (g->dim == DIM_OVERWORLD && g->mc >= MC_1_18 && scale > 4))
+        return sx > sz ? sx : sz;
+    int ts = COMPACT_TILE;
+    while (ts > 16 && (int64_t)ts * ts * sy > COMPACT_TILE * COMPACT_TILE)
+        ts >>= 1;
+    return ts;
+}
+
+size_t getMinCacheSize8(const Generator *g, int scale, int sx, int sy, int sz)
+{
+    if (sy == 0)
+        sy = 1;
+    int ts = getCompactTileSize(g, scale, sx, sy, sz);
+    size_t len = (size_t)sx * sy * sz;
+    size_t tlen = getMinCacheSize(g, scale, sx < ts ? sx : ts, sy,
+        sz < ts ? sz : ts);
+    if (tlen == 0)
+        return 0;
+    // the int scratch follows the output, aligned for its type
+    len = (len + sizeof(int) - 1) & ~(sizeof(int) - 1);
+    return len + tlen * sizeof(int);
+}
+
+uint8_t *allocCache8(const Generator *g, Range r)
+{
+    size_t len = getMinCacheSize8(g, r.scale, r.sx, r.sy, r.sz);
+    if (len == 0)
+        return NULL;
+    return (uint8_t*) calloc(len, 1);
+}
+
+void compactBiomeIds(uint8_t *dst, size_t dstride, const int *src,
+        size_t sstride, int w, int h)
+{
+    int i, j;
+    for (j = 0; j < h; j++, dst += dstride, src += sstride)
+    {
+        for (i = 0; i < w; i++)
+            dst[i] = (uint8_t) (src[i] >= 0 && src[i] < 256 ? src[i] : 0xff);
+    }
+}
+
+int genBiomes8(const Generator *g, uint8_t *cache, Range r)
+{
+    int sy = r.sy ? r.sy : 1;
+    int ts = getCompactTileSize(g, r.scale, r.sx, sy, r.sz);
+    size_t len = (size_t)r.sx * sy * r.sz;
+    len = (len + sizeof(int) - 1) & ~(sizeof(int) - 1);
+    int *scratch = (int*) (cache + len);
+    int i0, j0, k, err;
+
+    for (j0 = 0; j0 < r.sz; j0 += ts)
+    {
+        for (i0 = 0; i0 < r.sx; i0 += ts)
+        {
+            Range t = r;
+            t.x = r.x + i0;
+            t.z = r.z + j0;
+            t.sx = r.sx - i0 < ts ? r.sx - i0 : ts;
+            t.sz = r.sz - j0 < ts ? r.sz - j0 : ts;
+            err = genBiomes(g, scratch, t);
+            if (err)
+                return err;
+            for (k = 0; k < sy; k++)
+            {
+                compactBiomeIds(cache + ((size_t)k*r.sz + j0) * r.sx + i0, r.sx,
+                    scratch + (size_t)k * t.sx * t.sz, t.sx, t.sx, t.sz);
+            }
+        }
+    }
+    return 0;
+}
+
+void initBiomeCache(BiomeCache *bc)
+{
+    int i;
+    for (i = 0; i < BIOME_CACHE_SLOTS; i++)
+        bc->tiles[i].used = 0;
+    bc->scratch = NULL;
+    bc->scratchsiz = 0;
+}
+
+void freeBiomeCache(BiomeCache *bc)
+{
+    free(bc->scratch);
+    initBiomeCache(bc);
+}
+
+static int isBiomeCacheable(const Generator *g)
+{
+    return g->dim == DIM_OVERWORLD && g->mc >= MC_B1_8 && g->mc <= MC_1_17;
+}
+
+const int *getBiomeTile(const Generator *g, BiomeCache *bc, int tx, int tz)
+{
+    if (!isBiomeCacheable(g))
+        return NULL;
+
+    uint32_t hash = (uint32_t)tx * 0x9e3779b1 ^ (uint32_t)tz * 0x85ebca77;
+    hash ^= hash >> 16;
+    BiomeTile *t = &bc->tiles[hash & (BIOME_CACHE_SLOTS-1)];
+
+    if (t->used && t->x == tx && t->z == tz && t->seed == g->seed &&
+        t->mc == g->mc && t->flags == g->flags)
+    {
+        return t->ids;
+    }
+
+    const Layer *entry = getLayerForScale(g, 4);
+    size_t len = getLayerArenaSize(entry, BIOME_TILE, BIOME_TILE);
+    if (len > bc->scratchsiz)
+    {
+        free(bc->scratch);
+        bc->scratch = (int*) malloc(len * sizeof(int));
+        bc->scratchsiz = bc->scratch ? len : 0;
+        if (!bc->scratch)
+            return NULL;
+    }
+
+    t->used = 0;
+    if (genAreaArena(entry, t->ids, bc->scratch,
+            tx*BIOME_TILE, tz*BIOME_TILE, BIOME_TILE, BIOME_TILE))
+        return NULL;
+    t->seed = g->seed;
+    t->mc = g->mc;
+    t->flags = g->flags;
+    t->x = tx;
+    t->z = tz;
+    t->used = 1;
+    return t->ids;
+}
+
+int genBiomesCached(const Generator *g, BiomeCache *bc, int *cache, Range r)
+{
+    int i, j, k, tx, tz;
+
+    if (!bc || r.scale != 4 || !isBiomeCacheable(g))
+        return genBiomes(g, cache, r);
+
+    for (j = 0; j < r.sz; j = k)
+    {
+        tz = floordiv(r.z + j, BIOME_TILE);
+        k = (tz+1) * BIOME_TILE - r.z;
+        if (k > r.sz) k = r.sz;
+
+        for (i = 0; i < r.sx; )
+        {
+            tx = floordiv(r.x + i, BIOME_TILE);
+            int ox = r.x + i - tx*BIOME_TILE;
+            int n = BIOME_TILE - ox;
+            if (n > r.sx - i) n = r.sx - i;
+
+            const int *ids = getBiomeTile(g, bc, tx, tz);
+            if (!ids)
+                return 1;
+            int jj;
+            for (jj = j; jj < k; jj++)
+            {
+                int oz = r.z + jj - tz*BIOME_TILE;
+                memcpy(cache + (int64_t)jj*r.sx + i, ids + oz*BIOME_TILE + ox,
+                    n * sizeof(int));
+            }
+            i += n;
+        }
+    }
+    for (k = 1; k < r.sy; k++)
+    {   // overworld has no vertical noise: expanding 2D into 3D
+        memcpy(cache + (int64_t)k*r.sx*r.sz, cache,
+            (int64_t)r.sx*r.sz * sizeof(int));
+    }
+    return 0;
+}
+
 const Layer *getLayerForScale(const Generator *g, int scale)
 {
     if (g->mc > MC_1_17)
@@ -557,8 +757,8 @@ void setupLayerStack(LayerStack *g, int mc, int largeBiomes)
 }
 
 
-/* Recursively calculates the minimum buffer size required to generate an area
- * of the specified size from the current layer onwards.
+/* Recursively calculates a conservative buffer size required to generate an
+ * area of the specified size from the current layer onwards.
  */
 static void getMaxArea(
     const Layer *layer, int areaX, int areaZ, int *maxX, int *maxZ, size_t *siz)
@@ -592,20 +792,208 @@ static void getMaxArea(
         getMaxArea(layer->p2, areaX, areaZ, maxX, maxZ, siz);
 }
 
+/* Calculates the peak number of ints that a layer uses when it generates an
+ * area of 'w' by 'h' cells in place. The parent areas are taken at their
+ * largest over the possible alignments of the area. A layer writes its parent
+ * area to the start of the buffer, zoom layers then expand it behind the
+ * parent and multi-layers place the second parent behind the first area, so
+ * the peak is the maximum over these stages rather than their sum.
+ * Custom map functions fall back to the conservative estimate of getMaxArea().
+ */
+static size_t getLayerPeak(const Layer *l, size_t w, size_t h)
+{
+    size_t area = w * h;
+    size_t pw, ph, peak, sub;
+
+    if (l->getMap == mapZoom || l->getMap == mapZoomFuzzy)
+    {   // zoomed copy of the parent with twice the parent width and height
+        pw = ((w + 1) >> 1) + 1;
+        ph = ((h + 1) >> 1) + 1;
+        peak = 5 * pw * ph;
+        sub = getLayerPeak(l->p, pw, ph);
+        return sub > peak ? sub : peak;
+    }
+    if (l->getMap == mapVoronoi || l->getMap == mapVoronoi114)
+    {   // parent area next to the output area
+        pw = ((w + 3) >> 2) + 2;
+        ph = ((h + 3) >> 2) + 2;
+        peak = area + pw * ph;
+        if (l->p)
+        {
+            sub = getLayerPeak(l->p, pw, ph);
+            if (sub > peak) peak = sub;
+        }
+        return peak;
+    }
+    if (l->getMap == mapHills)
+    {   // rivers behind the parent area
+        pw = w + l->edge;
+        ph = h + l->edge;
+        peak = pw * ph + getLayerPeak(l->p2, pw, ph);
+        sub = getLayerPeak(l->p, pw, ph);
+        return sub > peak ? sub : peak;
+    }
+    if (l->getMap == mapRiverMix)
+    {   // rivers behind the output area
+        peak = area + getLayerPeak(l->p2, w, h);
+        sub = getLayerPeak(l->p, w, h);
+        return sub > peak ? sub : peak;
+    }
+    if (l->getMap == mapOceanMix)
+    {   // land, with a border of up to 'edge' cells, behind the ocean types
+        pw = w + l->edge;
+        ph = h + l->edge;
+        peak = area + getLayerPeak(l->p, pw, ph);
+        sub = getLayerPeak(l->p2, w, h);
+        return sub > peak ? sub : peak;
+    }
+    if (l->getMap == mapOceanMixMod)
+    {   // ocean types are copied to the heap
+        peak = getLayerPeak(l->p, w, h);
+        sub = getLayerPeak(l->p2, w, h);
+        return sub > peak ? sub : peak;
+    }
+    if (l->p2 || l->zoom != 1)
+    {
+        int maxX = w, maxZ = h;
+        size_t bufsiz = 0;
+        getMaxArea(l, w, h, &maxX, &maxZ, &bufsiz);
+        return bufsiz + maxX * (size_t)maxZ;
+    }
+    if (l->p == NULL)
+        return area;
+    // in-place layers transform their parent area
+    peak = getLayerPeak(l->p, w + l->edge, h + l->edge);
+    return area > peak ? area : peak;
+}
+
+/* Side length, at the scale of the parent layer, of the tiles in which large
+ * areas are generated. This bounds the scratch that genAreaArena() needs; it
+ * does not make the generation faster than a single pass.
+ */
+enum { LAYER_TILE = 512 };
+
+/* A voronoi entry gets tiles of 4*LAYER_TILE cells, so that its 1:4 parent is
+ * generated in LAYER_TILE tiles. Smaller 1:1 tiles regenerate the overlapping
+ * parent borders too often and made 1:1 areas about 25% slower.
+ */
+static int getLayerTile(const Layer *layer)
+{
+    return LAYER_TILE * layer->zoom;
+}
+
+static int isAreaTiled(const Layer *layer, int areaWidth, int areaHeight)
+{
+    int tile = getLayerTile(layer);
+    return areaWidth > 2*tile || areaHeight > 2*tile;
+}
+
+size_t getLayerArenaSize(const Layer *layer, int sizeX, int sizeZ)
+{
+    if (isAreaTiled(layer, sizeX, sizeZ))
+    {
+        int tile = getLayerTile(layer);
+        if (sizeX > tile) sizeX = tile;
+        if (sizeZ > tile) sizeZ = tile;
+    }
+    return getLayerPeak(layer, sizeX, sizeZ);
+}
+
 size_t getMinLayerCacheSize(const Layer *layer, int sizeX, int sizeZ)
 {
-    int maxX = sizeX, maxZ = sizeZ;
-    size_t bufsiz = 0;
-    getMaxArea(layer, sizeX, sizeZ, &maxX, &maxZ, &bufsiz);
-    return bufsiz + maxX * (size_t)maxZ;
+    return getLayerPeak(layer, sizeX, sizeZ);
+}
+
+/* Generates the area as a sequence of tiles. Each tile runs through the whole
+ * layer graph (including the secondary parents) in the 'scratch' buffer, and
+ * only the result of the entry layer is copied to 'out'. The layers depend
+ * only on the world position, so the output is the same as a single pass.
+ */
+static int genAreaTiled(const Layer *layer, int *out, int *scratch,
+    int areaX, int areaZ, int areaWidth, int areaHeight)
+{
+    int tile = getLayerTile(layer);
+    int i, j, err;
+    for (j = 0; j < areaHeight; j += tile)
+    {
+        int th = areaHeight - j < tile ? areaHeight - j : tile;
+        for (i = 0; i < areaWidth; i += tile)
+        {
+            int tw = areaWidth - i < tile ? areaWidth - i : tile;
+            int64_t k;
+            memset(scratch, 0, sizeof(*scratch)*tw*th);
+            err = layer->getMap(layer, scratch, areaX+i, areaZ+j, tw, th);
+            if (err)
+                return err;
+            for (k = 0; k < th; k++)
+            {
+                memcpy(out + (j+k)*(int64_t)areaWidth + i, scratch + k*tw,
+                    sizeof(*out)*tw);
+            }
+        }
+    }
+    return 0;
 }
 
 int genArea(const Layer *layer, int *out, int areaX, int areaZ, int areaWidth, int areaHeight)
 {
+    if (isAreaTiled(layer, areaWidth, areaHeight))
+    {   // large areas are tiled when the buffer has room for the tile scratch
+        size_t len = getLayerPeak(layer, areaWidth, areaHeight);
+        size_t area = (size_t)areaWidth * areaHeight;
+        if (getLayerArenaSize(layer, areaWidth, areaHeight) <= len - area)
+        {
+            return genAreaTiled(layer, out, out + area,
+                areaX, areaZ, areaWidth, areaHeight);
+        }
+    }
     memset(out, 0, sizeof(*out)*areaWidth*areaHeight);
     return layer->getMap(layer, out, areaX, areaZ, areaWidth, areaHeight);
 }
 
+int genAreaArena(const Layer *layer, int *out, int *arena,
+    int areaX, int areaZ, int areaWidth, int areaHeight)
+{
+    int err;
+    if (isAreaTiled(layer, areaWidth, areaHeight))
+    {
+        return genAreaTiled(layer, out, arena,
+            areaX, areaZ, areaWidth, areaHeight);
+    }
+    memset(arena, 0, sizeof(*arena)*areaWidth*areaHeight);
+    err = layer->getMap(layer, arena, areaX, areaZ, areaWidth, areaHeight);
+    if (err)
+        return err;
+    memcpy(out, arena, sizeof(*out)*areaWidth*areaHeight);
+    return 0;
+}
+
+
+// The 1.18+ estimate needs the blended noise of initSurfaceNoise118(). Other
+// (or no) surface noise is replaced by one for the seed of the generator.
+static int mapApproxHeight118(float *y, int *ids, const Generator *g,
+    const SurfaceNoise *sn, int x, int z, int w, int h, int coarse)
+{
+    if (g->bn.nptype != -1 && g->bn.nptype != NP_DEPTH)
+        return 1;
+    if (sn && isSurfaceNoise118(sn))
+        return mapSurfaceHeight118(y, ids, &g->bn, sn, x, z, w, h, coarse);
+    SurfaceNoise *sn118 = (SurfaceNoise*) malloc(sizeof(SurfaceNoise));
+    if (!sn118)
+        return -1;
+    initSurfaceNoise118(sn118, g->seed);
+    int err = mapSurfaceHeight118(y, ids, &g->bn, sn118, x, z, w, h, coarse);
+    free(sn118);
+    return err;
+}
+
+int mapApproxHeightFast(float *y, int *ids, const Generator *g,
+    const SurfaceNoise *sn, int x, int z, int w, int h)
+{
+    if (g->dim == DIM_OVERWORLD && g->mc >= MC_1_18)
+        return mapApproxHeight118(y, ids, g, sn, x, z, w, h, 1);
+    return mapApproxHeight(y, ids, g, sn, x, z, w, h);
+}
 
 int mapApproxHeight(float *y, int *ids, const Generator *g, const SurfaceNoise *sn,
     int x, int z, int w, int h)
@@ -622,22 +1010,7 @@ int mapApproxHeight(float *y, int *ids, const Generator *g, const SurfaceNoise *
 
     if (g->mc >= MC_1_18)
     {
-        if (g->bn.nptype != -1 && g->bn.nptype != NP_DEPTH)
-            return 1;
-        int64_t i, j;
-        for (j = 0; j < h; j++)
-        {
-            for (i = 0; i < w; i++)
-            {
-                int flags = 0;//SAMPLE_NO_SHIFT;
-                int64_t np[6];
-                int id = sampleBiomeNoise(&g->bn, np, x+i, 0, z+j, 0, flags);
-                if (ids)
-                    ids[j*w+i] = id;
-                y[j*w+i] = np[NP_DEPTH] / 76.0;
-            }
-        }
-        return 0;
+        return mapApproxHeight118(y, ids, g, sn, x, z, w, h, 0);
     }
     else if (g->mc <= MC_B1_7)
     {
@@ -12,6 +12,24 @@ enum
     FORCE_OCEAN_VARIANTS    = 0x4,
 };
 
+// Cache of generated 1:4 biome tiles for the layered generator (MC <= 1.17)
+enum { BIOME_TILE = 64, BIOME_CACHE_SLOTS = 64 };
+STRUCT(BiomeTile)
+{
+    uint64_t seed;
+    int mc;
+    uint32_t flags;
+    int used;
+    int x, z;
+    int ids[BIOME_TILE * BIOME_TILE];
+};
+STRUCT(BiomeCache)
+{
+    BiomeTile tiles[BIOME_CACHE_SLOTS];
+    int *scratch;
+    size_t scratchsiz;
+};
+
 STRUCT(Generator)
 {
     int mc;
@@ -63,6 +81,12 @@ void setupGenerator(Generator *g, int mc, uint32_t flags);
  */
 void applySeed(Generator *g, int dim, uint64_t seed);
 
+/**
+ * Same as applySeed(), but uses a precomputed 'sha' = getVoronoiSHA(seed),
+ * e.g. from getVoronoiSHABatch(), instead of hashing the seed again.
+ */
+void applySeedSHA(Generator *g, int dim, uint64_t seed, uint64_t sha);
+
 /**
  * Calculates the buffer size (number of ints) required to generate a cuboidal
  * volume of size (sx, sy, sz). If 'sy' is zero the buffer is calculated for a
@@ -87,6 +111,28 @@ int *allocCache(const Generator *g, Range r);
  * The return value is zero upon success.
  */
 int genBiomes(const Generator *g, int *cache, Range r);
+/**
+ * Compact variants of getMinCacheSize(), allocCache() and genBiomes() that
+ * output one byte per biome id, in the same layout as genBiomes(). Ids that do
+ * not fit into a byte, i.e. none (-1), are written as 0xff. The range is
+ * generated in tiles, so that apart from the output, the cache only needs room
+ * for the int scratch of a single tile. The cache size is in bytes.
+ * The output is the same as that of genBiomes() for the same range. For the
+ * Nether (1.16+) and for 1.18+ Overworld scales above 1:4, the biomes depend
+ * on the extent of the range, so these are not tiled and need the full int
+ * scratch, and genBiomes8() saves no memory there.
+ */
+size_t getMinCacheSize8(const Generator *g, int scale, int sx, int sy, int sz);
+uint8_t *allocCache8(const Generator *g, Range r);
+int genBiomes8(const Generator *g, uint8_t *cache, Range r);
+
+/* Converts a rectangle of w*h biome ids (with a row stride of 'sstride') into
+ * compact 8-bit ids (with a row stride of 'dstride'), where any id outside of
+ * [0, 256) becomes 0xff.
+ */
+void compactBiomeIds(uint8_t *dst, size_t dstride, const int *src,
+        size_t sstride, int w, int h);
+
 /**
  * Gets the biome for a specified scaled position. Note that the scale should
  * be either 1 or 4, for block or biome coordinates respectively.
@@ -94,6 +140,27 @@ int genBiomes(const Generator *g, int *cache, Range r);
  */
 int getBiomeAt(const Generator *g, int scale, int x, int y, int z);
 
+/**
+ * A BiomeCache keeps generated 1:4 biome tiles of BIOME_TILE cells for the
+ * layered Overworld generator (B1.8 - 1.17), keyed by the seed, version and
+ * flags of the generator, so that overlapping requests reuse the tiles. The
+ * cache is large (~1MB) and should be allocated on the heap. It is not
+ * thread-safe; each thread should use its own cache.
+ *
+ * getBiomeTile() returns the biome ids of the tile at (tx,tz), which covers
+ * the 1:4 cells [tx*BIOME_TILE, (tx+1)*BIOME_TILE) along x and likewise along
+ * z, indexed as ids[z*BIOME_TILE + x]. The pointer remains valid until the
+ * next access of the cache. Returns NULL if the generator is not supported or
+ * the tile could not be generated.
+ *
+ * genBiomesCached() is equivalent to genBiomes() and uses the cache for 1:4
+ * ranges of the layered generator. It returns non-zero if a tile fails.
+ */
+void initBiomeCache(BiomeCache *bc);
+void freeBiomeCache(BiomeCache *bc);
+const int *getBiomeTile(const Generator *g, BiomeCache *bc, int tx, int tz);
+int genBiomesCached(const Generator *g, BiomeCache *bc, int *cache, Range r);
+
 /**
  * Returns the default layer that corresponds to the given scale.
  * Supported scales are {0, 1, 4, 16, 64, 256}. A scale of zero indicates the
@@ -111,10 +178,17 @@ const Layer *getLayerForScale(const Generator *g, int scale);
 void setupLayerStack(LayerStack *g, int mc, int largeBiomes);
 
 /* Calculates the minimum size of the buffers required to generate an area of
- * dimensions 'sizeX' by 'sizeZ' at the specified layer.
+ * dimensions 'sizeX' by 'sizeZ' at the specified layer. This is the peak
+ * number of ints that the layer uses, as planned over its parent layers.
  */
 size_t getMinLayerCacheSize(const Layer *layer, int sizeX, int sizeZ);
 
+/* Calculates the size of the scratch arena (number of ints) that genAreaArena()
+ * requires for an area of 'sizeX' by 'sizeZ' at the specified layer. For large
+ * areas, which are generated in tiles, this does not grow with the area.
+ */
+size_t getLayerArenaSize(const Layer *layer, int sizeX, int sizeZ);
+
 /* Set up custom layers. */
 Layer *setupLayer(Layer *l, mapfunc_t *map, int mc,
     int8_t zoom, int8_t edge, uint64_t saltbase, Layer *p, Layer *p2);
@@ -123,17 +197,34 @@ Layer *setupLayer(Layer *l, mapfunc_t *map, int mc,
  * the biomeIDs in 'out'.
  * The biomeIDs will be indexed in the form: out[x + z*areaWidth]
  * It is recommended that 'out' is allocated using allocCache() for the correct
- * buffer size.
+ * buffer size. Large areas may be generated in tiles, using the remainder of
+ * the buffer as scratch; the output is the same as for a single pass.
  */
 int genArea(const Layer *layer, int *out, int areaX, int areaZ, int areaWidth, int areaHeight);
 
+/* Variant of genArea() that uses a separate, caller provided, scratch 'arena'
+ * of at least getLayerArenaSize() ints, such that 'out' only has to hold the
+ * areaWidth*areaHeight biomeIDs. The arena can be reused between calls.
+ */
+int genAreaArena(const Layer *layer, int *out, int *arena,
+    int areaX, int areaZ, int areaWidth, int areaHeight);
+
 /**
  * Map an approximation of the Overworld surface height.
  * The horizontal scaling is 1:4. If non-null, the ids are filled with the
  * biomes of the area. The height (written to y) is in blocks.
+ * For 1.18+ the estimate uses a SurfaceNoise initialized with
+ * initSurfaceNoise118(). Any other 'sn' (including one from initSurfaceNoise(),
+ * or NULL) is replaced by such a noise for the seed of the generator, which is
+ * initialized on each call, so repeated calls should pass it in. Here,
+ * mapApproxHeightFast() provides a coarser estimate, suitable for filtering,
+ * at a fraction of the cost (see mapSurfaceHeight118()). For other versions
+ * the two are the same.
  */
 int mapApproxHeight(float *y, int *ids, const Generator *g,
     const SurfaceNoise *sn, int x, int z, int w, int h);
+int mapApproxHeightFast(float *y, int *ids, const Generator *g,
+    const SurfaceNoise *sn, int x, int z, int w, int h);
 
 
 #ifdef __cplusplus
@@ -10,13 +10,13 @@
 // Essentials
 //==============================================================================
 
-void setLayerSeed(Layer *layer, uint64_t worldSeed)
+static void setLayerSeedImpl(Layer *layer, uint64_t worldSeed, const uint64_t *sha)
 {
     if (layer->p2 != NULL)
-        setLayerSeed(layer->p2, worldSeed);
+        setLayerSeedImpl(layer->p2, worldSeed, sha);
 
     if (layer->p != NULL)
-        setLayerSeed(layer->p, worldSeed);
+        setLayerSeedImpl(layer->p, worldSeed, sha);
 
     if (layer->noise != NULL)
     {
@@ -33,7 +33,7 @@ void setLayerSeed(Layer *layer, uint64_t worldSeed)
     }
     else if (ls == LAYER_INIT_SHA)
     {   // Post 1.14 Voronoi uses SHA256 for initialization
-        layer->startSalt = getVoronoiSHA(worldSeed);
+        layer->startSalt = sha ? *sha : getVoronoiSHA(worldSeed);
         layer->startSeed = 0;
     }
     else
@@ -48,6 +48,16 @@ void setLayerSeed(Layer *layer, uint64_t worldSeed)
     }
 }
 
+void setLayerSeed(Layer *layer, uint64_t worldSeed)
+{
+    setLayerSeedImpl(layer, worldSeed, NULL);
+}
+
+void setLayerSeedSHA(Layer *layer, uint64_t worldSeed, uint64_t sha)
+{
+    setLayerSeedImpl(layer, worldSeed, &sha);
+}
+
 
 //==============================================================================
 // Layers
@@ -1906,6 +1916,105 @@ void mapVoronoiPlane(uint64_t sha, int *out, int *src,
     }
 }
 
+void mapVoronoi3D(uint64_t sha, int *out, const int *src,
+    int x, int y, int z, int sx, int sy, int sz,
+    int px, int py, int pz, int psx, int psy, int psz)
+{
+    enum { VORONOI_CHUNK = 256, CELLS = VORONOI_CHUNK / 4 + 2 };
+    int ox[4][CELLS], oy[4][CELLS], oz[4][CELLS];
+    int uniform[CELLS];
+    const int *sv[4];
+    int i0, i1, j, j1, k, k1, jj, kk, i, q, c, n;
+
+    (void) psy;
+    x -= 2;
+    y -= 2;
+    z -= 2;
+
+    // The cells are indexed as c = (by << 1) | bz for the corners at (by,bz)
+    // and the x-offset bx is resolved by the lattice index q + bx.
+    for (i0 = 0; i0 < sx; i0 = i1)
+    {
+        i1 = i0 + VORONOI_CHUNK < sx ? i0 + VORONOI_CHUNK : sx;
+        int qx = (x + i0) >> 2;
+        int qn = ((x + i1 - 1) >> 2) - qx + 2;
+
+        for (k = 0; k < sy; k = k1)
+        {
+            int qy = (y + k) >> 2;
+            k1 = (qy + 1) * 4 - y;
+            if (k1 > sy) k1 = sy;
+
+            for (j = 0; j < sz; j = j1)
+            {
+                int qz = (z + j) >> 2;
+                j1 = (qz + 1) * 4 - z;
+                if (j1 > sz) j1 = sz;
+
+                // the cell offsets are shared by all blocks in the 1:4 cells
+                for (c = 0; c < 4; c++)
+                {
+                    int by = c >> 1, bz = c & 1;
+                    for (q = 0; q < qn; q++)
+                    {
+                        getVoronoiCell(sha, qx+q, qy+by, qz+bz,
+                            &ox[c][q], &oy[c][q], &oz[c][q]);
+                    }
+                    sv[c] = src + (int64_t)(qy+by-py)*psx*psz
+                        + (int64_t)(qz+bz-pz)*psx + (qx-px);
+                }
+                for (q = 0; q < qn-1; q++)
+                {
+                    int v = sv[0][q];
+                    int eq = 1;
+                    for (c = 0; c < 4; c++)
+                        eq &= (sv[c][q] == v) & (sv[c][q+1] == v);
+                    uniform[q] = eq;
+                }
+
+                for (kk = k; kk < k1; kk++)
+                {
+                    int dy = ((y + kk) & 3) * 10240;
+                    for (jj = j; jj < j1; jj++)
+                    {
+                        int dz = ((z + jj) & 3) * 10240;
+                        int *o = out + (int64_t)kk*sx*sz + (int64_t)jj*sx;
+
+                        for (i = i0; i < i1; i++)
+                        {
+                            int dx = ((x + i) & 3) * 10240;
+                            q = ((x + i) >> 2) - qx;
+                            if (uniform[q])
+                            {
+                                o[i] = sv[0][q];
+                                continue;
+                            }
+                            uint64_t dmin = (uint64_t)-1;
+                            int v = 0;
+                            // same order and tie breaking as voronoiAccess3D()
+                            for (n = 0; n < 8; n++)
+                            {
+                                int bx = n >> 2;
+                                c = n & 3;
+                                int rx = ox[c][q+bx] + dx - 40*1024*bx;
+                                int ry = oy[c][q+bx] + dy - 40*1024*(c >> 1);
+                                int rz = oz[c][q+bx] + dz - 40*1024*(c & 1);
+                                uint64_t d = rx*(uint64_t)rx + ry*(uint64_t)ry
+                                    + rz*(uint64_t)rz;
+                                int lt = d < dmin;
+                                dmin = lt ? d : dmin;
+                                v = lt ? sv[c][q+bx] : v;
+                            }
+                            o[i] = v;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+
 int mapVoronoi(const Layer * l, int * out, int x, int z, int w, int h)
 {
     x -= 2;
@@ -1924,7 +2033,7 @@ int mapVoronoi(const Layer * l, int * out, int x, int z, int w, int h)
 
     int *src = out + (int64_t)w*h;
     memmove(src, out, sizeof(int)*pw*ph);
-    mapVoronoiPlane(l->startSalt, out, src, x,z,w,h, 0, px,pz,pw,ph);
+    mapVoronoiPlane(l->startSalt, out, src, x+2,z+2,w,h, 0, px,pz,pw,ph);
 
     return 0;
 }
@@ -2056,31 +2165,31 @@ int mapVoronoi114(const Layer * l, int * out, int x, int z, int w, int h)
 }
 
 
+static const uint32_t g_sha_k[64] = {
+    0x428a2f98,0x71374491, 0xb5c0fbcf,0xe9b5dba5,
+    0x3956c25b,0x59f111f1, 0x923f82a4,0xab1c5ed5,
+    0xd807aa98,0x12835b01, 0x243185be,0x550c7dc3,
+    0x72be5d74,0x80deb1fe, 0x9bdc06a7,0xc19bf174,
+    0xe49b69c1,0xefbe4786, 0x0fc19dc6,0x240ca1cc,
+    0x2de92c6f,0x4a7484aa, 0x5cb0a9dc,0x76f988da,
+    0x983e5152,0xa831c66d, 0xb00327c8,0xbf597fc7,
+    0xc6e00bf3,0xd5a79147, 0x06ca6351,0x14292967,
+    0x27b70a85,0x2e1b2138, 0x4d2c6dfc,0x53380d13,
+    0x650a7354,0x766a0abb, 0x81c2c92e,0x92722c85,
+    0xa2bfe8a1,0xa81a664b, 0xc24b8b70,0xc76c51a3,
+    0xd192e819,0xd6990624, 0xf40e3585,0x106aa070,
+    0x19a4c116,0x1e376c08, 0x2748774c,0x34b0bcb5,
+    0x391c0cb3,0x4ed8aa4a, 0x5b9cca4f,0x682e6ff3,
+    0x748f82ee,0x78a5636f, 0x84c87814,0x8cc70208,
+    0x90befffa,0xa4506ceb, 0xbef9a3f7,0xc67178f2,
+};
+static const uint32_t g_sha_b[8] = {
+    0x6a09e667,0xbb67ae85, 0x3c6ef372,0xa54ff53a,
+    0x510e527f,0x9b05688c, 0x1f83d9ab,0x5be0cd19,
+};
+
 uint64_t getVoronoiSHA(uint64_t seed)
 {
-    static const uint32_t K[64] = {
-        0x428a2f98,0x71374491, 0xb5c0fbcf,0xe9b5dba5,
-        0x3956c25b,0x59f111f1, 0x923f82a4,0xab1c5ed5,
-        0xd807aa98,0x12835b01, 0x243185be,0x550c7dc3,
-        0x72be5d74,0x80deb1fe, 0x9bdc06a7,0xc19bf174,
-        0xe49b69c1,0xefbe4786, 0x0fc19dc6,0x240ca1cc,
-        0x2de92c6f,0x4a7484aa, 0x5cb0a9dc,0x76f988da,
-        0x983e5152,0xa831c66d, 0xb00327c8,0xbf597fc7,
-        0xc6e00bf3,0xd5a79147, 0x06ca6351,0x14292967,
-        0x27b70a85,0x2e1b2138, 0x4d2c6dfc,0x53380d13,
-        0x650a7354,0x766a0abb, 0x81c2c92e,0x92722c85,
-        0xa2bfe8a1,0xa81a664b, 0xc24b8b70,0xc76c51a3,
-        0xd192e819,0xd6990624, 0xf40e3585,0x106aa070,
-        0x19a4c116,0x1e376c08, 0x2748774c,0x34b0bcb5,
-        0x391c0cb3,0x4ed8aa4a, 0x5b9cca4f,0x682e6ff3,
-        0x748f82ee,0x78a5636f, 0x84c87814,0x8cc70208,
-        0x90befffa,0xa4506ceb, 0xbef9a3f7,0xc67178f2,
-    };
-    static const uint32_t B[8] = {
-        0x6a09e667,0xbb67ae85, 0x3c6ef372,0xa54ff53a,
-        0x510e527f,0x9b05688c, 0x1f83d9ab,0x5be0cd19,
-    };
-
     uint32_t m[64];
     uint32_t a0,a1,a2,a3,a4,a5,a6,a7;
     uint32_t i, x, y;
@@ -2100,18 +2209,18 @@ uint64_t getVoronoiSHA(uint64_t seed)
         m[i] += rotr32(x,17) ^ rotr32(x,19) ^ (x >> 10);
     }
 
-    a0 = B[0];
-    a1 = B[1];
-    a2 = B[2];
-    a3 = B[3];
-    a4 = B[4];
-    a5 = B[5];
-    a6 = B[6];
-    a7 = B[7];
+    a0 = g_sha_b[0];
+    a1 = g_sha_b[1];
+    a2 = g_sha_b[2];
+    a3 = g_sha_b[3];
+    a4 = g_sha_b[4];
+    a5 = g_sha_b[5];
+    a6 = g_sha_b[6];
+    a7 = g_sha_b[7];
 
     for (i = 0; i < 64; i++)
     {
-        x = a7 + K[i] + m[i];
+        x = a7 + g_sha_k[i] + m[i];
         x += rotr32(a4,6) ^ rotr32(a4,11) ^ rotr32(a4,25);
         x += (a4 & a5) ^ (~a4 & a6);
 
@@ -2128,12 +2237,90 @@ uint64_t getVoronoiSHA(uint64_t seed)
         a0 = x + y;
     }
 
-    a0 += B[0];
-    a1 += B[1];
+    a0 += g_sha_b[0];
+    a1 += g_sha_b[1];
 
     return BSWAP32(a0) | ((uint64_t)BSWAP32(a1) << 32);
 }
 
+void getVoronoiSHABatch(uint64_t *sha, const uint64_t *seeds, int n)
+{
+    enum { SHA_LANES = 8 };
+    uint32_t m[64][SHA_LANES];
+    uint32_t a[8][SHA_LANES];
+    uint32_t x, y;
+    int i, j, k, b;
+
+    for (k = 0; k < SHA_LANES; k++)
+    {
+        m[2][k] = 0x80000000;
+        for (i = 3; i < 15; i++)
+            m[i][k] = 0;
+        m[15][k] = 0x00000040;
+    }
+
+    for (b = 0; b < n; b += SHA_LANES)
+    {
+        int cnt = n - b < SHA_LANES ? n - b : SHA_LANES;
+
+        for (k = 0; k < SHA_LANES; k++)
+        {   // unused lanes repeat the first seed of the batch
+            uint64_t seed = seeds[b + (k < cnt ? k : 0)];
+            m[0][k] = BSWAP32((uint32_t)(seed));
+            m[1][k] = BSWAP32((uint32_t)(seed >> 32));
+        }
+
+        for (i = 16; i < 64; ++i)
+        {
+            for (k = 0; k < SHA_LANES; k++)
+            {
+                uint32_t v = m[i - 7][k] + m[i - 16][k];
+                x = m[i - 15][k];
+                v += rotr32(x,7) ^ rotr32(x,18) ^ (x >> 3);
+                x = m[i - 2][k];
+                v += rotr32(x,17) ^ rotr32(x,19) ^ (x >> 10);
+                m[i][k] = v;
+            }
+        }
+
+        for (j = 0; j < 8; j++)
+            for (k = 0; k < SHA_LANES; k++)
+                a[j][k] = g_sha_b[j];
+
+        for (i = 0; i < 64; i++)
+        {
+            for (k = 0; k < SHA_LANES; k++)
+            {
+                uint32_t a0 = a[0][k], a1 = a[1][k], a2 = a[2][k];
+                uint32_t a4 = a[4][k], a5 = a[5][k], a6 = a[6][k];
+
+                x = a[7][k] + g_sha_k[i] + m[i][k];
+                x += rotr32(a4,6) ^ rotr32(a4,11) ^ rotr32(a4,25);
+                x += (a4 & a5) ^ (~a4 & a6);
+
+                y = rotr32(a0,2) ^ rotr32(a0,13) ^ rotr32(a0,22);
+                y += (a0 & a1) ^ (a0 & a2) ^ (a1 & a2);
+
+                a[7][k] = a6;
+                a[6][k] = a5;
+                a[5][k] = a4;
+                a[4][k] = a[3][k] + x;
+                a[3][k] = a2;
+                a[2][k] = a1;
+                a[1][k] = a0;
+                a[0][k] = x + y;
+            }
+        }
+
+        for (k = 0; k < cnt; k++)
+        {
+            uint32_t lo = a[0][k] + g_sha_b[0];
+            uint32_t hi = a[1][k] + g_sha_b[1];
+            sha[b + k] = BSWAP32(lo) | ((uint64_t)BSWAP32(hi) << 32);
+        }
+    }
+}
+
 void voronoiAccess3D(uint64_t sha, int x, int y, int z, int *x4, int *y4, int *z4)
 {
     x -= 2;
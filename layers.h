@@ -133,6 +133,8 @@ extern "C"
 
 /* Applies the given world seed to the layer and all dependent layers. */
 void setLayerSeed(Layer *layer, uint64_t worldSeed);
+/* Same as setLayerSeed(), but with the precomputed getVoronoiSHA(worldSeed). */
+void setLayerSeedSHA(Layer *layer, uint64_t worldSeed, uint64_t sha);
 
 //==============================================================================
 // Layers
@@ -177,6 +179,9 @@ mapfunc_t mapVoronoi114;
 // It is seeded by the first 8-bytes of the SHA-256 hash of the world seed.
 ATTR(const)
 uint64_t getVoronoiSHA(uint64_t worldSeed);
+// Hashes 'n' seeds together, which vectorizes across the seeds. The results
+// are written to 'sha' and are the same as getVoronoiSHA() for each seed.
+void getVoronoiSHABatch(uint64_t *sha, const uint64_t *seeds, int n);
 void voronoiAccess3D(uint64_t sha, int x, int y, int z, int *x4, int *y4, int *z4);
 
 // Applies a 2D voronoi mapping at height 'y' to a 'src' plane, where
@@ -184,6 +189,15 @@ void voronoiAccess3D(uint64_t sha, int x, int y, int z, int *x4, int *y4, int *z
 void mapVoronoiPlane(uint64_t sha, int *out, int *src,
     int x, int z, int w, int h, int y, int px, int pz, int pw, int ph);
 
+// Applies the 3D voronoi mapping to a 'src' volume, where the src_range
+// [px,py,pz,psx,psy,psz] at scale 1:4 covers the out_range [x,y,z,sx,sy,sz].
+// The output is indexed as out[y*sx*sz + z*sx + x]. The cell offsets are
+// evaluated once per 1:4 cell and blocks within uniform cells are filled
+// directly.
+void mapVoronoi3D(uint64_t sha, int *out, const int *src,
+    int x, int y, int z, int sx, int sy, int sz,
+    int px, int py, int pz, int psx, int psy, int psz);
+
 
 #ifdef __cplusplus
 }
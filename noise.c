@@ -207,6 +207,100 @@ double samplePerlin(const PerlinNoise *noise, double d1, double d2, double d3,
     return lerp(t3, l1, l5);
 }
 
+/* Samples up to PERLIN_LANES points of a row that share the same (d2, d3)
+ * coordinates and adds 'amp' times the noise to 'v'. The hash lookups are done
+ * per point, but the y- and z-dependent values are only computed once and the
+ * interpolations run lane-wise, which allows them to be vectorized.
+ * The results are identical to samplePerlin(noise, x[k], d2, d3, 0, 0).
+ */
+static void samplePerlinLanes(const PerlinNoise *noise, double *v,
+        const double *x, double d2, double d3, double amp, int n)
+{
+    double t1[PERLIN_LANES];
+    double g[8][PERLIN_LANES];
+    uint8_t h2, h3;
+    double t2, t3;
+    int k;
+
+    if (d2 == 0.0)
+    {
+        d2 = noise->d2;
+        h2 = noise->h2;
+        t2 = noise->t2;
+    }
+    else
+    {
+        d2 += noise->b;
+        double i2 = floor(d2);
+        d2 -= i2;
+        h2 = (int) i2;
+        t2 = d2*d2*d2 * (d2 * (d2*6.0-15.0) + 10.0);
+    }
+
+    d3 += noise->c;
+    double i3 = floor(d3);
+    d3 -= i3;
+    h3 = (int) i3;
+    t3 = d3*d3*d3 * (d3 * (d3*6.0-15.0) + 10.0);
+
+    const uint8_t *idx = noise->d;
+
+    for (k = 0; k < n; k++)
+    {
+        double d1 = x[k] + noise->a;
+        double i1 = floor(d1);
+        uint8_t h1 = (int) i1;
+        d1 -= i1;
+        t1[k] = d1*d1*d1 * (d1 * (d1*6.0-15.0) + 10.0);
+
+        uint8_t a1 = idx[h1]   + h2;
+        uint8_t b1 = idx[h1+1] + h2;
+        uint8_t a2 = idx[a1]   + h3;
+        uint8_t b2 = idx[b1]   + h3;
+        uint8_t a3 = idx[a1+1] + h3;
+        uint8_t b3 = idx[b1+1] + h3;
+
+        g[0][k] = indexedLerp(idx[a2],   d1,   d2,   d3);
+        g[1][k] = indexedLerp(idx[b2],   d1-1, d2,   d3);
+        g[2][k] = indexedLerp(idx[a3],   d1,   d2-1, d3);
+        g[3][k] = indexedLerp(idx[b3],   d1-1, d2-1, d3);
+        g[4][k] = indexedLerp(idx[a2+1], d1,   d2,   d3-1);
+        g[5][k] = indexedLerp(idx[b2+1], d1-1, d2,   d3-1);
+        g[6][k] = indexedLerp(idx[a3+1], d1,   d2-1, d3-1);
+        g[7][k] = indexedLerp(idx[b3+1], d1-1, d2-1, d3-1);
+    }
+
+    for (k = 0; k < n; k++)
+    {
+        double l1 = lerp(t1[k], g[0][k], g[1][k]);
+        double l3 = lerp(t1[k], g[2][k], g[3][k]);
+        double l5 = lerp(t1[k], g[4][k], g[5][k]);
+        double l7 = lerp(t1[k], g[6][k], g[7][k]);
+        l1 = lerp(t2, l1, l3);
+        l5 = lerp(t2, l5, l7);
+        v[k] += amp * lerp(t3, l1, l5);
+    }
+}
+
+static void sampleOctaveLanes(const OctaveNoise *noise, double *v,
+        const double *x, double y, double z, int n)
+{
+    double ax[PERLIN_LANES];
+    int i, k;
+    for (k = 0; k < n; k++)
+        v[k] = 0;
+    for (i = 0; i < noise->octcnt; i++)
+    {
+        PerlinNoise *p = noise->octaves + i;
+        double lf = p->lacunarity;
+        for (k = 0; k < n; k++)
+            ax[k] = maintainPrecision(x[k] * lf);
+        double ay = maintainPrecision(y * lf);
+        double az = maintainPrecision(z * lf);
+        samplePerlinLanes(p, v, ax, ay, az, p->amplitude, n);
+    }
+}
+
 static
 void samplePerlinBeta17Terrain(const PerlinNoise *noise, double *v,
         double d1, double d3, double yLacAmp)
@@ -571,3 +665,22 @@ double sampleDoublePerlin(const DoublePerlinNoise *noise,
     return v * noise->amplitude;
 }
 
+void sampleDoublePerlinRow(const DoublePerlinNoise *noise, double *v,
+        const double *x, double y, double z, int n)
+{
+    const double f = 337.0 / 331.0;
+    double xf[PERLIN_LANES], va[PERLIN_LANES], vb[PERLIN_LANES];
+    int i, k, m;
+
+    for (i = 0; i < n; i += PERLIN_LANES)
+    {
+        m = n - i < PERLIN_LANES ? n - i : PERLIN_LANES;
+        for (k = 0; k < m; k++)
+            xf[k] = x[i+k] * f;
+        sampleOctaveLanes(&noise->octA, va, x+i, y, z, m);
+        sampleOctaveLanes(&noise->octB, vb, xf, y*f, z*f, m);
+        for (k = 0; k < m; k++)
+            v[i+k] = (va[k] + vb[k]) * noise->amplitude;
+    }
+}
+
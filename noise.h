@@ -4,6 +4,9 @@
 #include "rng.h"
 #include <math.h>
 
+// number of points that are sampled together by the row samplers
+#define PERLIN_LANES    8
+
 STRUCT(PerlinNoise)
 {
     uint8_t d[256+1];
@@ -77,6 +80,14 @@ int xDoublePerlinInit(DoublePerlinNoise *noise, Xoroshiro *xr,
 double sampleDoublePerlin(const DoublePerlinNoise *noise,
         double x, double y, double z);
 
+/* Samples 'n' points (x[i], y, z) which share the same y and z coordinates.
+ * The results are identical to sampleDoublePerlin(), but the coordinate
+ * dependent work of the row is shared and the interpolations are laid out to
+ * be vectorized. The output 'v' should hold 'n' values.
+ */
+void sampleDoublePerlinRow(const DoublePerlinNoise *noise, double *v,
+        const double *x, double y, double z, int n);
+
 
 #ifdef __cplusplus
 }
@@ -10,8 +10,6 @@
 
 #if defined(_WIN32)
 
-#include <windows.h>
-typedef HANDLE thread_id_t;
 #include <direct.h>
 #define IS_DIR_SEP(C)   ((C) == '/' || (C) == '\\')
 #define stat            _stat
@@ -28,9 +26,6 @@ typedef HANDLE thread_id_t;
 
 #else
 
-#define USE_PTHREAD
-#include <pthread.h>
-typedef pthread_t       thread_id_t;
 #define IS_DIR_SEP(C)   ((C) == '/')
 
 #endif
@@ -59,45 +54,984 @@ int getQuadHutCst(uint64_t low20)
     return CST_NONE;
 }
 
-// TODO: accurate seed testers for two or three structures in range
+// The tri-structure tables were generated by trying every set of positions
+// that is compatible with the lower 20 bits (which fix each position modulo 8
+// for a chunk range of 24) with isMultiBaseFeature() at radius 128.
+static const uint64_t low20TriHutNo00[] =
+{
+        0x1432,0x1434,0x1535,0x1547, 0x18e9,0x1a69,0x1e08,0x1e2c,
+        0x1f18,0x20c9,0x2181,0x2770, 0x292c,0x2950,0x2969,0x296e,
+        0x29ed,0x29f2,0x2aa9,0x2f0f, 0x2f98,0x2f9d,0x2fbb,0x3636,
+        0x36d9,0x36f4,0x3713,0x3718, 0x371d,0x3981,0x3e50,0x3e59,
+        0x3e74,0x3f3f,0x448c,0x44aa, 0x45ac,0x4df8,0x4e17,0x50e9,
+        0x5650,0x5659,0x566e,0x5674, 0x59d5,0x59e7,0x5cb9,0x65f2,
+        0x668a,0x6cac,0x7069,0x70c9, 0x7108,0x71c3,0x71e7,0x7588,
+        0x7849,0x7cd2,0x7dc3,0x7de7, 0x816d,0x8530,0x8535,0x854e,
+        0x8554,0x8559,0x8574,0x8d78, 0x8d97,0x94d4,0x94f8,0x94fd,
+        0x95c3,0x9c2e,0x9c54,0x9d01, 0x9d1a,0x9d25,0x9d2a,0xa221,
+        0xa6c1,0xa6c5,0xb158,0xb177, 0xb7b3,0xbb80,0xbd77,0xbf15,
+        0xcc20,0xcf95,0xcfb3,0xd558, 0xd577,0xd715,0xdf37,0xe1cf,
+        0xea82,0xec1e,0xec1f,0xed3e, 0xed40,0xefeb,0xf748,0xf886,
+        0xf9cf,0x1012b,0x10f43,0x11105, 0x111db,0x11585,0x11ae9,0x11cf0,
+        0x11de9,0x12269,0x12532,0x12534, 0x1254d,0x12552,0x12556,0x12576,
+        0x1272d,0x12732,0x127cc,0x127f0, 0x129ac,0x12d7a,0x134d6,0x134fa,
+        0x1395f,0x13c56,0x13ed9,0x13fa1, 0x148a9,0x149ce,0x15432,0x15456,
+        0x156ac,0x156d9,0x15c70,0x15e08, 0x15ef2,0x15ef8,0x15efd,0x15f17,
+        0x16108,0x17269,0x1744c,0x17470, 0x17569,0x17608,0x176f2,0x17717,
+        0x178c9,0x17908,0x17b9b,0x17bcb, 0x17d88,0x17e2a,0x17e30,0x17e4e,
+        0x17e54,0x17f3f,0x18049,0x185b5, 0x18aa8,0x18df8,0x18e17,0x18fe3,
+        0x19625,0x1962a,0x1964e,0x19659, 0x19721,0x1972d,0x1973f,0x19849,
+        0x199c7,0x19f67,0x1a105,0x1a5be, 0x1a5c9,0x1a968,0x1adfc,0x1ae06,
+        0x1ae1b,0x1ae1f,0x1ae20,0x1b3c5, 0x1b644,0x1b664,0x1bb45,0x1bb4a,
+        0x1c364,0x1ca1f,0x1cbba,0x1cbbc, 0x1ce39,0x1d818,0x1dce1,0x1dce6,
+        0x1dcfc,0x1e206,0x1e53e,0x1e55d, 0x1e97b,0x1ec95,0x1ed9b,0x1eda0,
+        0x1f373,0x1f4e6,0x1fc48,0x1fec5, 0x1feca,0x20254,0x203b7,0x20d8f,
+        0x20f47,0x210d9,0x210ee,0x210f4, 0x214cc,0x21598,0x2159d,0x21859,
+        0x21ab4,0x21c4c,0x21cee,0x21ef2, 0x22234,0x2254c,0x22699,0x227d4,
+        0x2302c,0x232ae,0x232b4,0x23788, 0x23a05,0x23a0a,0x23c1f,0x23e2a,
+        0x23f08,0x23fc3,0x24256,0x24889, 0x24d13,0x24ddf,0x25072,0x25074,
+        0x25708,0x257a5,0x265b0,0x269f0, 0x26a7d,0x26a88,0x26d18,0x26d3b,
+        0x26ed4,0x26f17,0x275fa,0x27630, 0x27649,0x27672,0x281df,0x28479,
+        0x284a9,0x285ae,0x285cd,0x285d2, 0x28932,0x28956,0x28c74,0x28e0b,
+        0x28e54,0x28ef6,0x28fe7,0x294ae, 0x29813,0x298cc,0x29cb2,0x29cec,
+        0x2a036,0x2a118,0x2a11d,0x2a13b, 0x2a2b9,0x2a845,0x2ab86,0x2af53,
+        0x2af64,0x2b115,0x2b1c8,0x2b1e6, 0x2b1eb,0x2b595,0x2b937,0x2b948,
+        0x2c16a,0x2c87e,0x2c87f,0x2cb06, 0x2cb07,0x2d5eb,0x2d965,0x2dfab,
+        0x2dfc5,0x2e891,0x2ea5d,0x2eb1b, 0x2eb20,0x2edbd,0x2edc2,0x2edc6,
+        0x2ede1,0x2ede6,0x2f15a,0x2f533, 0x2fff3,0x30c54,0x30d2d,0x30d43,
+        0x30e0f,0x30ed6,0x30efa,0x30fc7, 0x3124c,0x31632,0x3166c,0x3170f,
+        0x31e4c,0x31e70,0x320b9,0x320d4, 0x320f8,0x320fd,0x32496,0x32497,
+        0x3249a,0x325cc,0x325f0,0x32aa9, 0x32c76,0x32d67,0x33399,0x33808,
+        0x338ce,0x338d4,0x339e3,0x33d97, 0x33da8,0x34039,0x342b2,0x350ce,
+        0x35597,0x35921,0x35a05,0x36076, 0x362f0,0x36531,0x36570,0x36699,
+        0x366a9,0x367b0,0x367b9,0x367d4, 0x370f8,0x370fd,0x37121,0x372b4,
+        0x375bf,0x376b0,0x37839,0x37e49, 0x38256,0x38889,0x3888d,0x38892,
+        0x38c36,0x38cf4,0x38d13,0x38d18, 0x39039,0x39054,0x392d6,0x3942c,
+        0x3946e,0x39528,0x396ae,0x396d2, 0x39a32,0x39a56,0x39c72,0x39e2e,
+        0x39e52,0x39eec,0x39f0b,0x3aa8d, 0x3ac06,0x3ac07,0x3ad3c,0x3af91,
+        0x3afaf,0x3b573,0x3b711,0x3bf38, 0x3bf57,0x3c1cb,0x3ca7e,0x3ca7f,
+        0x3ca95,0x3caa2,0x3cc20,0x3cd40, 0x3cfe8,0x3d733,0x3d9cb,0x3f1b7,
+        0x3f1cb,0x3fde5,0x3fdea,0x40d9a, 0x414d2,0x41501,0x4195b,0x41c34,
+        0x41eb6,0x41f98,0x41f9d,0x41fbb, 0x4221a,0x4342e,0x43434,0x436b6,
+        0x43c6c,0x43e36,0x43ed9,0x43eee, 0x43ef4,0x43f13,0x43f18,0x43fe3,
+        0x449e9,0x4546c,0x45547,0x456ee, 0x456f4,0x45713,0x458e9,0x45e2c,
+        0x45e50,0x45e74,0x46069,0x460c9, 0x46108,0x465b6,0x46969,0x46a79,
+        0x46e13,0x46fdf,0x4762c,0x47636, 0x4771d,0x4773b,0x478c9,0x47908,
+        0x479c3,0x47d88,0x47e74,0x48049, 0x485ce,0x485d0,0x485ee,0x485f4,
+        0x487b0,0x487c9,0x487ce,0x4896d, 0x48972,0x48df8,0x48e17,0x48f3b,
+        0x4919a,0x491c3,0x49659,0x4966e, 0x49674,0x49cb0,0x49cb9,0x49cd4,
+        0x4a4e1,0x4a6a6,0x4a6a7,0x4b304, 0x4b5ca,0x4b953,0x4bf95,0x4cafe,
+        0x4d153,0x4d50d,0x4d5e4,0x4dd53, 0x4dd64,0x4df15,0x4dfda,0x4dfeb,
+        0x4e89f,0x4edde,0x4ede2,0x4f564, 0x4f7d7,0x4f7eb,0x4fb80,0x501ca,
+        0x50641,0x50aa7,0x50e1a,0x51630, 0x51639,0x51654,0x51cb4,0x51d85,
+        0x522e9,0x525d2,0x525f6,0x53676, 0x53cd6,0x53cfa,0x53dc7,0x5415f,
+        0x5452e,0x54534,0x54cd2,0x54d8b, 0x54f67,0x55105,0x5510a,0x554b2,
+        0x555c7,0x55ae9,0x55d0f,0x55eac, 0x56269,0x5656c,0x569e9,0x56d0b,
+        0x56d2a,0x5701d,0x572e9,0x574f0, 0x574fa,0x5750f,0x57a01,0x57a69,
+        0x57c4c,0x57d69,0x57e08,0x57ece, 0x57ef2,0x57fe3,0x580c9,0x58731,
+        0x5874c,0x58770,0x588a9,0x5892c, 0x589b0,0x589ed,0x589f2,0x59456,
+        0x596d0,0x596d9,0x596f4,0x597bf, 0x59e25,0x59e2a,0x59e59,0x59f21,
+        0x5a666,0x5a827,0x5ac48,0x5ae9f, 0x5aeca,0x5b465,0x5b6e4,0x5b6fd,
+        0x5b702,0x5b703,0x5b895,0x5be5e, 0x5cc5a,0x5ce06,0x5ce07,0x5d1a0,
+        0x5d3ba,0x5d8d6,0x5db3a,0x5e124, 0x5e5dd,0x5e5e8,0x5e795,0x5f36a,
+        0x5f491,0x5f7fe,0x5f91e,0x5fb73, 0x602f3,0x60715,0x60727,0x60d63,
+        0x60e0a,0x60e0f,0x61747,0x618d0, 0x618f4,0x61d0a,0x61d93,0x61d98,
+        0x622ae,0x622b4,0x62d8a,0x631df, 0x6350a,0x63593,0x63918,0x6391d,
+        0x63928,0x64072,0x64205,0x64532, 0x64551,0x6469a,0x647b0,0x647b5,
+        0x64d8f,0x65036,0x65118,0x6511d, 0x652b9,0x6550f,0x655df,0x656d0,
+        0x65859,0x65874,0x65af6,0x65eb0, 0x65fa5,0x66889,0x6688a,0x6688e,
+        0x6688f,0x66b23,0x66dc9,0x67050, 0x67059,0x67074,0x672f6,0x6744c,
+        0x676ce,0x67a34,0x67c6e,0x67e4e, 0x67f08,0x68739,0x6874e,0x68754,
+        0x689d6,0x68e08,0x69205,0x6922e, 0x69234,0x69708,0x697e7,0x69985,
+        0x6998a,0x69a6c,0x69daa,0x69f43, 0x6a0b6,0x6a8e5,0x6aa91,0x6ad3c,
+        0x6ad41,0x6ad5c,0x6ad6a,0x6ad6f, 0x6af0d,0x6b753,0x6b9e6,0x6bd8c,
+        0x6c1e5,0x6d1b3,0x6d1b8,0x6d1d7, 0x6d758,0x6d777,0x6d915,0x6dc84,
+        0x6ddd7,0x6e15a,0x6ef58,0x6ef77, 0x6f115,0x6f1da,0x6f95a,0x70883,
+        0x70884,0x70891,0x708a2,0x70b6b, 0x70de3,0x71076,0x71167,0x713ff,
+        0x71469,0x71993,0x71a36,0x72756, 0x729d0,0x729d9,0x729f4,0x72e0a,
+        0x73228,0x7370a,0x740d4,0x74478, 0x745d1,0x74936,0x74a90,0x74d43,
+        0x74d67,0x74e0f,0x75618,0x7561d, 0x758d9,0x759bf,0x760fd,0x76117,
+        0x7652d,0x76532,0x765cc,0x765f0, 0x76959,0x7696e,0x76974,0x76d8f,
+        0x76e56,0x770ac,0x774cc,0x77808, 0x778f8,0x778fd,0x77917,0x77cac,
+        0x77cd0,0x77da1,0x77eb0,0x78039, 0x7804e,0x78054,0x782d6,0x7854c,
+        0x7867a,0x78699,0x790f2,0x791e3, 0x79788,0x79854,0x79a0a,0x79ad6,
+        0x79d28,0x79f08,0x7aa41,0x7ab00, 0x7ab1e,0x7ab1f,0x7ab23,0x7ab24,
+        0x7adc1,0x7adcb,0x7ade0,0x7adea, 0x7bd45,0x7bd4a,0x7bea4,0x7bf11,
+        0x7bfd7,0x7bfe8,0x7c89b,0x7cc06, 0x7cc07,0x7cde0,0x7d215,0x7d545,
+        0x7d54a,0x7e1b7,0x7e1cb,0x7e1ea, 0x7e63d,0x7efd3,0x7f72f,0x7f9b7,
+        0x80b85,0x80e1a,0x80f3f,0x810c9, 0x81108,0x81588,0x81cb4,0x81cd2,
+        0x81cf6,0x82530,0x82554,0x82689, 0x82692,0x82d88,0x83049,0x834ae,
+        0x834b4,0x834d2,0x834f6,0x835a5, 0x835c3,0x83947,0x83c34,0x83d0b,
+        0x83d2a,0x84576,0x85501,0x8550b, 0x85525,0x8552a,0x859fd,0x85d47,
+        0x85eee,0x85f13,0x85fdf,0x860e9, 0x86269,0x8672d,0x86732,0x86751,
+        0x8676c,0x869ee,0x871f8,0x871fd, 0x87434,0x87452,0x87476,0x876cc,
+        0x877bb,0x877cd,0x877df,0x87e36, 0x87f18,0x87f1d,0x8819a,0x88aa9,
+        0x89628,0x89636,0x89718,0x898e9, 0x89ac9,0x89e59,0x89e6e,0x89e74,
+        0x8a069,0x8a108,0x8aa9c,0x8ab7b, 0x8ab7f,0x8ab80,0x8ab9e,0x8ab9f,
+        0x8b1ab,0x8b76f,0x8b9f7,0x8bb04, 0x8bdc5,0x8bdca,0x8c153,0x8cf5a,
+        0x8cf6a,0x8d1f3,0x8d304,0x8d5c5, 0x8d5ca,0x8da84,0x8dd0d,0x8dde4,
+        0x8f011,0x8f14f,0x8f977,0x8fc1e, 0x8fd64,0x8ffb3,0x8ffb8,0x8ffd7,
+        0x90380,0x911fa,0x9144c,0x91608, 0x916b9,0x916ce,0x916d4,0x916f2,
+        0x916f8,0x91717,0x917c3,0x91e30, 0x91e39,0x91e54,0x91f1a,0x92aa8,
+        0x930c9,0x93588,0x9362a,0x93630, 0x93654,0x9371a,0x93849,0x93e76,
+        0x94105,0x9410a,0x9434f,0x94499, 0x945b4,0x945b9,0x945d2,0x945d4,
+        0x945f6,0x94e0b,0x94e2a,0x95767, 0x95905,0x9590a,0x959ed,0x95cb2,
+        0x95cd6,0x962e9,0x965f6,0x9668d, 0x96692,0x967ad,0x967b2,0x967d1,
+        0x967ec,0x96d9a,0x971db,0x974b4, 0x97cfa,0x97eb6,0x98552,0x98576,
+        0x994d6,0x994ec,0x994fa,0x995c7, 0x99c32,0x99c56,0x99d47,0x99eac,
+        0x99ed0,0x99ed9,0x99ef4,0x99fbf, 0x9a561,0x9a71b,0x9b6c5,0x9bc65,
+        0x9bc6a,0x9bee4,0x9bf03,0x9c095, 0x9c17a,0x9ccff,0x9cd00,0x9d21f,
+        0x9d465,0x9d46a,0x9d6e4,0x9d703, 0x9e58d,0x9ec41,0x9f07f,0x9f181,
+        0x9f3c6,0x9f3e5,0x9f625,0x9f645, 0x9f64a,0x9f8b8,0x9fb46,0xa0345,
+        0xa034a,0xa05c0,0xa05c4,0xa0d28, 0xa0e0b,0xa0fa5,0xa0faa,0xa1232,
+        0xa1234,0xa2017,0xa2479,0xa25f1, 0xa2a85,0xa2c59,0xa2d3f,0xa2d63,
+        0xa2e54,0xa2f1a,0xa3652,0xa3d0a, 0xa4118,0xa411d,0xa42b9,0xa452e,
+        0xa454d,0xa4552,0xa45ec,0xa4970, 0xa4bf3,0xa4d8b,0xa4e34,0xa4e76,
+        0xa50b6,0xa58d9,0xa58f4,0xa5913, 0xa5918,0xa591d,0xa5a08,0xa5c32,
+        0xa5ccc,0xa5d0f,0xa5dbb,0xa5eac, 0xa6050,0xa6059,0xa6074,0xa62f6,
+        0xa6532,0xa656c,0xa6b2b,0xa6d8a, 0xa6d8f,0xa7017,0xa70ee,0xa70f4,
+        0xa7113,0xa750a,0xa7ad2,0xa7af6, 0xa8234,0xa87d9,0xa8885,0xa92d4,
+        0xaa185,0xaad3d,0xaadda,0xaade5, 0xab7f3,0xac1b3,0xac8c1,0xaca9f,
+        0xacc27,0xacd46,0xacd48,0xacfcf, 0xad611,0xad9b3,0xad9b8,0xadf58,
+        0xadf77,0xae110,0xae115,0xae1da, 0xaed65,0xaef2b,0xaef45,0xaf1b3,
+        0xaf1c4,0xaf764,0xaf777,0xaf915, 0xaf9e6,0xafd95,0xb0137,0xb0148,
+        0xb015a,0xb10fd,0xb1117,0xb1121, 0xb15a1,0xb1852,0xb1876,0xb1f85,
+        0xb2228,0xb2236,0xb27ec,0xb27f1, 0xb27f6,0xb2cd9,0xb2d13,0xb2d18,
+        0xb2dbf,0xb3039,0xb3054,0xb32d6, 0xb3f0a,0xb426e,0xb4734,0xb4cf8,
+        0xb4d17,0xb4eb4,0xb4ef6,0xb518a, 0xb544e,0xb5472,0xb562e,0xb5652,
+        0xb56ec,0xb570b,0xb57db,0xb5e13, 0xb5e18,0xb5e1d,0xb5e32,0xb5e6c,
+        0xb65b2,0xb6a8b,0xb6a90,0xb6d3f, 0xb6e0a,0xb6e0f,0xb6fc7,0xb737f,
+        0xb7613,0xb79a8,0xb8008,0xb80f2, 0xb80f8,0xb81e3,0xb8496,0xb8497,
+        0xb8498,0xb849a,0xb8950,0xb8d67, 0xb8d8a,0xba025,0xba02a,0xba030,
+        0xba054,0xba121,0xba205,0xba2d6, 0xbaae1,0xbaae5,0xbaba3,0xbaba4,
+        0xbaf6b,0xbb5b7,0xbb5c6,0xbb93a, 0xbb94a,0xbbc06,0xbbdc5,0xbd14b,
+        0xbda15,0xbdd3a,0xbdf16,0xbdfd3, 0xbe6e1,0xbec9c,0xbedba,0xbedbc,
+        0xbf173,0xbf53a,0xbf56a,0xbf7af, 0xbf7d3,0xbfd73,0xbff11,0xc0e4c,
+        0xc0fdf,0xc10e9,0xc1269,0xc162c, 0xc18c9,0xc1908,0xc1d88,0xc1e72,
+        0xc2049,0xc234b,0xc25b5,0xc25b9, 0xc25ce,0xc25d4,0xc25f4,0xc27c9,
+        0xc2df8,0xc2e17,0xc3674,0xc3763, 0xc3849,0xc3b05,0xc3cae,0xc3da5,
+        0xc3daa,0xc4147,0xc4689,0xc468e, 0xc468f,0xc47ae,0xc47cd,0xc47d2,
+        0xc47f1,0xc4d78,0xc4d97,0xc5108, 0xc52f9,0xc5307,0xc5337,0xc54b0,
+        0xc54b9,0xc54d4,0xc5cf6,0xc5d0b, 0xc5d1a,0xc6539,0xc654e,0xc6749,
+        0xc6d9a,0xc7049,0xc74d2,0xc74f6, 0xc751a,0xc75e7,0xc7c2e,0xc7c34,
+        0xc7c52,0xc7c58,0xc7c76,0xc7eb6, 0xc7ecc,0xc942e,0xc9434,0xc9525,
+        0xc9543,0xc96b6,0xc96cc,0xc9a21, 0xc9c6c,0xc9e36,0xc9f13,0xca0e9,
+        0xcabfb,0xcabff,0xcac00,0xcac1e, 0xcac1f,0xcae7e,0xcae82,0xcafb8,
+        0xcb9ab,0xcb9ca,0xcbf6a,0xcbf6f, 0xcc304,0xccd58,0xccd5d,0xcd9f3,
+        0xcdb04,0xcddc5,0xceb80,0xcf1cf, 0xcf92b,0xd0177,0xd12e9,0xd14f0,
+        0xd150a,0xd1a69,0xd1c36,0xd1c4c, 0xd1e08,0xd1ece,0xd1ed4,0xd1ef8,
+        0xd20c9,0xd2879,0xd28a9,0xd29c9, 0xd2d0f,0xd344c,0xd3608,0xd36b0,
+        0xd36ce,0xd37a1,0xd37bf,0xd38c9, 0xd3a49,0xd3d88,0xd3e25,0xd3e2a,
+        0xd3f17,0xd4930,0xd496d,0xd4972, 0xd49f1,0xd4c07,0xd4fa1,0xd4fbf,
+        0xd5470,0xd56f8,0xd56fd,0xd5717, 0xd5721,0xd597a,0xd5e39,0xd5e54,
+        0xd5e72,0xd6105,0xd610a,0xd61db, 0xd6309,0xd6485,0xd648a,0xd648b,
+        0xd6490,0xd64a9,0xd65b0,0xd65d4, 0xd6949,0xd6e1a,0xd70c9,0xd7108,
+        0xd717a,0xd7588,0xd7639,0xd764e, 0xd7654,0xd79db,0xd7cb4,0xd85f6,
+        0xd8689,0xd8f3f,0xd9049,0xd91c7, 0xd94b4,0xd95aa,0xd9cd6,0xd9cec,
+        0xd9cfa,0xd9dc7,0xda2e9,0xdac91, 0xdad7b,0xdad7c,0xdb34a,0xdb373,
+        0xdb4c8,0xdbce5,0xdc566,0xdc568, 0xdcda0,0xdd364,0xdd4e5,0xdd505,
+        0xdd784,0xdda06,0xdda07,0xddc46, 0xddc48,0xddc65,0xddc6a,0xddec5,
+        0xddee4,0xde17b,0xde3e5,0xde3ea, 0xdeb5e,0xdecda,0xdece1,0xdf21b,
+        0xdf43d,0xdf442,0xdf448,0xdf461, 0xdf6bc,0xdf6c5,0xdfbb7,0xe019f,
+        0xe057b,0xe0815,0xe0b21,0xe0dbb, 0xe0f97,0xe1059,0xe113f,0xe12d2,
+        0xe12f6,0xe1470,0xe1708,0xe1a34, 0xe2730,0xe2739,0xe2754,0xe29d6,
+        0xe2c36,0xe2cf4,0xe2d13,0xe2de3, 0xe3234,0xe364e,0xe398a,0xe3a6c,
+        0xe3e2e,0xe3e52,0xe40b6,0xe41bb, 0xe45ae,0xe45d2,0xe4a8c,0xe4c50,
+        0xe4d49,0xe4e0b,0xe4fc3,0xe5185, 0xe537b,0xe5725,0xe572a,0xe58b6,
+        0xe60ee,0xe60f4,0xe61f5,0xe6479, 0xe6498,0xe694c,0xe8552,0xe8571,
+        0xe8cb4,0xe91df,0xe94b2,0xe9505, 0xe9836,0xe9918,0xe991d,0xe993b,
+        0xe9ab0,0xe9ab9,0xe9ad4,0xe9cf0, 0xe9ddf,0xe9ed0,0xe9ee9,0xe9f97,
+        0xea059,0xea891,0xeaafb,0xeaafc, 0xeab0d,0xeab1f,0xeadb3,0xeadb8,
+        0xeadbd,0xeb137,0xeb148,0xebc1c, 0xec882,0xecca6,0xecca7,0xecdc6,
+        0xecdeb,0xed165,0xed403,0xed686, 0xed7ca,0xed7cf,0xede11,0xee1b3,
+        0xee1c4,0xeec26,0xeec27,0xeed3d, 0xeed42,0xeed46,0xeed48,0xeed61,
+        0xeefc5,0xeff53,0xeff64,0xf01eb, 0xf0495,0xf0a9f,0xf18f8,0xf18fd,
+        0xf1da1,0xf2054,0xf22d6,0xf254c, 0xf2570,0xf267a,0xf26a9,0xf2cb6,
+        0xf30b9,0xf30f8,0xf34ac,0xf34ee, 0xf3830,0xf3839,0xf3854,0xf3ad6,
+        0xf3c2c,0xf3c50,0xf3cf2,0xf3ed2, 0xf4550,0xf456e,0xf47d2,0xf47f6,
+        0xf4889,0xf4f88,0xf502a,0xf5205, 0xf520a,0xf52b2,0xf52d6,0xf5876,
+        0xf5967,0xf598a,0xf5fc7,0xf624c, 0xf6734,0xf69b6,0xf6dbf,0xf6de3,
+        0xf77b5,0xf7a4c,0xf8776,0xf89ee, 0xf89f0,0xf8a81,0xf8a85,0xf8f1a,
+        0xf9256,0xfa0ce,0xfa0d9,0xfad5e, 0xfad73,0xfaf11,0xfb757,0xfb9ef,
+        0xfcba0,0xfcd95,0xfcf57,0xfd1cb, 0xfd1ef,0xfddea,0xfe173,0xff5c6,
+        0xff5e5,0xff5ea,0xff973,0xffd46, 0xfffaf,
+        0
+};
 
+static const uint64_t low20TriHutNo10[] =
+{
+        0x594,0x6c3,0xec7,0xeeb, 0x1018,0x11dd,0x1528,0x178c,
+        0x1a0e,0x1a1a,0x1c94,0x1c99, 0x1c9d,0x1d69,0x1f01,0x1f0b,
+        0x1f0c,0x1f16,0x1f1c,0x245f, 0x2463,0x26c7,0x2984,0x2e23,
+        0x2e47,0x2fa1,0x3215,0x321a, 0x3492,0x3494,0x34a2,0x3575,
+        0x3716,0x371c,0x3721,0x3903, 0x3932,0x3bd0,0x3bd5,0x3bf9,
+        0x3e96,0x40e3,0x419f,0x42c3, 0x4623,0x47c5,0x47c9,0x4e7b,
+        0x5104,0x5132,0x5158,0x53d0, 0x53d5,0x53da,0x53f9,0x5970,
+        0x5975,0x5b06,0x5c18,0x5e90, 0x5e9a,0x5e9c,0x6393,0x666b,
+        0x667b,0x67fd,0x6b86,0x6b9c, 0x7170,0x73ed,0x73f2,0x7412,
+        0x75a9,0x7681,0x768c,0x7696, 0x7b50,0x7b6d,0x7b72,0x7d15,
+        0x8243,0x8267,0x872a,0x8730, 0x8ccf,0x8d8f,0x8d9a,0x9088,
+        0x9350,0x9355,0x9379,0x95b9, 0x95c8,0x9814,0x981d,0x9a85,
+        0x9a8a,0x9d0e,0x9d10,0x9d1e, 0x9de5,0x9dea,0xa0c7,0xa247,
+        0xa58e,0xa768,0xa76d,0xa772, 0xbe42,0xcde1,0xcdf6,0xcdfa,
+        0xcf8b,0xd719,0xdc95,0xde99, 0xe362,0xe5cc,0xe5e1,0xe985,
+        0xeaa0,0xed38,0xed41,0xee72, 0xf490,0xf495,0xfcc1,0xfe92,
+        0x10067,0x10247,0x1038b,0x107c8, 0x107e6,0x10caf,0x1116d,0x11179,
+        0x1132e,0x11330,0x1140b,0x1140c, 0x11416,0x1141c,0x115a8,0x1168e,
+        0x11690,0x1169e,0x11b52,0x11d14, 0x11dc5,0x11de9,0x124af,0x1272d,
+        0x12732,0x12748,0x12ce7,0x12d94, 0x12da2,0x13339,0x13352,0x1335d,
+        0x135c5,0x13816,0x1381c,0x139ad, 0x139b2,0x13a84,0x13d18,0x13e03,
+        0x13f81,0x144e7,0x14594,0x145a2, 0x1476a,0x14c3f,0x14c43,0x14c67,
+        0x15016,0x1501c,0x15289,0x15508, 0x15518,0x155e9,0x15781,0x159dc,
+        0x159f0,0x159f5,0x15a1e,0x15c98, 0x15f1a,0x15f1b,0x15f1c,0x1642f,
+        0x1643f,0x16eef,0x171d1,0x171d6, 0x171f0,0x171f5,0x17493,0x17494,
+        0x17545,0x17569,0x17716,0x17908, 0x17956,0x17a14,0x17bb0,0x17bb5,
+        0x17c8c,0x17f0e,0x182e7,0x18467, 0x186ef,0x18988,0x18e4b,0x19108,
+        0x1912d,0x19132,0x1920e,0x1921e, 0x193d5,0x19498,0x19970,0x19bd9,
+        0x19bf2,0x19bfd,0x19c0c,0x19c18, 0x19e95,0x19e9a,0x1a063,0x1a2c7,
+        0x1a7c4,0x1b241,0x1c936,0x1c938, 0x1cbbe,0x1cbbf,0x1d099,0x1d819,
+        0x1d8c0,0x1e121,0x1e97e,0x1ed90, 0x1ee80,0x1fd71,0x208eb,0x208fb,
+        0x20996,0x20997,0x20998,0x211c9, 0x211d5,0x21559,0x2156d,0x21572,
+        0x2190c,0x21916,0x21925,0x21bb9, 0x227d2,0x22823,0x22847,0x22aab,
+        0x22acf,0x22b9a,0x2310c,0x23116, 0x2311c,0x23206,0x23218,0x233a4,
+        0x23485,0x2348a,0x23704,0x23896, 0x2389c,0x23944,0x23959,0x23b0e,
+        0x23b19,0x23be5,0x23bea,0x2418a, 0x247a8,0x24a2b,0x24b80,0x24b9a,
+        0x24b9e,0x24b9f,0x25096,0x25159, 0x2531e,0x253d8,0x255b8,0x25895,
+        0x2589a,0x2589c,0x258a0,0x25b22, 0x25dbc,0x25dd0,0x25dd5,0x25df9,
+        0x25dfe,0x26734,0x26739,0x26758, 0x26776,0x26a5f,0x26a63,0x27096,
+        0x2709a,0x27314,0x27334,0x27339, 0x275b6,0x275d5,0x275f5,0x27a94,
+        0x27a99,0x27b75,0x27b7a,0x27d36, 0x27d55,0x27ded,0x27df4,0x27df9,
+        0x27e14,0x28775,0x2877a,0x288af, 0x28d86,0x28d88,0x2928e,0x2929e,
+        0x295ce,0x295f9,0x29612,0x29614, 0x2961d,0x29d50,0x29d55,0x29d79,
+        0x2a582,0x2a586,0x2a587,0x2a58c, 0x2a5a1,0x2a8d3,0x2aab3,0x2b205,
+        0x2b861,0x2ba09,0x2bf05,0x2c0a0, 0x2c189,0x2c328,0x2c5de,0x2c800,
+        0x2d042,0x2d119,0x2d2e0,0x2e199, 0x2e282,0x2e9c0,0x2e9d5,0x2e9d9,
+        0x2e9da,0x2f099,0x30393,0x30394, 0x30736,0x3075a,0x30775,0x31321,
+        0x315ae,0x315b0,0x315b5,0x315d2, 0x315d9,0x31a96,0x31a98,0x31a9d,
+        0x31b79,0x31d30,0x31d35,0x31d59, 0x31dec,0x31e0c,0x31e16,0x32774,
+        0x328c7,0x32c27,0x32d8a,0x33004, 0x33292,0x33298,0x33349,0x33364,
+        0x33379,0x33530,0x33535,0x3360c, 0x33616,0x3361c,0x339b5,0x339e8,
+        0x33d24,0x33d4d,0x33d5d,0x340a3, 0x3458a,0x348cb,0x34996,0x3499c,
+        0x351b5,0x3528c,0x35539,0x3553e, 0x35552,0x3557d,0x35910,0x35915,
+        0x3591a,0x35920,0x35a05,0x35a16, 0x35f02,0x367b4,0x367b9,0x367d8,
+        0x36996,0x3699a,0x3699b,0x36abb, 0x36adf,0x36ae3,0x3711a,0x37939,
+        0x37959,0x387b8,0x387d6,0x387fa, 0x3886f,0x38b94,0x3910f,0x39135,
+        0x39890,0x3989a,0x39b12,0x39b14, 0x39db0,0x39dd5,0x39e86,0x3aa73,
+        0x3af73,0x3bfb7,0x3c4a4,0x3c97d, 0x3ca78,0x3cb5d,0x3ccef,0x3e4ef,
+        0x3e4fb,0x3e8b3,0x3e8b4,0x3e8b8, 0x3e8d3,0x3e8d4,0x3e8d6,0x3e8d7,
+        0x3e8d8,0x3ec4b,0x3eedf,0x3eef3, 0x40247,0x404ab,0x4072e,0x40744,
+        0x40ce3,0x40d9f,0x41359,0x41372, 0x41500,0x415e5,0x41812,0x41818,
+        0x419b9,0x41d14,0x41d22,0x41fa1, 0x424e3,0x4259f,0x42766,0x42c5f,
+        0x42c63,0x42ec7,0x43018,0x431b9, 0x43285,0x4328a,0x4350d,0x43512,
+        0x43514,0x43519,0x4351e,0x43609, 0x439d8,0x43a1a,0x43a1b,0x43a1c,
+        0x43c94,0x43c99,0x43c9e,0x43f0c, 0x43f16,0x43f18,0x4442b,0x4443b,
+        0x451d2,0x451dd,0x45565,0x45718, 0x45904,0x45932,0x4595d,0x45a0e,
+        0x45bb1,0x45bb6,0x45bd0,0x45bd5, 0x4618f,0x46463,0x466eb,0x46e47,
+        0x47104,0x4721a,0x47494,0x4770c, 0x4771c,0x47bf9,0x47c14,0x47e8c,
+        0x47e96,0x47e9c,0x482c3,0x482e7, 0x48647,0x487c9,0x487ce,0x487e4,
+        0x48b86,0x48b87,0x48b88,0x493d0, 0x493d5,0x49414,0x49696,0x496a1,
+        0x49883,0x49b50,0x49b55,0x49da9, 0x4a063,0x4a243,0x4a398,0x4a4b3,
+        0x4a736,0x4a73c,0x4a745,0x4a749, 0x4b095,0x4bee1,0x4c133,0x4c222,
+        0x4c3b5,0x4c3ba,0x4c3bb,0x4c3bc, 0x4df19,0x4e402,0x4e432,0x4edd7,
+        0x4edd8,0x4ede1,0x4ff0d,0x50063, 0x500e7,0x501a2,0x502c7,0x5046b,
+        0x50627,0x50aa7,0x50e4f,0x50e7f, 0x51106,0x51214,0x513b0,0x513b5,
+        0x513d9,0x5149c,0x514a1,0x51979, 0x51c16,0x51c1c,0x51e80,0x51e8e,
+        0x51e90,0x51e99,0x51e9e,0x52043, 0x52067,0x5265b,0x52660,0x5267f,
+        0x527c8,0x527e6,0x52b8a,0x52cbb, 0x53150,0x53155,0x533f1,0x533f8,
+        0x533fd,0x5340c,0x53416,0x5368e, 0x53695,0x53699,0x5369a,0x5369e,
+        0x53b39,0x53b52,0x53b78,0x53b7d, 0x53db8,0x5439a,0x5439b,0x5439c,
+        0x5473e,0x54ce2,0x54d94,0x55086, 0x55309,0x55330,0x55352,0x5580c,
+        0x55816,0x559b4,0x55b76,0x55d12, 0x55d14,0x55de9,0x55e04,0x56594,
+        0x56748,0x56766,0x56c2f,0x56eb3, 0x56ec7,0x57018,0x57514,0x57519,
+        0x57528,0x575ca,0x575e9,0x575f5, 0x57604,0x579b2,0x57d45,0x57d69,
+        0x57f01,0x57f16,0x58594,0x586c7, 0x58c67,0x58eef,0x5900c,0x591b2,
+        0x591bd,0x5993d,0x599f0,0x59a10, 0x59a19,0x59a1e,0x59bd5,0x59c8d,
+        0x59c92,0x59c98,0x59d64,0x59f01, 0x59f15,0x59f1a,0x5a0e3,0x5a2c3,
+        0x5a83b,0x5a983,0x5aaf7,0x5b2e1, 0x5bc19,0x5c190,0x5c195,0x5c280,
+        0x5c502,0x5c9d6,0x5c9da,0x5cd4f, 0x5d095,0x5d899,0x5e1a7,0x5e1a8,
+        0x5ea22,0x5ea52,0x5f8b5,0x5fdf1, 0x6076e,0x608c3,0x60c23,0x60d86,
+        0x60d8a,0x61294,0x61369,0x615fd, 0x61612,0x61618,0x619aa,0x619c9,
+        0x619e4,0x61d29,0x61d59,0x61d6d, 0x61d72,0x61d7d,0x62586,0x6258a,
+        0x628c7,0x628eb,0x62982,0x62998, 0x63559,0x6355e,0x6356d,0x63572,
+        0x63916,0x63921,0x63a18,0x63f04, 0x647b5,0x647b9,0x647be,0x647d4,
+        0x64823,0x64996,0x64997,0x64998, 0x64adb,0x64ae0,0x6510c,0x65116,
+        0x65118,0x651f4,0x651f9,0x65212, 0x65214,0x653a9,0x6593a,0x65955,
+        0x65959,0x66196,0x66197,0x66198, 0x667b4,0x667d8,0x667ec,0x667f6,
+        0x6686b,0x6687b,0x66acf,0x66b8f, 0x66b9a,0x67149,0x67155,0x673c8,
+        0x673dd,0x67881,0x6788c,0x67896, 0x6789c,0x67b0e,0x67c1a,0x67dac,
+        0x67db1,0x67df5,0x67e88,0x68752, 0x68a2b,0x68a4f,0x69096,0x6909c,
+        0x69300,0x69310,0x69319,0x6931e, 0x69324,0x693e5,0x69415,0x6941a,
+        0x695c1,0x69683,0x69684,0x69a99, 0x69a9e,0x69b46,0x69b65,0x69b6a,
+        0x69df9,0x69e14,0x6a384,0x6a746, 0x6a8bb,0x6ad82,0x6ad87,0x6c143,
+        0x6cb34,0x6cb38,0x6cb41,0x6cdaa, 0x6cdc0,0x6d290,0x6d295,0x6d919,
+        0x6da15,0x6dac1,0x6dad5,0x6e322, 0x6e5bb,0x6e850,0x6ead2,0x6ef91,
+        0x6efa2,0x6f2c1,0x6f912,0x7019a, 0x707a6,0x707d5,0x707da,0x707ee,
+        0x7084f,0x70ae7,0x70b93,0x70b94, 0x71124,0x71129,0x71139,0x71148,
+        0x713c5,0x713ca,0x713e9,0x7188e, 0x71890,0x7189e,0x71965,0x7196a,
+        0x71b18,0x71b45,0x71b4a,0x71c08, 0x71db0,0x71db5,0x72383,0x72388,
+        0x7275c,0x7277a,0x72a3f,0x72a43, 0x72a67,0x72ca7,0x73080,0x7309e,
+        0x7309f,0x73302,0x7330d,0x73312, 0x73318,0x73331,0x73414,0x735b0,
+        0x735b5,0x735d9,0x735de,0x73686, 0x73a82,0x73a98,0x73b79,0x73d35,
+        0x73df1,0x73dfd,0x73e16,0x73e1c, 0x73e21,0x7472a,0x7475a,0x74770,
+        0x75294,0x75355,0x7535a,0x75375, 0x75535,0x7553a,0x755cd,0x755d4,
+        0x755d9,0x7560c,0x75616,0x75618, 0x75814,0x75819,0x759b5,0x75a98,
+        0x75d39,0x75d4d,0x75d52,0x75d54, 0x75d59,0x75d78,0x75d7d,0x768fb,
+        0x771a5,0x7728c,0x77298,0x77530, 0x77535,0x77559,0x7760c,0x77916,
+        0x7791c,0x779d9,0x77d6c,0x785a0, 0x78847,0x788ef,0x78996,0x78aab,
+        0x79116,0x791c4,0x791d9,0x79206, 0x79207,0x7991a,0x79935,0x79944,
+        0x79a0a,0x79ba8,0x79be5,0x7a18a, 0x7a7c6,0x7c950,0x7ca36,0x7ca3a,
+        0x7ca3b,0x7cb1a,0x7cca8,0x7ccb3, 0x7e064,0x7e48a,0x7e704,0x7e949,
+        0x7e96d,0x7e972,0x7ea62,0x7ea73, 0x7ea74,0x7ea78,0x7ec0a,0x7eccb,
+        0x7eceb,0x7ecef,0x7ecfb,0x7ffb7, 0x80063,0x80243,0x8067b,0x807c4,
+        0x807e8,0x80b86,0x80b8a,0x81170, 0x81175,0x8117a,0x813f2,0x81418,
+        0x8169a,0x8169c,0x81888,0x81b0a, 0x81b30,0x81b35,0x81b7d,0x81db9,
+        0x82396,0x82397,0x82749,0x82ccf, 0x82cdf,0x82d8f,0x82d9a,0x83088,
+        0x83305,0x8330a,0x83330,0x83350, 0x83812,0x83813,0x83a85,0x83d1e,
+        0x83de5,0x84247,0x844cf,0x8459a, 0x84744,0x84768,0x84c2b,0x85014,
+        0x8536d,0x85372,0x8550e,0x85510, 0x85519,0x8551e,0x85524,0x85529,
+        0x855e5,0x855ea,0x85609,0x859ad, 0x859b9,0x859d2,0x85d65,0x85d6a,
+        0x85f18,0x8659f,0x866bf,0x866c3, 0x86c63,0x86eeb,0x871b9,0x871cd,
+        0x871d2,0x877a1,0x87939,0x87a10, 0x87a15,0x87a1a,0x87c94,0x87f16,
+        0x8819a,0x8819b,0x88463,0x88980, 0x88984,0x8899f,0x88e23,0x88e42,
+        0x89139,0x8921a,0x8921c,0x893b8, 0x893bd,0x89492,0x89494,0x89499,
+        0x8949e,0x8970c,0x89716,0x89717, 0x89718,0x89951,0x89958,0x89bd0,
+        0x89bd5,0x89bda,0x89bf9,0x89c14, 0x89c1e,0x89e96,0x89e98,0x8a18e,
+        0x8a18f,0x8a653,0x8a7ac,0x8a7b6, 0x8a7bc,0x8a7d0,0x8a7d5,0x8a7da,
+        0x8a7fe,0x8ab82,0x8ab88,0x8b410, 0x8b415,0x8b4bd,0x8b692,0x8b895,
+        0x8c1d6,0x8c54b,0x8c54c,0x8c561, 0x8d085,0x8dc55,0x8dd11,0x8e200,
+        0x8f441,0x900e3,0x9043f,0x90443, 0x90598,0x90eff,0x911b8,0x911f5,
+        0x91701,0x9171a,0x919f9,0x91a12, 0x91a14,0x91a1e,0x91bb0,0x91bb5,
+        0x91c8c,0x91c96,0x91c98,0x91f0e, 0x92194,0x9219e,0x926ef,0x926ff,
+        0x92982,0x92986,0x92988,0x929a1, 0x92e5b,0x9313d,0x931f0,0x9321e,
+        0x933b0,0x933b5,0x9348c,0x93496, 0x93498,0x9370e,0x93710,0x93715,
+        0x9371a,0x93950,0x93955,0x93bcd, 0x93bd2,0x93bd4,0x93c16,0x93e8e,
+        0x93e95,0x93e9a,0x94193,0x942c7, 0x94627,0x947be,0x947c4,0x9516e,
+        0x95170,0x953d9,0x953ed,0x953f2, 0x95418,0x9569a,0x95886,0x95b30,
+        0x95b59,0x95c0c,0x95e8e,0x96043, 0x96067,0x96247,0x9638b,0x9638c,
+        0x967e6,0x967ec,0x96b8f,0x96caf, 0x96cc0,0x96cdf,0x96ce3,0x97086,
+        0x97179,0x97330,0x97335,0x97359, 0x9740c,0x97416,0x9769e,0x97d14,
+        0x97dc5,0x97e04,0x984bb,0x984c0, 0x984df,0x984e3,0x98748,0x98766,
+        0x98ce7,0x98d94,0x9934d,0x99352, 0x99371,0x99378,0x99514,0x99519,
+        0x9951e,0x9980c,0x99816,0x9981c, 0x999b2,0x999d8,0x999dd,0x9b571,
+        0x9b910,0x9b915,0x9c5a6,0x9c990, 0x9c995,0x9cb61,0x9cd02,0x9d895,
+        0x9e820,0x9e9b6,0x9e9b8,0x9e9c1, 0x9f205,0x9fa61,0xa0384,0xa0732,
+        0xa0758,0xa0a40,0xa0a5f,0xa0a63, 0xa1090,0xa109a,0xa109c,0xa1312,
+        0xa1314,0xa131e,0xa140e,0xa15bc, 0xa15d0,0xa15d5,0xa15f9,0xa1688,
+        0xa1a94,0xa1b75,0xa1d3c,0xa1df2, 0xa1e02,0xa1e18,0xa1e1d,0xa2756,
+        0xa2775,0xa277a,0xa28bf,0xa28c3, 0xa2c23,0xa3294,0xa329e,0xa3356,
+        0xa3375,0xa3536,0xa35d5,0xa35f2, 0xa35f4,0xa35f9,0xa3612,0xa3613,
+        0xa3614,0xa3815,0xa381a,0xa3d0a, 0xa3d35,0xa3d3a,0xa3d55,0xa3d59,
+        0xa3d74,0xa3d79,0xa501a,0xa5294, 0xa550a,0xa554e,0xa5555,0xa5579,
+        0xa5918,0xa591d,0xa59f9,0xa5a08, 0xa5d6d,0xa5d72,0xa6843,0xa68eb,
+        0xa6996,0xa6998,0xa7118,0xa71c9, 0xa71e4,0xa757d,0xa792a,0xa7931,
+        0xa7949,0xa7ba4,0xa7bb9,0xa7be6, 0xa8186,0xa8187,0xa8194,0xa8198,
+        0xa82a7,0xa87b9,0xa87be,0xa87d4, 0xa8847,0xa886b,0xa8adb,0xa8aff,
+        0xa8b9a,0xa8b9b,0xa910c,0xa9116, 0xa9118,0xa93b9,0xa988c,0xa9896,
+        0xa9b1f,0xa9c1a,0xa9dbd,0xaaa37, 0xabdd1,0xabe10,0xabe15,0xac92e,
+        0xac92f,0xac954,0xaca70,0xacbd6, 0xacbd7,0xacbd8,0xacbdc,0xacbe1,
+        0xad5d1,0xada90,0xada95,0xadd51, 0xae120,0xae12a,0xae3a8,0xaec20,
+        0xaed8d,0xaeea2,0xaf783,0xafa05, 0xb00a7,0xb0827,0xb099a,0xb0adf,
+        0xb0ae3,0xb1101,0xb1115,0xb111a, 0xb111c,0xb11d2,0xb11f1,0xb11fd,
+        0xb157c,0xb1939,0xb1966,0xb1bc5, 0xb1ca2,0xb2196,0xb219a,0xb27b8,
+        0xb27fa,0xb285b,0xb287f,0xb2ac3, 0xb2ae2,0xb2b94,0xb2cf7,0xb3115,
+        0xb311a,0xb3135,0xb3139,0xb388e, 0xb3895,0xb389a,0xb3b18,0xb3bf9,
+        0xb3c14,0xb3c19,0xb3db5,0xb3dba, 0xb3dd9,0xb4738,0xb4756,0xb4a2f,
+        0xb4b98,0xb508e,0xb508f,0xb509a, 0xb5312,0xb5314,0xb53f5,0xb55d5,
+        0xb5dd9,0xb5ded,0xb5df2,0xb5e18, 0xb6393,0xb6394,0xb6755,0xb675a,
+        0xb6770,0xb6a67,0xb6c23,0xb7326, 0xb7345,0xb734a,0xb7369,0xb75a9,
+        0xb75b5,0xb75d9,0xb75fd,0xb7618, 0xb7804,0xb7815,0xb79aa,0xb7a92,
+        0xb7a98,0xb7b64,0xb7d30,0xb7d35, 0xb7d59,0xb7e1c,0xb88c7,0xb8c27,
+        0xb8da0,0xb9282,0xb9298,0xb929d, 0xb9530,0xb9535,0xb9559,0xb955e,
+        0xb960c,0xb9616,0xb99d9,0xb9d52, 0xb9d71,0xb9d7d,0xba0a3,0xba5a0,
+        0xbaab7,0xbb7f1,0xbc0ca,0xbc46f, 0xbc47f,0xbc785,0xbc80e,0xbc826,
+        0xbc827,0xbc833,0xbc834,0xbc838, 0xbc856,0xbc857,0xbc858,0xbc9d0,
+        0xbcaab,0xbcaba,0xbcada,0xbcadf, 0xbce2f,0xbe525,0xbe62f,0xbe860,
+        0xbe87a,0xbe87e,0xbe87f,0xbe945, 0xbe969,0xbea08,0xbeaf8,0xbec81,
+        0xbec8a,0xbef04,0xbf773,0xc06eb, 0xc06fb,0xc0984,0xc09a2,0xc1132,
+        0xc11f0,0xc120e,0xc1210,0xc1492, 0xc1494,0xc1569,0xc170c,0xc1716,
+        0xc1956,0xc1970,0xc1975,0xc1bd0, 0xc1bf2,0xc1c13,0xc1e96,0xc22e7,
+        0xc2623,0xc2647,0xc33d0,0xc33d5, 0xc3414,0xc3681,0xc3696,0xc369c,
+        0xc3888,0xc3b0a,0xc4063,0xc4243, 0xc4267,0xc472a,0xc47e8,0xc4cab,
+        0xc4ccf,0xc4d9a,0xc5355,0xc5418, 0xc569c,0xc56a0,0xc5814,0xc5b59,
+        0xc5b72,0xc5b7d,0xc5d00,0xc5d19, 0xc5d1e,0xc5dc6,0xc5de5,0xc64db,
+        0xc6744,0xc6749,0xc6768,0xc6d80, 0xc6d9a,0xc6d9f,0xc6ebf,0xc7359,
+        0xc7372,0xc7374,0xc751a,0xc75d8, 0xc7818,0xc79dd,0xc7a8a,0xc7fa1,
+        0xc858f,0xc859a,0xc8768,0xc8c4f, 0xc8c5f,0xc9012,0xc91b0,0xc9285,
+        0xc928a,0xc99d2,0xc99f1,0xc99f6, 0xc9d65,0xc9f16,0xc9f18,0xc9f1d,
+        0xca6d3,0xca98e,0xca98f,0xca990, 0xca99a,0xcae53,0xcaf8b,0xcb661,
+        0xcbe92,0xcc362,0xcc378,0xcc5e1, 0xcc5ee,0xcc600,0xccb89,0xccd56,
+        0xccd5c,0xcd105,0xcd885,0xcdce0, 0xce1b4,0xce541,0xce556,0xceb8d,
+        0xcf415,0xcf69d,0xcfd11,0xd04af, 0xd0594,0xd0746,0xd0c3f,0xd0d93,
+        0xd0d94,0xd0d98,0xd1016,0xd1371, 0xd1376,0xd1513,0xd1514,0xd15c5,
+        0xd15e9,0xd1604,0xd181a,0xd19d6, 0xd19f5,0xd1a84,0xd1d0c,0xd1d36,
+        0xd1d45,0xd2593,0xd2594,0xd2ecb, 0xd2eef,0xd300b,0xd300c,0xd301c,
+        0xd31b2,0xd3284,0xd3521,0xd3545, 0xd354a,0xd39f0,0xd3a0e,0xd3a1e,
+        0xd3c98,0xd3ca1,0xd3d79,0xd3f1a, 0xd40e3,0xd42c3,0xd4443,0xd4467,
+        0xd46cb,0xd4983,0xd4aa3,0xd4e27, 0xd4f81,0xd51f0,0xd51f5,0xd520e,
+        0xd5219,0xd5492,0xd5498,0xd5579, 0xd5710,0xd5715,0xd571a,0xd5720,
+        0xd5906,0xd5bb0,0xd5bfd,0xd5e95, 0xd6063,0xd60e7,0xd6194,0xd62c7,
+        0xd6e7f,0xd7108,0xd7131,0xd7138, 0xd713d,0xd717a,0xd73b0,0xd73b5,
+        0xd73ba,0xd73d9,0xd748c,0xd7979, 0xd7b30,0xd7b35,0xd7bf8,0xd7c0c,
+        0xd7c16,0xd7c1c,0xd7e8e,0xd8396, 0xd8397,0xd866f,0xd87e6,0xd8b8a,
+        0xd8b9b,0xd8ba0,0xd8cbb,0xd9170, 0xd9335,0xd93f2,0xd9406,0xd9416,
+        0xd941d,0xd968e,0xd9690,0xd969a, 0xd9b52,0xd9b54,0xd9de5,0xda247,
+        0xda38b,0xda4ab,0xda725,0xdaa6f, 0xdac2b,0xdb611,0xdba91,0xdbd09,
+        0xdc126,0xdc12a,0xdcc20,0xdcd89, 0xdcea2,0xdd509,0xddabd,0xde082,
+        0xde168,0xde300,0xde589,0xde6a2, 0xdeb4c,0xdeb61,0xdf862,0xe0196,
+        0xe0197,0xe07b4,0xe07d8,0xe07f6, 0xe087b,0xe0adf,0xe0ae3,0xe0b9a,
+        0xe0b9f,0xe1135,0xe113a,0xe13b4, 0xe13b9,0xe1895,0xe189a,0xe1978,
+        0xe1b12,0xe1b14,0xe1b19,0xe1b1e, 0xe1bfa,0xe1c10,0xe1c15,0xe1c1a,
+        0xe1db6,0xe1dd5,0xe1dda,0xe2734, 0xe2739,0xe2758,0xe27fa,0xe2a2b,
+        0xe2a3b,0xe2a4f,0xe308c,0xe3096, 0xe309c,0xe330e,0xe3409,0xe341a,
+        0xe35ac,0xe3dce,0xe3dd0,0xe3dd5, 0xe3df2,0xe3df9,0xe3e0d,0xe3e14,
+        0xe4756,0xe4a63,0xe5346,0xe5365, 0xe55a5,0xe55d0,0xe55d5,0xe55f9,
+        0xe5614,0xe581a,0xe5a94,0xe5b69, 0xe5d31,0xe5d50,0xe5d55,0xe68bf,
+        0xe68c3,0xe68e7,0xe6c23,0xe7292, 0xe7294,0xe729e,0xe753c,0xe7555,
+        0xe75ed,0xe7618,0xe79d5,0xe7d59, 0xe7d5e,0xe7d72,0xe8993,0xe8994,
+        0xe8998,0xe91b6,0xe91d5,0xe9550, 0xe9555,0xe956d,0xe9572,0xe9574,
+        0xe9579,0xe9916,0xe9917,0xe9918, 0xe9a14,0xe9ba9,0xe9c8a,0xe9f04,
+        0xea853,0xea877,0xeaab7,0xeaaef, 0xeb061,0xeb112,0xeb892,0xebb11,
+        0xec2a2,0xec520,0xec9ce,0xecf00, 0xed241,0xed685,0xee1c0,0xee1c4,
+        0xee93a,0xeebb9,0xeebbe,0xeebc2, 0xf00a3,0xf1014,0xf1019,0xf128c,
+        0xf1296,0xf1297,0xf1298,0xf1539, 0xf1552,0xf1554,0xf1559,0xf19d9,
+        0xf28ef,0xf28ff,0xf2996,0xf299a, 0xf2abb,0xf31d9,0xf354d,0xf356c,
+        0xf3571,0xf390e,0xf3910,0xf391a, 0xf3c84,0xf47d6,0xf47fa,0xf4827,
+        0xf484b,0xf4aaf,0xf511a,0xf5125, 0xf520a,0xf5216,0xf53c6,0xf5484,
+        0xf5489,0xf5706,0xf5708,0xf589a, 0xf5948,0xf5b14,0xf5bc5,0xf5bca,
+        0xf5be9,0xf5bf5,0xf5c04,0xf687f, 0xf6a40,0xf6ae7,0xf6b94,0xf7095,
+        0xf7314,0xf731e,0xf73f5,0xf788e, 0xf7db0,0xf7db5,0xf7dd9,0xf8394,
+        0xf8738,0xf8756,0xf877a,0xf8a43, 0xf908e,0xf9090,0xf9095,0xf909a,
+        0xf9314,0xf95b0,0xf95b5,0xf95ba, 0xf95d5,0xf95f4,0xf95f9,0xf9a94,
+        0xf9a98,0xf9b75,0xf9b79,0xf9d30, 0xf9d35,0xf9d3a,0xf9df8,0xf9dfd,
+        0xf9e0c,0xf9e16,0xf9e17,0xf9e18, 0xfa4fb,0xfa8d3,0xfac7b,0xfad8b,
+        0xfad8c,0xfad96,0xfad9a,0xfad9b, 0xfad9c,0xfb7b7,0xfc08a,0xfc304,
+        0xfc6ab,0xfc6bb,0xfc80a,0xfc8d6, 0xfc8d7,0xfc8d8,0xfc8f6,0xfc8fa,
+        0xfcc4b,0xfcc6f,0xfcc7f,0xfe0a3, 0xfe0a4,0xfe44b,0xfe45b,0xfe47b,
+        0xfe833,0xfe834,0xfe838,0xfe842, 0xfe8ef,0xfeab6,0xfeab8,0xfeaba,
+        0xfeabb,0xfeabc,0xfee2f,0xfee3b, 0xfee3f,0xfee40,0xfee5f,
+        0
+};
 
-static int blocksInRange(Pos *p, int n, int x, int z, int ax, int az, double rsq)
+static const uint64_t low20TriHutNo01[] =
 {
-    int i, cnt;
+        0x44f,0x62f,0x11a9,0x11c8, 0x11cd,0x190e,0x19cc,0x19e5,
+        0x1c88,0x1c8d,0x263f,0x2643, 0x2667,0x2fa1,0x3100,0x31ad,
+        0x3220,0x3492,0x3494,0x34a2, 0x370c,0x371d,0x3903,0x392d,
+        0x3932,0x3946,0x3bd0,0x3be9, 0x3e81,0x44a3,0x44d3,0x47aa,
+        0x47c9,0x5104,0x5114,0x512d, 0x5132,0x53da,0x53f9,0x5965,
+        0x5975,0x5b0c,0x5b18,0x5bfd, 0x5c08,0x5c0d,0x5da9,0x5dbe,
+        0x5dd9,0x5e8a,0x5e90,0x64d7, 0x64fb,0x6736,0x67e9,0x67ed,
+        0x67f2,0x709e,0x714c,0x7170, 0x730c,0x7408,0x740d,0x7412,
+        0x75a9,0x768a,0x768c,0x7b6d, 0x8388,0x838c,0x8423,0x8433,
+        0x872a,0x874e,0x8750,0x8d8f, 0x9349,0x9369,0x95cd,0x9616,
+        0x99a9,0x99ae,0x99b5,0x9d29, 0x9e0a,0x9e0e,0xa58a,0xa58e,
+        0xa6df,0xa6e3,0xa768,0xa76d, 0xba1d,0xbc85,0xbe42,0xc082,
+        0xcb62,0xcdfa,0xcf87,0xd21d, 0xd719,0xdf1d,0xe344,0xe349,
+        0xe362,0xe5c8,0xe5cc,0xeaa0, 0xf2fd,0xf490,0xfc10,0xfcc1,
+        0xfe8d,0xfe92,0x104ab,0x104cf, 0x11149,0x1114e,0x11169,0x1130e,
+        0x11329,0x1132e,0x1140a,0x1140b, 0x1140c,0x115a8,0x115ad,0x11689,
+        0x1168e,0x11690,0x11b6c,0x11de9, 0x11dee,0x11e0e,0x1238a,0x1238e,
+        0x1238f,0x126bf,0x126c3,0x1272d, 0x12748,0x1276c,0x13281,0x1334d,
+        0x135f0,0x13600,0x139ad,0x139b2, 0x13e03,0x13e04,0x1445f,0x14463,
+        0x14583,0x14584,0x14594,0x145a2, 0x146f7,0x151ad,0x15531,0x15538,
+        0x1553d,0x15604,0x15781,0x159c1, 0x159e5,0x15a1e,0x15d7e,0x15f0a,
+        0x15f1b,0x15f1c,0x16653,0x16677, 0x171d1,0x171d6,0x171f0,0x171f5,
+        0x17493,0x17569,0x1770a,0x17908, 0x1790d,0x17956,0x179e9,0x17c86,
+        0x17c8c,0x17ca1,0x184b3,0x187aa, 0x187ce,0x19108,0x19114,0x19128,
+        0x1912d,0x191e9,0x191ee,0x193aa, 0x19488,0x19899,0x1992c,0x19969,
+        0x1996e,0x19970,0x19be8,0x19bed, 0x19c08,0x19c0c,0x19e8e,0x1a4a7,
+        0x1a7ae,0x1a7c4,0x1a7c9,0x1a7cd, 0x1a7e8,0x1ab8b,0x1ab8c,0x1b4c0,
+        0x1be11,0x1c563,0x1c564,0x1cbbf, 0x1d819,0x1dc62,0x1dee1,0x1e222,
+        0x1e6d0,0x1e97e,0x1ee80,0x1f019, 0x1f6cd,0x1f6e1,0x200d3,0x20637,
+        0x2064b,0x20986,0x20998,0x209a1, 0x20cbb,0x20e3b,0x20f95,0x211ed,
+        0x211f9,0x21214,0x2149c,0x2156d, 0x21572,0x2170e,0x21a0c,0x21bb2,
+        0x21bcd,0x21bd2,0x22067,0x22187, 0x22188,0x2218c,0x227dd,0x23206,
+        0x23208,0x233a4,0x233a9,0x23704, 0x23881,0x23896,0x23b0e,0x23bea,
+        0x23c1a,0x2418a,0x2418c,0x2473e, 0x24c3b,0x24cbf,0x2515e,0x2541c,
+        0x2569e,0x2588a,0x258a0,0x25b04, 0x25b09,0x25b2d,0x25b32,0x25dc5,
+        0x25dd0,0x25de9,0x26739,0x26758, 0x2675d,0x26776,0x268bb,0x268df,
+        0x26c3f,0x26d93,0x27081,0x2708a, 0x27304,0x27314,0x27332,0x275d0,
+        0x2780a,0x27a84,0x27a94,0x27b70, 0x27b75,0x27d06,0x27d16,0x27d17,
+        0x27df2,0x27df4,0x280cf,0x2877a, 0x2883b,0x28d97,0x29016,0x29284,
+        0x2928e,0x2934c,0x29506,0x29508, 0x295ce,0x295e9,0x29619,0x2980e,
+        0x2980f,0x29a8d,0x29d25,0x29d50, 0x29d72,0x2a2bf,0x2a863,0x2a873,
+        0x2a993,0x2b289,0x2b861,0x2ba09, 0x2d042,0x2d119,0x2d2e0,0x2d49d,
+        0x2dc1d,0x2e9c0,0x2ed62,0x30398, 0x30736,0x3073c,0x3074a,0x30750,
+        0x3075a,0x3076e,0x30770,0x30775, 0x30ebb,0x31306,0x3132c,0x315ae,
+        0x315b0,0x315b5,0x315d2,0x31a8c, 0x31a96,0x31b72,0x31d10,0x31d30,
+        0x31d35,0x31dec,0x320c3,0x320d3, 0x32586,0x3259c,0x32aa7,0x32d8a,
+        0x32d8f,0x33004,0x33009,0x3300e, 0x33286,0x33287,0x33288,0x33292,
+        0x332a1,0x33369,0x3350a,0x33530, 0x335cd,0x339e8,0x33d24,0x33d29,
+        0x33d48,0x33d4d,0x33d52,0x3403f, 0x342a7,0x34e3b,0x34e5f,0x35004,
+        0x35009,0x35022,0x3528c,0x352a1, 0x35529,0x35552,0x35a01,0x35a06,
+        0x35a0c,0x35bad,0x35bb2,0x35f08, 0x35f0d,0x36077,0x36197,0x362db,
+        0x367b4,0x367b9,0x367d8,0x3698a, 0x36a5b,0x36cbf,0x3711c,0x3713a,
+        0x371fd,0x37206,0x3720c,0x37216, 0x37217,0x37221,0x3749a,0x37708,
+        0x37714,0x37959,0x37978,0x3797d, 0x37bf0,0x37bf5,0x37c1a,0x3818a,
+        0x3818b,0x3818c,0x38237,0x3825b, 0x387dc,0x387fa,0x39159,0x393ad,
+        0x393b2,0x393cc,0x393d1,0x39699, 0x3988e,0x39890,0x39b12,0x39b2d,
+        0x39b32,0x39da5,0x39db0,0x3a380, 0x3a39e,0x3a746,0x3a761,0x3af4f,
+        0x3b58b,0x3c098,0x3c0a1,0x3c31a, 0x3c359,0x3c3dd,0x3c4a3,0x3c4a4,
+        0x3c4a8,0x3c4b3,0x3c4c2,0x3c4d7, 0x3c818,0x3ca67,0x3ce1e,0x3dfcb,
+        0x3e267,0x3e273,0x3e29a,0x3e339, 0x3e352,0x3e4ea,0x3e4ec,0x3e4ee,
+        0x3e4ef,0x3e4fb,0x3e4fc,0x3e514, 0x3e5f0,0x3e5f5,0x3e8a3,0x3e8b3,
+        0x3e8d3,0x3e8d7,0x40427,0x4044b, 0x4075e,0x40c7f,0x40d8e,0x40d9f,
+        0x4136d,0x415dd,0x415fc,0x4160a, 0x419a4,0x419a9,0x41d2d,0x41e0e,
+        0x41fa1,0x4245b,0x42460,0x4258e, 0x4263b,0x426e2,0x426f3,0x4351e,
+        0x4352d,0x43539,0x43558,0x4355d, 0x4360e,0x439ad,0x43a1a,0x43a1b,
+        0x43a1c,0x43c89,0x43d7a,0x43f0c, 0x43f18,0x44673,0x451ad,0x451cd,
+        0x451d2,0x45904,0x45909,0x45914, 0x4592d,0x45932,0x45c88,0x46667,
+        0x467ac,0x467ca,0x46a2f,0x47104, 0x47109,0x4710e,0x47110,0x47129,
+        0x471e5,0x471ea,0x47488,0x47494, 0x4789e,0x47928,0x4792d,0x47965,
+        0x47bed,0x47bf9,0x47c08,0x47c14, 0x47e8a,0x47e8c,0x47e96,0x484a3,
+        0x484c7,0x487aa,0x487c9,0x487ce, 0x487f2,0x48b8c,0x49080,0x4912d,
+        0x493e9,0x49409,0x49414,0x4968c, 0x49696,0x49b50,0x49c0d,0x49c21,
+        0x49dcd,0x4a388,0x4a423,0x4a4fb, 0x4a6b7,0x4a77e,0x4ac7b,0x4ad9b,
+        0x4b31d,0x4ba9d,0x4bee1,0x4c133, 0x4c222,0x4c3b6,0x4c452,0x4c97e,
+        0x4c97f,0x4cc02,0x4ce80,0x4d611, 0x4e17a,0x4e3e3,0x4e3e4,0x4f709,
+        0x50183,0x50184,0x501a2,0x5066f, 0x50aa7,0x51106,0x51108,0x5110d,
+        0x51112,0x51126,0x511e9,0x513b0, 0x513c9,0x51486,0x5148c,0x51898,
+        0x51950,0x51969,0x51b0a,0x51c06, 0x51c0c,0x51c16,0x51e80,0x51e84,
+        0x51e8e,0x51e90,0x524db,0x524e0, 0x524ff,0x527c8,0x527cd,0x52b9b,
+        0x52b9c,0x53098,0x5309d,0x53145, 0x53155,0x53169,0x5331b,0x5331c,
+        0x533d9,0x533f1,0x533f8,0x5340c, 0x53416,0x535b9,0x53685,0x5368e,
+        0x53b3e,0x53b78,0x53db8,0x53dbd, 0x53ddc,0x5438c,0x54437,0x544df,
+        0x546bf,0x5472e,0x5474d,0x54778, 0x5516d,0x5531a,0x5534d,0x559b4,
+        0x55d08,0x55d19,0x55e14,0x566d3, 0x566e7,0x566f7,0x56748,0x5676c,
+        0x56776,0x57018,0x57508,0x57528, 0x57604,0x57609,0x5760e,0x57610,
+        0x579ad,0x579cc,0x57d69,0x57d6e, 0x58583,0x58588,0x5863f,0x58643,
+        0x5899e,0x591ad,0x591b2,0x591c6, 0x5953d,0x59570,0x59914,0x5992d,
+        0x599f0,0x59c86,0x59c88,0x59c8d, 0x59c92,0x5a07f,0x5a19a,0x5a677,
+        0x5a7aa,0x5bb1d,0x5bcc0,0x5c280, 0x5c502,0x5d171,0x5d691,0x5e1a7,
+        0x5e38d,0x5e54a,0x5e54e,0x5e560, 0x5ea22,0x5f40d,0x60263,0x606a7,
+        0x606cb,0x606ef,0x60d8b,0x60d8c, 0x6100a,0x61294,0x61370,0x61506,
+        0x6150c,0x61516,0x615ed,0x61d49, 0x61d6d,0x61d72,0x6203b,0x622a3,
+        0x62867,0x62982,0x62987,0x62988, 0x62e5b,0x6300e,0x631bc,0x63525,
+        0x63549,0x6356d,0x63572,0x6393c, 0x639fd,0x63a02,0x63a08,0x63a0d,
+        0x63ba9,0x63f09,0x63f14,0x64073, 0x64182,0x64193,0x647b0,0x647b5,
+        0x647be,0x647d4,0x6498c,0x64996, 0x64997,0x64a57,0x64cbb,0x64cdf,
+        0x64e5f,0x65118,0x651f9,0x65208, 0x65212,0x653a9,0x6549c,0x65714,
+        0x6596d,0x65979,0x65bf6,0x65c1c, 0x65e9e,0x66188,0x6618c,0x66197,
+        0x66233,0x66257,0x667d8,0x66b8f, 0x673c8,0x673cd,0x673d2,0x673ec,
+        0x6769e,0x67885,0x6788a,0x6788c, 0x67896,0x67b0e,0x67b32,0x67dac,
+        0x67db1,0x6839a,0x6839c,0x683a0, 0x68724,0x68b8e,0x6908c,0x69096,
+        0x6917d,0x69304,0x6930e,0x69310, 0x69329,0x693e5,0x695a6,0x69816,
+        0x69b65,0x69b6a,0x69b71,0x6a8df, 0x6a8e3,0x6ac3f,0x6ad88,0x6bc99,
+        0x6c143,0x6c144,0x6c162,0x6c599, 0x6c8a0,0x6cb22,0x6cb34,0x6cb41,
+        0x6cdaa,0x6cdc0,0x6d011,0x6d290, 0x6d919,0x6dac1,0x6dc9d,0x6e2f2,
+        0x6ea30,0x6eb6a,0x6ede4,0x6ef8f, 0x6ef91,0x6f109,0x6f210,0x6f2c1,
+        0x6fa09,0x6fc0d,0x701a0,0x7022b, 0x707c1,0x707c5,0x707d0,0x707d5,
+        0x707da,0x707e5,0x707ee,0x707f0, 0x713ca,0x713f0,0x713f5,0x7141e,
+        0x71698,0x71884,0x71889,0x7188e, 0x71890,0x71b08,0x71b4a,0x71db0,
+        0x71dc9,0x72263,0x7239e,0x723a2, 0x72738,0x7275c,0x728bf,0x728c3,
+        0x72edb,0x73080,0x7308e,0x73308, 0x7330d,0x73312,0x73331,0x735a5,
+        0x735b0,0x735c9,0x73800,0x73a82, 0x73a86,0x73d0a,0x73dcd,0x73e1d,
+        0x740bf,0x740c3,0x74ebb,0x74edf, 0x75350,0x75355,0x75369,0x75516,
+        0x75618,0x75804,0x75814,0x759ba, 0x75a86,0x75a8c,0x75aa1,0x75d0e,
+        0x75d29,0x75d4d,0x75d52,0x75f8d, 0x762b3,0x76853,0x76877,0x76adb,
+        0x76e3b,0x7700e,0x7728c,0x7750f, 0x7752e,0x77530,0x77552,0x77789,
+        0x7791c,0x77a0c,0x77c9a,0x77d6c, 0x77f12,0x78043,0x78053,0x7898a,
+        0x7898b,0x7898c,0x78a27,0x791fd, 0x79206,0x79207,0x79208,0x7949a,
+        0x7954d,0x79704,0x79714,0x79949, 0x79959,0x79a0a,0x79a0c,0x79ba8,
+        0x79bad,0x79bb2,0x7a18a,0x7a18b, 0x7a18c,0x7a7b9,0x7a7d8,0x7a7dd,
+        0x7aa5b,0x7acbf,0x7b72b,0x7c027, 0x7c057,0x7c2f3,0x7c3b0,0x7c3b5,
+        0x7c643,0x7c648,0x7c668,0x7c66c, 0x7c898,0x7ccbe,0x7e06f,0x7e3d2,
+        0x7e68e,0x7ea43,0x7ea62,0x7ea67, 0x7ea73,0x80867,0x80a23,0x80b98,
+        0x81099,0x8109e,0x81165,0x81170, 0x81175,0x81318,0x81408,0x81414,
+        0x8168a,0x81b49,0x81b5e,0x81b7d, 0x81db9,0x81dd1,0x81dd8,0x81ddd,
+        0x8238c,0x82397,0x82433,0x826bb, 0x82749,0x8274e,0x82774,0x82d8e,
+        0x82d8f,0x83349,0x8340c,0x835cd, 0x83b7d,0x83d2d,0x83e0e,0x83e10,
+        0x8458a,0x846e3,0x846f3,0x84768, 0x85509,0x8550e,0x85529,0x85605,
+        0x8560a,0x859a9,0x859c8,0x859cd, 0x859d2,0x85d6a,0x8658e,0x8663b,
+        0x86640,0x8665f,0x8699a,0x8699c, 0x869a0,0x871a9,0x871cd,0x871d2,
+        0x8755d,0x8757c,0x87904,0x8790e, 0x87910,0x87929,0x879e5,0x87c83,
+        0x87c89,0x8807b,0x8819a,0x8819b, 0x88643,0x88673,0x8910e,0x893b8,
+        0x893bd,0x89484,0x89492,0x89718, 0x8992d,0x89932,0x89951,0x89bda,
+        0x89be9,0x89bf9,0x89bfe,0x8a4d3, 0x8a7ac,0x8a7ee,0x8ab88,0x8b410,
+        0x8b68d,0x8b692,0x8c389,0x8c54a, 0x8c54b,0x8c54c,0x8c6b2,0x8d30d,
+        0x8d409,0x8e200,0x8e720,0x8f441, 0x90467,0x90623,0x90983,0x90984,
+        0x90994,0x909a2,0x90e7b,0x911f5, 0x9155a,0x91569,0x91579,0x9157e,
+        0x91902,0x91908,0x919e9,0x91bde, 0x91c8c,0x91c96,0x9219e,0x921a2,
+        0x927b0,0x93108,0x93112,0x93113, 0x93114,0x931e9,0x9348c,0x93496,
+        0x9371a,0x93950,0x93955,0x93969, 0x93bd9,0x93c06,0x93e8e,0x93e95,
+        0x944a7,0x944b7,0x947ae,0x947d4, 0x947e8,0x947ed,0x94b8a,0x94b8b,
+        0x94b8c,0x9510c,0x95169,0x9516e, 0x95175,0x953e8,0x953ed,0x95969,
+        0x9596d,0x95b29,0x95b2e,0x95c0a, 0x95c0c,0x95da8,0x95dad,0x95dcc,
+        0x95e84,0x95e89,0x95e8e,0x9638a, 0x9638b,0x9638c,0x964ff,0x96729,
+        0x9672e,0x967ec,0x96c7f,0x97169, 0x97305,0x97330,0x9740c,0x97416,
+        0x975ad,0x9768e,0x97a9a,0x97aa0, 0x97e04,0x97e0e,0x97e10,0x9838a,
+        0x98437,0x9845b,0x986bf,0x986c3, 0x986e2,0x98748,0x98d9e,0x9929a,
+        0x99359,0x99371,0x99378,0x9951e, 0x995fa,0x9960e,0x999ad,0x999b2,
+        0x99d38,0x99d3d,0x99d5c,0x9a58e, 0x9a980,0x9b910,0x9b9f1,0x9be75,
+        0x9c334,0x9c5a6,0x9c5c1,0x9d1f1, 0x9d489,0x9d909,0x9dc09,0x9dc8d,
+        0x9e5e0,0x9e5e4,0x9e820,0x9eb8d, 0x9eb92,0x9fe91,0xa039f,0xa04c3,
+        0xa0758,0xa0c3f,0xa1081,0xa108a, 0xa1090,0xa1309,0xa1312,0xa1314,
+        0xa1332,0xa15d0,0xa1a84,0xa1a89, 0xa1b70,0xa1d06,0xa1d0c,0xa1d16,
+        0xa1dc9,0xa1ded,0xa1df2,0xa20bb, 0xa20c0,0xa20df,0xa2593,0xa2594,
+        0xa2d96,0xa2d97,0xa2edb,0xa3294, 0xa3356,0xa3370,0xa3506,0xa3516,
+        0xa35c9,0xa35f2,0xa3809,0xa380e, 0xa39da,0xa3a88,0xa3d0a,0xa3d30,
+        0xa3d35,0xa3d49,0xa4873,0xa4e5b, 0xa500e,0xa5010,0xa5288,0xa528d,
+        0xa5294,0xa550c,0xa554e,0xa5550, 0xa578e,0xa5918,0xa591d,0xa5a08,
+        0xa5a0d,0xa5a12,0xa5a14,0xa5c9c, 0xa5d6d,0xa5d72,0xa5f04,0xa5f0e,
+        0xa62c7,0xa6987,0xa6988,0xa698c, 0xa6a23,0xa6a33,0xa6f85,0xa756d,
+        0xa7572,0xa7704,0xa770e,0xa7710, 0xa7a08,0xa7a21,0xa7ba9,0xa7bcd,
+        0xa7bd2,0xa8187,0xa8188,0xa8223, 0xa8b8a,0xa8cbb,0xa8cdf,0xa913c,
+        0xa9208,0xa93cd,0xa93d2,0xa9886, 0xa988c,0xa9b0e,0xa9b29,0xa9c1c,
+        0xaa396,0xaa39b,0xaa39c,0xaa730, 0xaa73e,0xaa7fc,0xaa8b7,0xaac3b,
+        0xaac5f,0xaacbf,0xac0b2,0xac8f0, 0xac92e,0xac92f,0xac954,0xacbd6,
+        0xacbd7,0xacbd8,0xacbe1,0xad811, 0xada90,0xadd0d,0xadd12,0xadf83,
+        0xadf8f,0xadf91,0xae120,0xae12a, 0xae12e,0xae140,0xaeb00,0xaed8d,
+        0xaf78f,0xaf909,0xafc8d,0xaff11, 0xb02ab,0xb07a8,0xb07b2,0xb0a2b,
+        0xb0cbf,0xb0f8d,0xb111c,0xb1206, 0xb120c,0xb149f,0xb1708,0xb170d,
+        0xb1718,0xb1bf0,0xb2237,0xb27dc, 0xb27fa,0xb2a5f,0xb2a63,0xb314d,
+        0xb3159,0xb388e,0xb3b08,0xb3db0, 0xb3db5,0xb439e,0xb4732,0xb4738,
+        0xb473d,0xb48af,0xb4edb,0xb508e, 0xb508f,0xb5312,0xb5314,0xb53ee,
+        0xb53f0,0xb53f5,0xb541e,0xb5b2c, 0xb5b50,0xb5b70,0xb5b75,0xb5dd2,
+        0xb5ded,0xb5df2,0xb5e18,0xb5e1d, 0xb675a,0xb6765,0xb68e7,0xb6d8b,
+        0xb6d8c,0xb7084,0xb7089,0xb708e, 0xb734a,0xb7351,0xb75a5,0xb75ed,
+        0xb75f2,0xb7618,0xb7804,0xb7809, 0xb780e,0xb7810,0xb79aa,0xb7a86,
+        0xb7a88,0xb7a92,0xb7b64,0xb7b69, 0xb7d0a,0xb7d25,0xb7d30,0xb7d49,
+        0xb80c3,0xb80e2,0xb80e7,0xb8598, 0xb859c,0xb883f,0xb8aa7,0xb8e5b,
+        0xb8edf,0xb900e,0xb91bc,0xb9282, 0xb9288,0xb928d,0xb92a1,0xb9369,
+        0xb950a,0xb9510,0xb9530,0xb99ed, 0xb99fd,0xb9a02,0xb9c9c,0xb9d4d,
+        0xb9d52,0xb9d71,0xb9f09,0xb9f14, 0xba03f,0xba2b3,0xba2d7,0xba98c,
+        0xba996,0xba997,0xbae3b,0xbae5f, 0xbc0fb,0xbc460,0xbc46a,0xbc46e,
+        0xbc46f,0xbc545,0xbc608,0xbc6e7, 0xbc6e8,0xbc6ec,0xbc827,0xbc833,
+        0xbc857,0xbcaab,0xbe023,0xbe027, 0xbe033,0xbe3a5,0xbe62a,0xbe62e,
+        0xbe62f,0xbe643,0xbe64e,0xbe654, 0xbe662,0xbe673,0xbe87e,0xbeae3,
+        0xbeae7,0xbef4b,0xbf74f,0xc0037, 0xc112d,0xc1132,0xc11f0,0xc1488,
+        0xc148d,0xc1492,0xc1956,0xc1970, 0xc1975,0xc1bed,0xc1c08,0xc1c13,
+        0xc1e8a,0xc1e96,0xc24b3,0xc24c7, 0xc27aa,0xc27ce,0xc27e9,0xc27ed,
+        0xc3128,0xc312d,0xc3132,0xc3165, 0xc316a,0xc33e9,0xc3414,0xc368a,
+        0xc3969,0xc396e,0xc3b49,0xc3b4e, 0xc3c06,0xc3c08,0xc3dad,0xc3dc8,
+        0xc3dcd,0xc3e8a,0xc3e8e,0xc4387, 0xc4388,0xc438c,0xc44fb,0xc472a,
+        0xc474e,0xc47e8,0xc533c,0xc5408, 0xc540d,0xc55a9,0xc55d2,0xc568a,
+        0xc56a0,0xc5a9c,0xc5aa1,0xc5b6d, 0xc5d0e,0xc5e0a,0xc5e10,0xc5e15,
+        0xc5e20,0xc638c,0xc6433,0xc6457, 0xc66bb,0xc66df,0xc66e3,0xc6749,
+        0xc6772,0xc6c7f,0xc6d9a,0xc6d9f, 0xc7298,0xc736d,0xc751a,0xc75d8,
+        0xc75dd,0xc760a,0xc79a9,0xc79cd, 0xc7d39,0xc7d58,0xc7d5d,0xc7fa1,
+        0xc845b,0xc858e,0xc858f,0xc863b, 0xc8768,0xc91a9,0xc954d,0xc960e,
+        0xc960f,0xc99ad,0xc99f1,0xc99f6, 0xc9a1c,0xc9f0c,0xca663,0xca673,
+        0xcb111,0xcb661,0xcb70d,0xcbe8d, 0xcbe92,0xcc362,0xcc366,0xcc5e1,
+        0xcc5ea,0xcc5ee,0xccb89,0xcdc09, 0xcdce0,0xce2a0,0xce528,0xce541,
+        0xce556,0xce9fc,0xcea00,0xceb99, 0xcec82,0xcf319,0xcf415,0xcfa99,
+        0xd044f,0xd1018,0xd101d,0xd129a, 0xd1508,0xd1604,0xd19d6,0xd1d69,
+        0xd2588,0xd2593,0xd2594,0xd2653, 0xd31a8,0xd31ad,0xd31b2,0xd354a,
+        0xd3914,0xd39e9,0xd39ee,0xd39f0, 0xd39f5,0xd3c86,0xd3c88,0xd3c8c,
+        0xd3d79,0xd4180,0xd4642,0xd4647, 0xd47aa,0xd51c5,0xd51f0,0xd521e,
+        0xd5486,0xd5488,0xd548d,0xd5492, 0xd54a1,0xd570a,0xd5906,0xd5908,
+        0xd5921,0xd5926,0xd5945,0xd5bc9, 0xd64a7,0xd67ae,0xd67c4,0xd67c9,
+        0xd6b8a,0xd6b98,0xd7108,0xd7131, 0xd717a,0xd73ba,0xd73c9,0xd73de,
+        0xd748c,0xd7969,0xd7b0a,0xd7b1c, 0xd7bf8,0xd7c06,0xd7c0c,0xd7dad,
+        0xd7db9,0xd7dd8,0xd7ddd,0xd7e8e, 0xd84db,0xd84ff,0xd9169,0xd9170,
+        0xd930a,0xd93fd,0xd9406,0xd940c, 0xd9416,0xd968e,0xd9690,0xd9b4d,
+        0xd9b59,0xda38a,0xda38b,0xda38c, 0xda396,0xda427,0xda437,0xda72e,
+        0xda768,0xdad8e,0xdc3d4,0xdc882, 0xdcc20,0xdcea2,0xdd509,0xddc89,
+        0xdde41,0xde082,0xde300,0xdede0, 0xdedfa,0xdef8f,0xdf641,0xdf71d,
+        0xe07fc,0xe0857,0xe0cbf,0xe113a, 0xe120c,0xe13b2,0xe13b4,0xe188a,
+        0xe1978,0xe197d,0xe1b04,0xe1b32, 0xe1b34,0xe1be5,0xe226f,0xe239a,
+        0xe2724,0xe2739,0xe2758,0xe28ab, 0xe28bb,0xe308a,0xe308c,0xe3096,
+        0xe309c,0xe3304,0xe330e,0xe35ac, 0xe3b2d,0xe3dce,0xe3dd0,0xe3dd5,
+        0xe3df2,0xe3e19,0xe4761,0xe48e3, 0xe48f3,0xe4d86,0xe4d87,0xe4d88,
+        0xe508a,0xe532d,0xe55a5,0xe55d0, 0xe55e9,0xe5805,0xe580a,0xe5a84,
+        0xe5a89,0xe5a8d,0xe5a94,0xe5d0c, 0xe5d16,0xe5d25,0xe5d2a,0xe5d31,
+        0xe5f95,0xe60df,0xe60e3,0xe6598, 0xe683b,0xe685f,0xe6aa3,0xe6ac2,
+        0xe6ac7,0xe700a,0xe7010,0xe71bd, 0xe7284,0xe7289,0xe7292,0xe7294,
+        0xe7365,0xe750c,0xe75ed,0xe7795, 0xe79f9,0xe7d49,0xe7d72,0xe7f0e,
+        0xe803b,0xe82c2,0xe82d3,0xe867b, 0xe8988,0xe8e5b,0xe91e9,0xe9498,
+        0xe949d,0xe9550,0xe9555,0xe9572, 0xe9918,0xe995a,0xe9a08,0xe9ba9,
+        0xe9f04,0xea073,0xea188,0xea193, 0xea7a5,0xea7be,0xea7c4,0xea988,
+        0xea98c,0xeaa57,0xeacbb,0xeb061, 0xeb209,0xeb88d,0xeb892,0xec000,
+        0xec18d,0xec39d,0xec9ce,0xecd66, 0xecd67,0xecd68,0xecd6d,0xecf00,
+        0xed08d,0xed241,0xee1c0,0xee1c4, 0xee1c9,0xee578,0xee920,0xeebc2,
+        0xf0581,0xf058a,0xf0590,0xf0596, 0xf059b,0xf059c,0xf05a0,0xf0e3b,
+        0xf0e5f,0xf1004,0xf1012,0xf1014, 0xf11ba,0xf1286,0xf128c,0xf1296,
+        0xf1297,0xf150e,0xf1510,0xf1529, 0xf1794,0xf19d9,0xf19f8,0xf19fd,
+        0xf1a06,0xf1a16,0xf1c9a,0xf1f08, 0xf1f14,0xf2053,0xf22cb,0xf22db,
+        0xf298a,0xf298c,0xf2a37,0xf31d9, 0xf31ed,0xf31fd,0xf349a,0xf354d,
+        0xf356c,0xf3571,0xf3714,0xf3959, 0xf3a0a,0xf3a0c,0xf3bb2,0xf418a,
+        0xf418b,0xf418c,0xf4196,0xf47c6, 0xf47e1,0xf498f,0xf511a,0xf520a,
+        0xf520c,0xf5216,0xf53ad,0xf53b2, 0xf5706,0xf5708,0xf5b14,0xf5bc5,
+        0xf5bca,0xf5bf0,0xf5c1e,0xf5e98, 0xf5e9d,0xf618a,0xf618e,0xf625b,
+        0xf6380,0xf6c3f,0xf73e5,0xf73f0, 0xf788e,0xf7b08,0xf7b0d,0xf7db0,
+        0xf7db5,0xf7dc9,0xf839e,0xf8738, 0xf875c,0xf88bf,0xf88c3,0xf8edb,
+        0xf908e,0xf9090,0xf9308,0xf9314, 0xf9356,0xf95c9,0xf95d5,0xf980e,
+        0xf9a88,0xf9b69,0xf9d0a,0xfa0f3, 0xfa598,0xfaab3,0xfad8b,0xfae5b,
+        0xfc006,0xfc433,0xfc53d,0xfc5c5, 0xfc6aa,0xfc6ab,0xfc6ac,0xfc8a7,
+        0xfc8c7,0xfc8d7,0xfcc7f,0xfd7ef, 0xfe0a3,0xfe0c2,0xfe0c7,0xfe0d7,
+        0xfe44a,0xfe44b,0xfe44c,0xfe46a, 0xfe518,0xfe575,0xfe6c0,0xfe6ce,
+        0xfe6e3,0xfe6e4,0xfe6e8,0xfe6f3, 0xfe833,0xfea1e,0xfec98,0xfee5a,
+        0xfee5f,0xfefcb,0xfff4f,
+        0
+};
 
-    cnt = 0;
-    for (i = 0; i < n; i++)
-    {
-        double dx = p[i].x - x;
-        double dz = p[i].z - z;
-        int px, pz;
+static const uint64_t low20TriHutNo11[] =
+{
+        0xecc,0x1628,0x1e6e,0x200b, 0x25ac,0x25cc,0x2a79,0x2a89,
+        0x2a8a,0x2aa9,0x2e32,0x371d, 0x38b9,0x3921,0x411a,0x41c7,
+        0x4939,0x4e70,0x5128,0x54ac, 0x573f,0x5d9a,0x62cc,0x6679,
+        0x6ba9,0x6cac,0x7030,0x70d2, 0x70f6,0x71c3,0x72b2,0x72d6,
+        0x74e9,0x7834,0x7852,0x7876, 0x7a13,0x7ab6,0x7af0,0x7c4e,
+        0x7c69,0x7ed6,0x806c,0x8228, 0x824c,0x8698,0x872e,0x8734,
+        0x89b6,0x8cf4,0x9469,0x95c3, 0x9a18,0xa43d,0xa6c5,0xa88d,
+        0xadbe,0xadcf,0xb177,0xb615, 0xb7bd,0xbd5d,0xbd77,0xc486,
+        0xcd2b,0xcd3e,0xce15,0xcfb8, 0xd558,0xd7da,0xd7eb,0xdf37,
+        0xdf3c,0xdf5a,0xe1be,0xe1de, 0xe2fe,0xe4a0,0xefeb,0xf748,
+        0x1012b,0x10145,0x1014a,0x10215, 0x10cae,0x10cc9,0x10f43,0x114ec,
+        0x11818,0x11ad9,0x11af2,0x11c56, 0x1215f,0x1220b,0x1269a,0x126a5,
+        0x1272d,0x12732,0x13018,0x13452, 0x13a1a,0x13e21,0x1419a,0x1488a,
+        0x1488b,0x1488e,0x1488f,0x148a9, 0x149b9,0x14c2e,0x14ddb,0x14ecc,
+        0x1521a,0x1546c,0x15a39,0x15d5f, 0x15d7d,0x15e6e,0x15e74,0x16337,
+        0x165ac,0x16930,0x16a89,0x16c6c, 0x16e28,0x171a1,0x17230,0x17272,
+        0x1766e,0x178b4,0x17908,0x1797a, 0x17b9b,0x17d9a,0x1800a,0x1800f,
+        0x1802e,0x180ec,0x181b9,0x181c7, 0x181db,0x1836f,0x185f2,0x185f4,
+        0x18934,0x18952,0x18976,0x18aa8, 0x1972d,0x198b2,0x19925,0x1992a,
+        0x19cc9,0x1a7a7,0x1a938,0x1a93d, 0x1a946,0x1a961,0x1abbc,0x1ac8d,
+        0x1af1c,0x1b0bd,0x1b8da,0x1b8e0, 0x1b8e5,0x1c048,0x1c703,0x1d0da,
+        0x1d0dc,0x1d0ff,0x1d33a,0x1d35e, 0x1d59e,0x1d818,0x1d81d,0x1d83c,
+        0x1d83d,0x1dabe,0x1dade,0x1eb4b, 0x1f03d,0x2090d,0x21028,0x2104c,
+        0x21070,0x21118,0x212d4,0x212f2, 0x215bb,0x2193f,0x21a0b,0x21a30,
+        0x21cd9,0x21de3,0x21df1,0x21eb9, 0x2218b,0x229ae,0x229b4,0x2306e,
+        0x2320b,0x23225,0x2322a,0x23230, 0x235df,0x23a49,0x23a76,0x23c1f,
+        0x2418f,0x24754,0x24892,0x24897, 0x24898,0x24949,0x249ec,0x25249,
+        0x257c3,0x258b2,0x2610a,0x2610f, 0x265b9,0x265d2,0x26952,0x2696c,
+        0x26971,0x26a81,0x26d3b,0x26e1a, 0x26eb9,0x270b4,0x27459,0x27563,
+        0x27575,0x27581,0x27639,0x278fa, 0x27f47,0x28479,0x2896c,0x28a9a,
+        0x28fe7,0x290d6,0x290ec,0x290fa, 0x29832,0x29856,0x299bb,0x299df,
+        0x29ad0,0x2a6a0,0x2a845,0x2af53, 0x2b1eb,0x2ba0d,0x2bdeb,0x2c18d,
+        0x2d138,0x2d13d,0x2d20d,0x2d5eb, 0x2d93c,0x2dfab,0x2dfca,0x2ea5d,
+        0x2ea61,0x2edb8,0x2edd7,0x2f15a, 0x2f7ab,0x2fff3,0x30386,0x3039c,
+        0x30c39,0x310b6,0x31198,0x3119d, 0x31618,0x318ee,0x318f4,0x3191d,
+        0x31b77,0x31f5f,0x3296e,0x32d67, 0x32d8a,0x32e18,0x330ee,0x330f4,
+        0x3373b,0x3382c,0x33850,0x33aae, 0x33ac9,0x33ad2,0x345d9,0x347d9,
+        0x35008,0x35021,0x3502c,0x3511d, 0x351bf,0x352c9,0x352d2,0x357a1,
+        0x35869,0x35a05,0x35a0a,0x35a0f, 0x35a2e,0x35a49,0x35aec,0x35dbf,
+        0x3618a,0x36213,0x36531,0x36550, 0x36555,0x36574,0x36730,0x36735,
+        0x367b9,0x367d2,0x367f6,0x369b2, 0x369b4,0x36fa1,0x37074,0x371fa,
+        0x3720a,0x374d9,0x375bf,0x376b9, 0x37959,0x38752,0x3888d,0x38892,
+        0x389ec,0x38cd9,0x38eb9,0x3922e, 0x39252,0x39459,0x39a6c,0x39c39,
+        0x39fdb,0x3afaf,0x3b573,0x3bf57, 0x3c31e,0x3d3a0,0x3d733,0x3d9bc,
+        0x3d9cb,0x3e141,0x3e146,0x3f07d, 0x3f9de,0x3fdb7,0x3fdcb,0x40140,
+        0x40145,0x4014f,0x40406,0x40691, 0x40cf8,0x40cfd,0x41454,0x416d6,
+        0x41e28,0x41f0f,0x420ac,0x42197, 0x4276c,0x4287a,0x4288b,0x4288c,
+        0x42c4e,0x42c69,0x42ec8,0x42ed6, 0x432f4,0x43798,0x437bb,0x439a8,
+        0x43d5b,0x43e4c,0x43e70,0x43f18, 0x44333,0x445b6,0x44950,0x449d4,
+        0x449f2,0x44a8a,0x451a8,0x45250, 0x45547,0x4564c,0x458b0,0x458d4,
+        0x45cac,0x4600b,0x4602a,0x465ee, 0x465f4,0x46930,0x46935,0x46954,
+        0x46972,0x46a79,0x46aa8,0x4781a, 0x479c3,0x47cce,0x47ce9,0x4852c,
+        0x487ae,0x487c9,0x487ce,0x48d9d, 0x48f1d,0x490fd,0x49128,0x49c2c,
+        0x49eb4,0x4a139,0x4a147,0x4a4dd, 0x4a4e1,0x4a6a6,0x4af5e,0x4b5be,
+        0x4b5cf,0x4b953,0x4bd3e,0x4be15, 0x4bfbd,0x4c422,0x4c88d,0x4cdab,
+        0x4cdca,0x4dd53,0x4dfda,0x4dfeb, 0x4e461,0x4f7eb,0x501ab,0x501c0,
+        0x501c5,0x501ca,0x501de,0x502fb, 0x50aa7,0x51101,0x51cf6,0x5249d,
+        0x52549,0x5254e,0x527d6,0x52d9a, 0x534f6,0x53c2e,0x53c34,0x53f98,
+        0x53f9d,0x5415f,0x54696,0x54cc9, 0x54d8b,0x54f67,0x55013,0x552d0,
+        0x552f4,0x5542e,0x55449,0x5550b, 0x556b6,0x55a50,0x55ad4,0x55c6c,
+        0x55eee,0x5674c,0x569b0,0x569b5, 0x569d4,0x569f2,0x56c49,0x572d9,
+        0x5746c,0x576ee,0x57988,0x579a1, 0x57a1a,0x57a72,0x57e2c,0x57e50,
+        0x588a9,0x589d2,0x58c76,0x58ef0, 0x58f9d,0x59621,0x5971d,0x5a11a,
+        0x5a9d8,0x5a9dc,0x5a9dd,0x5a9e1, 0x5b239,0x5b23e,0x5b3bc,0x5b71b,
+        0x5b71c,0x5b97f,0x5bbde,0x5c93d, 0x5cc65,0x5cc6f,0x5d3ba,0x5d3ef,
+        0x5d8b8,0x5d8bd,0x5d8d6,0x5d8dc, 0x5db3a,0x5dd7a,0x5de95,0x5e11e,
+        0x5e124,0x5e2c5,0x5e2ca,0x5ea0d, 0x5f0b8,0x5f0bd,0x5f0dc,0x5f34b,
+        0x5f6a7,0x5f7fe,0x5f83d,0x608c4, 0x610cc,0x610f0,0x61747,0x61828,
+        0x61836,0x6184c,0x61918,0x61ace, 0x61ad4,0x61ae9,0x627d9,0x62f47,
+        0x63028,0x6304c,0x631df,0x632ce, 0x632e9,0x637a8,0x6386e,0x6391d,
+        0x63a01,0x63a0b,0x63a25,0x63a2a, 0x64536,0x64551,0x64570,0x64575,
+        0x64731,0x647b0,0x647b5,0x647f2, 0x649ae,0x649b0,0x649c9,0x6504c,
+        0x65070,0x65118,0x6511d,0x655bb, 0x655df,0x656d9,0x65a54,0x65a72,
+        0x65eb9,0x6618a,0x66759,0x66889, 0x66893,0x66894,0x669f6,0x66b23,
+        0x6722a,0x6724e,0x67254,0x67272, 0x676b9,0x67c59,0x67d63,0x67e39,
+        0x68739,0x6892e,0x68934,0x68949, 0x68f28,0x698d6,0x698ec,0x6a10a,
+        0x6a10f,0x6ac1c,0x6ad6f,0x6b72f, 0x6b9bd,0x6b9dc,0x6c142,0x6c146,
+        0x6c148,0x6c31f,0x6c821,0x6cb9c, 0x6d015,0x6d1b8,0x6d1bd,0x6d1dc,
+        0x6d758,0x6d777,0x6d93d,0x6ddb8, 0x6e2a4,0x6e426,0x6ed0d,0x6ef77,
+        0x6ef95,0x6f13d,0x6f1da,0x6f5b3, 0x6f93c,0x6f95a,0x6fa0d,0x6fdda,
+        0x7041c,0x71256,0x7126c,0x713cf, 0x718b6,0x71998,0x71d67,0x71e18,
+        0x72936,0x7294c,0x73567,0x737db, 0x738ac,0x738d0,0x738ee,0x74128,
+        0x74478,0x745b6,0x745d1,0x745f0, 0x745f5,0x7496e,0x74974,0x74a90,
+        0x74a93,0x74a94,0x74a99,0x74c39, 0x74fdb,0x75198,0x7519d,0x75618,
+        0x7561d,0x75808,0x75817,0x75836, 0x75918,0x7591d,0x759bf,0x75aae,
+        0x75ab0,0x76319,0x76e18,0x77017, 0x77028,0x77036,0x770ee,0x77118,
+        0x771bf,0x772b0,0x7786e,0x77874, 0x779fa,0x77af6,0x77b27,0x77cd9,
+        0x77dbf,0x77eb9,0x7902c,0x79050, 0x7906e,0x79074,0x792c9,0x792f6,
+        0x794d9,0x79a0a,0x79a0f,0x79a2e, 0x79a34,0x79a49,0x79a52,0x79c59,
+        0x7a18f,0x7aa41,0x7ab24,0x7adcb, 0x7b20c,0x7bc1f,0x7bd4f,0x7bfd7,
+        0x7c39f,0x7d41f,0x7d7d8,0x7d7e8, 0x7e1e5,0x7e1ea,0x7e487,0x7e495,
+        0x7ea91,0x7ec1f,0x7ed4b,0x7efd3, 0x7f72f,0x7f9bc,0x801e0,0x801ef,
+        0x802fb,0x802ff,0x8031e,0x8067b, 0x80f3f,0x814ce,0x814f2,0x8159a,
+        0x8177a,0x81d1a,0x81db9,0x8206c, 0x8215b,0x8224c,0x82692,0x82697,
+        0x82698,0x82cce,0x82ce9,0x83052, 0x83076,0x832b6,0x832f0,0x83430,
+        0x83856,0x83947,0x83a17,0x83a36, 0x83ad0,0x83af4,0x84197,0x8422c,
+        0x8426e,0x84888,0x849d0,0x849d5, 0x84b29,0x84eb4,0x85218,0x85d47,
+        0x85e4c,0x86c4e,0x86c72,0x86eec, 0x86efa,0x87656,0x877cd,0x877df,
+        0x87f1d,0x88117,0x881c3,0x885cc, 0x88959,0x88a79,0x88a8a,0x88a8e,
+        0x88a8f,0x88aa9,0x88fbb,0x89178, 0x89259,0x89274,0x89718,0x898f8,
+        0x89928,0x89cac,0x89cd0,0x8a00b, 0x8a11a,0x8a1d9,0x8a2ec,0x8a2f9,
+        0x8a480,0x8a491,0x8a49e,0x8ab80, 0x8af48,0x8b76a,0x8b76f,0x8bb04,
+        0x8bdab,0x8bdca,0x8c13e,0x8c144, 0x8c153,0x8c683,0x8d5ab,0x8d5ca,
+        0x8d92f,0x8e15d,0x8e400,0x8e41e, 0x8e41f,0x8e423,0x8e424,0x8f12b,
+        0x8f282,0x8f977,0x8f995,0x8ffbd, 0x8ffd7,0x8ffdc,0x9037b,0x9037f,
+        0x9039e,0x90c6c,0x90eee,0x91188, 0x9154d,0x9155f,0x9162c,0x91650,
+        0x925ce,0x925e9,0x92934,0x92976, 0x92aa8,0x92e2c,0x930b4,0x93276,
+        0x93389,0x9371a,0x938d6,0x93925, 0x9392a,0x93cc9,0x93d8b,0x9406c,
+        0x942ac,0x942ee,0x94498,0x94499, 0x94530,0x94535,0x947b4,0x94956,
+        0x94d7d,0x94e69,0x95125,0x9512a, 0x954ae,0x954c9,0x954d2,0x95813,
+        0x95832,0x95af9,0x95c49,0x9615b, 0x96208,0x96217,0x9656d,0x96572,
+        0x9669d,0x966a1,0x967ec,0x97818, 0x97ef0,0x9841d,0x98b09,0x99018,
+        0x991f8,0x995db,0x996cc,0x99798, 0x99a1a,0x99e28,0x99e36,0x99f18,
+        0x99f1d,0x99fbf,0x9ab4f,0x9b05a, 0x9b524,0x9b891,0x9ba1f,0x9ba3e,
+        0x9bc6a,0x9c9dd,0x9ccff,0x9cfa8, 0x9d21f,0x9d23e,0x9dbcb,0x9e0e1,
+        0x9e360,0x9e77f,0x9e791,0x9e7a3, 0x9f258,0x9f25d,0x9f48d,0x9f8b8,
+        0x9f8bd,0x9f8c6,0x9fd86,0x9fe83, 0xa0100,0xa0105,0xa011e,0xa0124,
+        0xa05b9,0xa05dd,0xa0958,0xa095d, 0xa0961,0xa0962,0xa0966,0xa0968,
+        0xa0a40,0xa0a64,0xa1563,0xa18f0, 0xa1f47,0xa2017,0xa2479,0xa25b2,
+        0xa25d6,0xa25f1,0xa2a90,0xa2a95, 0xa2c59,0xa2d3f,0xa2e39,0xa30d6,
+        0xa30ec,0xa3818,0xa3828,0xa3832, 0xa39bb,0xa3d05,0xa3d0a,0xa5013,
+        0xa5032,0xa510f,0xa51bb,0xa52ac, 0xa584c,0xa5870,0xa5918,0xa591d,
+        0xa5a08,0xa5ace,0xa5af2,0xa5dbb, 0xa704c,0xa7070,0xa7208,0xa72ce,
+        0xa72e9,0xa72f2,0xa794d,0xa7a25, 0xa7a2a,0xa7a30,0xa7a4e,0xa7a54,
+        0xa7a69,0xa7eb9,0xa7f28,0xa818b, 0xa81aa,0xa87d9,0xa89ae,0xa89c9,
+        0xa89d2,0xa915f,0xa920b,0xa9225, 0xa922a,0xa924e,0xa9269,0xa9fc3,
+        0xaadda,0xab41b,0xab41c,0xab54b, 0xab55a,0xab56a,0xab69e,0xabb86,
+        0xac1e1,0xac1e6,0xac4a7,0xac8c5, 0xacc1b,0xacc1c,0xacfcf,0xad72b,
+        0xad810,0xad815,0xad9b8,0xad9bd, 0xadf77,0xae31f,0xae320,0xaed8d,
+        0xaef2b,0xaf9da,0xaf9eb,0xafdb3, 0xb0f88,0xb104e,0xb1069,0xb1072,
+        0xb1205,0xb120a,0xb12ec,0xb1a56, 0xb1f25,0xb1f2a,0xb2193,0xb2559,
+        0xb2572,0xb2734,0xb2752,0xb27f1, 0xb29cc,0xb29d1,0xb29d6,0xb29f0,
+        0xb2cd9,0xb2dbf,0xb2eb9,0xb320f, 0xb3234,0xb3252,0xb3459,0xb3725,
+        0xb3d43,0xb492d,0xb4932,0xb4c59, 0xb5439,0xb5543,0xb57db,0xb58b6,
+        0xb58cc,0xb5998,0xb5e18,0xb5e1d, 0xb6489,0xb694c,0xb6a90,0xb6a99,
+        0xb6c39,0xb6fc7,0xb70b6,0xb70cc, 0xb7828,0xb78ee,0xb7ab0,0xb8303,
+        0xb8a99,0xb9028,0xb919d,0xb9821, 0xb982c,0xb9850,0xb986e,0xb9a01,
+        0xb9aae,0xb9ac9,0xb9ad2,0xbaae5, 0xbab9e,0xbaf38,0xbaf6b,0xbb1de,
+        0xbb31e,0xbb93a,0xbb95e,0xbd13a, 0xbd15e,0xbd211,0xbd27e,0xbd5ef,
+        0xbdc1f,0xbdd3a,0xbdfd3,0xbedef, 0xbf54b,0xbf7af,0xbf7d3,0xbfd73,
+        0xc01c8,0xc039e,0xc0e28,0xc0e4c, 0xc10b0,0xc1272,0xc18b4,0xc18f6,
+        0xc1cce,0xc1cd4,0xc1ce9,0xc1d9a, 0xc200a,0xc200f,0xc202e,0xc2049,
+        0xc22cc,0xc2499,0xc252c,0xc27ae, 0xc27b4,0xc27c9,0xc2952,0xc3121,
+        0xc34ce,0xc34e9,0xc3763,0xc3eb2, 0xc4147,0xc456e,0xc4574,0xc4692,
+        0xc47ec,0xc4cac,0xc5307,0xc5a18, 0xc5eec,0xc5efa,0xc672e,0xc6749,
+        0xc6752,0xc6ce9,0xc6d9a,0xc7034, 0xc744e,0xc751a,0xc76ec,0xc79f8,
+        0xc7fbb,0xc80ac,0xc8197,0xc876c, 0xc88aa,0xc89d0,0xc89f4,0xc8c4e,
+        0xc8c69,0xc8dc3,0xc8f8f,0xc9218, 0xc9236,0xc9270,0xc9632,0xc970f,
+        0xc9a50,0xc9a74,0xca008,0xca0ce, 0xcafc8,0xcbf6a,0xcbf6f,0xcc1be,
+        0xcc1c4,0xcc1de,0xcc1e2,0xcc2fe, 0xccd5d,0xccd77,0xccf3d,0xcd73c,
+        0xcd89e,0xcd9cf,0xce13e,0xce144, 0xce15e,0xce27e,0xce4a3,0xce4a4,
+        0xce695,0xce6a7,0xcef48,0xcef5a, 0xcfa15,0xcfdbe,0xcfdcf,0xd0162,
+        0xd0177,0xd0400,0xd040d,0xd0411, 0xd1036,0xd1070,0xd12d4,0xd146c,
+        0xd150f,0xd16ee,0xd16f4,0xd1988, 0xd19fa,0xd1a54,0xd1d3b,0xd1e2c,
+        0xd20ae,0xd20c9,0xd2879,0xd28a9, 0xd29b4,0xd29d2,0xd29f6,0xd2eea,
+        0xd2eee,0xd362c,0xd3a52,0xd3e69, 0xd400a,0xd45ac,0xd45ce,0xd45d0,
+        0xd4952,0xd49f1,0xd4a88,0xd4e21, 0xd4e36,0xd4f1d,0xd4fbf,0xd557d,
+        0xd57fa,0xd5cae,0xd600f,0xd61db, 0xd62fd,0xd6499,0xd65e9,0xd6d5f,
+        0xd6e6e,0xd6e74,0xd7108,0xd717a, 0xd74b0,0xd759a,0xd854e,0xd8554,
+        0xd8569,0xd8ba9,0xd9034,0xd90d6, 0xd91c7,0xd92b6,0xd94f6,0xd9856,
+        0xd9ad0,0xd9c2e,0xd9c49,0xd9c52, 0xd9ddb,0xd9ecc,0xda208,0xda22c,
+        0xda26e,0xdb83c,0xdbabe,0xdc08d, 0xdc3c6,0xdd026,0xdd03c,0xdd041,
+        0xdd505,0xdd783,0xdda1f,0xdda20, 0xdda25,0xddc48,0xde9be,0xde9c2,
+        0xdf1fb,0xdf21b,0xdf21c,0xdf21f, 0xdfa58,0xdfa5d,0xdfbbc,0xdfc8d,
+        0xdff1b,0xdff1c,0xe019e,0xe019f, 0xe01a0,0xe085c,0xe0ade,0xe0dbb,
+        0xe113f,0xe1230,0xe1254,0xe14d9, 0xe16b9,0xe1721,0xe197a,0xe1c59,
+        0xe1d3f,0xe1d63,0xe1e39,0xe2739, 0xe292e,0xe2934,0xe2949,0xe2cd9,
+        0xe2eb9,0xe317a,0xe3276,0xe3459, 0xe3639,0xe38d6,0xe410f,0xe4479,
+        0xe496c,0xe4fc3,0xe50b2,0xe50d6, 0xe55aa,0xe5813,0xe5998,0xe59bb,
+        0xe5aac,0xe6479,0xe6e39,0xe70cc, 0xe70fa,0xe7828,0xe784c,0xe79df,
+        0xe79fd,0xe7ace,0xe7ae9,0xe7af2, 0xe8532,0xe8571,0xe85f0,0xe85f5,
+        0xe86a1,0xe86a5,0xe87b1,0xe87d0, 0xe8f47,0xe9056,0xe91df,0xe92ac,
+        0xe92d0,0xe9918,0xe991d,0xe993b, 0xe9a01,0xe9a0b,0xe9a1a,0xe9a2a,
+        0xe9ddf,0xe9ed9,0xeadb3,0xeb20d, 0xeb5eb,0xebc1b,0xebc1c,0xebd37,
+        0xebfcf,0xec386,0xec39b,0xec39c, 0xecdeb,0xed41b,0xed537,0xed548,
+        0xed7cf,0xedd8d,0xee111,0xee1c2, 0xee1c4,0xee39b,0xeefab,0xeefca,
+        0xeefcf,0xef382,0xef56f,0xef58d, 0xeff53,0xf00a2,0xf00a6,0xf0306,
+        0xf0307,0xf030d,0xf031b,0xf031c, 0xf0e18,0xf1008,0xf1021,0xf1118,
+        0xf111d,0xf11bf,0xf175f,0xf182a, 0xf184e,0xf1850,0xf19d9,0xf1af6,
+        0xf1dbf,0xf26a9,0xf27b9,0xf302c, 0xf3050,0xf31d9,0xf32ae,0xf32d2,
+        0xf32f6,0xf34d9,0xf3a0f,0xf3a2e, 0xf3a34,0xf3c59,0xf3de7,0xf4739,
+        0xf49b2,0xf49b7,0xf5069,0xf5205, 0xf520a,0xf520f,0xf522e,0xf5234,
+        0xf5249,0xf52ec,0xf55e3,0xf5708, 0xf5a6c,0xf5c39,0xf6896,0xf6de3,
+        0xf6f08,0xf726c,0xf77b5,0xf77c7, 0xf78b6,0xf7d85,0xf7d8a,0xf8113,
+        0xf85b2,0xf8771,0xf894c,0xf8951, 0xf8956,0xf8c59,0xf90b2,0xf9567,
+        0xf9585,0xf98ee,0xf98f0,0xf9998, 0xf999d,0xfa128,0xfad73,0xfad91,
+        0xfb1bc,0xfb757,0xfb9ba,0xfb9de, 0xfc160,0xfc68d,0xfc6a3,0xfc6a4,
+        0xfcf57,0xfd1ba,0xfd1cb,0xfd1ea, 0xfd1ef,0xfd93a,0xfda11,0xfda16,
+        0xfddcb,0xfddea,0xfddef,0xff13c, 0xff5cb,0xff5ea,0xffc1c,0xfffaf,
+        0
+};
 
-        for (px = 0; px < ax; px++)
-        {
-            for (pz = 0; pz < az; pz++)
-            {
-                double ddx = px + dx;
-                double ddz = pz + dz;
-                cnt += (ddx*ddx + ddz*ddz <= rsq);
-            }
-        }
-    }
-    return cnt;
-}
+const uint64_t *const low20TriHutBarely[4] =
+{
+    low20TriHutNo00, low20TriHutNo10, low20TriHutNo01, low20TriHutNo11,
+};
 
 STRUCT(afk_meta_t)
 {
-    Pos *p;
+    const Pos *p;
     int n;
     int *buf;
+    size_t bufcap;
     int x0, z0, w, h, ax, az;
-    double rsq;
+    const int *chord;
     int best;
     int sumn;
     int64_t sumx, sumz;
 };
 
+enum { AFK_RADIUS = 128 };
+
+// Gets the half width of the horizontal cross-section of the sphere, that
+// still has the structure height in reach, at each z-offset from the center.
+static void getAfkChords(int chord[AFK_RADIUS+1], int ay)
+{
+    double rsq = AFK_RADIUS*AFK_RADIUS - ay*ay/4.0;
+    int i, k;
+
+    for (i = 0; i <= AFK_RADIUS; i++)
+    {
+        double rem = rsq - i*i;
+        k = -1;
+        if (rem >= 0)
+        {
+            k = (int) sqrt(rem);
+            while ((k+1) * (double)(k+1) <= rem)
+                k++;
+            while (k * (double)k > rem)
+                k--;
+        }
+        chord[i] = k;
+    }
+}
+
+// Counts the blocks of the structures that are within the sphere around
+// (x,z), as the overlap of each structure row with the chord of the sphere.
+static int blocksInRange(const afk_meta_t *d, int x, int z)
+{
+    int i, pz, cnt = 0;
+
+    for (i = 0; i < d->n; i++)
+    {
+        int dx = d->p[i].x - x;
+        int dz = d->p[i].z - z;
+
+        for (pz = 0; pz < d->az; pz++)
+        {
+            int ddz = abs(pz + dz);
+            if (ddz > AFK_RADIUS)
+                continue;
+            int k = d->chord[ddz];
+            int lo = -k - dx;
+            int hi = k - dx;
+            if (lo < 0)
+                lo = 0;
+            if (hi > d->ax - 1)
+                hi = d->ax - 1;
+            if (hi >= lo)
+                cnt += hi - lo + 1;
+        }
+    }
+    return cnt;
+}
+
 static void checkAfkDist(afk_meta_t *d, int x, int z)
 {
     if (x < 0 || z < 0 || x >= d->w || z >= d->h)
@@ -105,7 +1039,7 @@ static void checkAfkDist(afk_meta_t *d, int x, int z)
     if (d->buf[z*d->w+x])
         return;
 
-    int q = blocksInRange(d->p, d->n, x+d->x0, z+d->z0, d->ax, d->az, d->rsq);
+    int q = blocksInRange(d, x+d->x0, z+d->z0);
     d->buf[z*d->w+x] = q;
     if (q >= d->best)
     {
@@ -133,13 +1067,24 @@ static void checkAfkDist(afk_meta_t *d, int x, int z)
     }
 }
 
-
-Pos getOptimalAfk(Pos p[4], int ax, int ay, int az, int *spcnt)
+// Searches the AFK location for 'n' structures, using the chords, structure
+// size and (growable) buffer of the meta data.
+static int findOptimalAfk(afk_meta_t *d, const Pos *p, int n,
+        Pos *afk, int *spcnt)
 {
+    // the midpoints between the structures are the starting points
+    static const int quadPairs[6][2] = {
+        {0,2}, {1,3}, {0,1}, {2,3}, {0,3}, {1,2}
+    };
     int64_t minX = INT_MAX, minZ = INT_MAX, maxX = INT_MIN, maxZ = INT_MIN;
     int64_t w, h, i;
+    const int ax = d->ax, az = d->az;
 
-    for (i = 0; i < 4; i++)
+    afk->x = p[0].x + ax / 2;
+    afk->z = p[0].z + az / 2;
+    *spcnt = ax*az;
+
+    for (i = 0; i < n; i++)
     {
         if (p[i].x < minX) minX = p[i].x;
         if (p[i].z < minZ) minZ = p[i].z;
@@ -152,42 +1097,46 @@ Pos getOptimalAfk(Pos p[4], int ax, int ay, int az, int *spcnt)
     maxX += ax/2;
     maxZ += az/2;
 
-    double rsq = 128.0*128.0 - ay*ay/4.0;
-
     w = maxX - minX;
     h = maxZ - minZ;
-    Pos afk = {p[0].x + ax / 2, p[0].z + az / 2};
     int cnt = ax*az;
 
-    afk_meta_t d;
-    d.p = p;
-    d.n = 4;
-    d.buf = (int*) calloc(w*h, sizeof(int));
-    d.x0 = minX;
-    d.z0 = minZ;
-    d.w = w;
-    d.h = h;
-    d.ax = ax;
-    d.az = az;
-    d.rsq = rsq;
+    if ((size_t)(w*h) > d->bufcap)
+    {
+        free(d->buf);
+        d->buf = (int*) malloc(w*h * sizeof(int));
+        d->bufcap = d->buf ? w*h : 0;
+        if (!d->buf)
+            return -1;
+    }
+    if (w > 0 && h > 0)
+        memset(d->buf, 0, w*h * sizeof(int));
+    d->p = p;
+    d->n = n;
+    d->x0 = minX;
+    d->z0 = minZ;
+    d->w = w;
+    d->h = h;
 
     int v[6];
-    Pos dsp[6] = {
-        {(p[0].x + p[2].x) / 2, (p[0].z + p[2].z) / 2},
-        {(p[1].x + p[3].x) / 2, (p[1].z + p[3].z) / 2},
-        {(p[0].x + p[1].x) / 2, (p[0].z + p[1].z) / 2},
-        {(p[2].x + p[3].x) / 2, (p[2].z + p[3].z) / 2},
-        {(p[0].x + p[3].x) / 2, (p[0].z + p[3].z) / 2},
-        {(p[1].x + p[2].x) / 2, (p[1].z + p[2].z) / 2},
-    };
+    Pos dsp[6];
+    int npairs = 0;
     for (i = 0; i < 6; i++)
-        v[i] = blocksInRange(p, 4, dsp[i].x, dsp[i].z, ax, az, rsq);
+    {
+        int a = quadPairs[i][0], b = quadPairs[i][1];
+        if (b >= n)
+            continue;
+        dsp[npairs].x = (p[a].x + p[b].x) / 2;
+        dsp[npairs].z = (p[a].z + p[b].z) / 2;
+        v[npairs] = blocksInRange(d, dsp[npairs].x, dsp[npairs].z);
+        npairs++;
+    }
 
-    for (i = 0; i < 6; i++)
+    for (i = 0; i < npairs; i++)
     {
         // pick out the highest
         int j, jmax = 0, vmax = 0;
-        for (j = 0; j < 6; j++)
+        for (j = 0; j < npairs; j++)
         {
             if (v[j] > vmax)
             {
@@ -198,28 +1147,476 @@ Pos getOptimalAfk(Pos p[4], int ax, int ay, int az, int *spcnt)
         if (vmax <= ax*az)  // highest is less or equal to a single structure
             break;
 
-        d.best = vmax;
-        d.sumn = 0;
-        d.sumx = 0;
-        d.sumz = 0;
-        checkAfkDist(&d, dsp[jmax].x - d.x0, dsp[jmax].z - d.z0);
-        if (d.best > cnt)
+        d->best = vmax;
+        d->sumn = 0;
+        d->sumx = 0;
+        d->sumz = 0;
+        checkAfkDist(d, dsp[jmax].x - d->x0, dsp[jmax].z - d->z0);
+        if (d->best > cnt)
         {
-            cnt = d.best;
-            afk.x = (int) round(d.sumx / (double)d.sumn);
-            afk.z = (int) round(d.sumz / (double)d.sumn);
-            if (cnt >= 3*ax*az)
+            cnt = d->best;
+            afk->x = (int) round(d->sumx / (double)d->sumn);
+            afk->z = (int) round(d->sumz / (double)d->sumn);
+            if (cnt >= (n-1)*ax*az)
                 break;
         }
         v[jmax] = 0;
     }
 
+    *spcnt = cnt;
+    return 0;
+}
+
+
+Pos getOptimalAfk(Pos p[4], int ax, int ay, int az, int *spcnt)
+{
+    return getOptimalAfkMulti(p, 4, ax, ay, az, spcnt);
+}
+
+Pos getOptimalAfkMulti(const Pos *p, int n, int ax, int ay, int az, int *spcnt)
+{
+    int chord[AFK_RADIUS+1];
+    afk_meta_t d;
+    Pos afk;
+    int cnt;
+
+    memset(&d, 0, sizeof(d));
+    getAfkChords(chord, ay);
+    d.chord = chord;
+    d.ax = ax;
+    d.az = az;
+    findOptimalAfk(&d, p, n, &afk, &cnt);
+    free(d.buf);
+
     if (spcnt)
         *spcnt = cnt;
+    return afk;
+}
+
+STRUCT(afk_batch_t)
+{
+    const Pos *p;
+    int n, cnt, ax, az;
+    const int *chord;
+    Pos *afk;
+    int *spcnt;
+    volatile long next;
+    int err;
+};
 
+static void getOptimalAfkShare(void *data, int t)
+{
+    afk_batch_t *b = (afk_batch_t*) data;
+    afk_meta_t d;
+    long i;
+    int spcnt;
+    (void) t;
+
+    memset(&d, 0, sizeof(d));
+    d.chord = b->chord;
+    d.ax = b->ax;
+    d.az = b->az;
+    while ((i = ATOMIC_ADD(&b->next, 1)) < b->cnt)
+    {
+        if (findOptimalAfk(&d, b->p + i * b->n, b->n, &b->afk[i], &spcnt))
+            b->err = 1;
+        if (b->spcnt)
+            b->spcnt[i] = spcnt;
+    }
     free(d.buf);
+}
 
-    return afk;
+int getOptimalAfkBatch(const Pos *p, int n, int cnt, int ax, int ay, int az,
+        Pos *afk, int *spcnt, int threads)
+{
+    int chord[AFK_RADIUS+1];
+    afk_batch_t b;
+
+    getAfkChords(chord, ay);
+    memset(&b, 0, sizeof(b));
+    b.p = p;
+    b.n = n;
+    b.cnt = cnt;
+    b.ax = ax;
+    b.az = az;
+    b.chord = chord;
+    b.afk = afk;
+    b.spcnt = spcnt;
+    if (cnt > 0)
+        runThreads(threads < 1 ? 1 : threads, getOptimalAfkShare, &b);
+    return b.err ? -1 : 0;
+}
+
+
+int checkMultiBase(uint64_t s48, void *data)
+{
+    const MultiBaseCheck *c = (const MultiBaseCheck*) data;
+    int large = (c->sconf.structType == Monument);
+    float rad;
+
+    if (large)
+        rad = isMultiBaseLarge(c->sconf, s48, c->regs,
+            c->ax, c->ay, c->az, c->radius);
+    else
+        rad = isMultiBaseFeature(c->sconf, s48, c->regs,
+            c->ax, c->ay, c->az, c->radius);
+    if (rad == 0)
+        return 0;
+    if (c->minSpawn <= 0)
+        return 1;
+
+    Pos p[4];
+    int i, n = 0, spcnt;
+    for (i = 0; i < 4; i++)
+    {
+        if (!(c->regs & (1 << i)))
+            continue;
+        if (large)
+            p[n++] = getLargeStructurePos(c->sconf, s48, i & 1, i >> 1);
+        else
+            p[n++] = getFeaturePos(c->sconf, s48, i & 1, i >> 1);
+    }
+    getOptimalAfkMulti(p, n, c->ax, c->ay, c->az, &spcnt);
+    return spcnt >= c->minSpawn;
+}
+
+
+// the lower bits are tested in aligned blocks, so that each thread writes to
+// separate words of the bitset
+enum { LOW_BITS_BLOCK = 4096 };
+
+STRUCT(lowbit_gen_t)
+{
+    const MultiBaseCheck *chk;
+    int large, n;
+    int rx[4], rz[4];   // regions of the structures
+    int lox, hix, loz, hiz, spanx, spanz;
+    int lowBitN, mod;   // the positions are known modulo 'mod'
+    uint64_t *bits;
+    long nblocks;
+    volatile long next;
+};
+
+STRUCT(lowbit_cand_t)
+{
+    int nx[4], nz[4];
+    int8_t x[4][128], z[4][128];
+};
+
+// Gets the positions that are possible for the next coordinate, given the
+// lower bits of the PRNG state 's'.
+static int getLowBitPositions(const lowbit_gen_t *g, uint64_t *s,
+        int side, int span, int lo, int hi, int8_t *pos)
+{
+    const uint64_t M = (1ULL << g->lowBitN) - 1;
+    const uint64_t K = 0x5deece66dULL;
+    const int C = g->chk->sconf.chunkRange;
+    const int m = g->mod;
+    int a, b, v, w, n = 0;
+
+    *s = (*s * K + 0xb) & M;
+    a = (int)(*s >> 17) & (m-1);
+    if (!g->large)
+    {
+        for (v = a; v < C; v += m)
+            if (!span || (side ? v <= hi : v >= lo))
+                pos[n++] = v;
+        return n;
+    }
+
+    // pos = (p1+p2)>>1
+    char seen[128] = {0};
+    *s = (*s * K + 0xb) & M;
+    b = (int)(*s >> 17) & (m-1);
+    for (v = a; v < C; v += m)
+        for (w = b; w < C; w += m)
+            seen[(v + w) >> 1] = 1;
+    for (v = 0; v < C; v++)
+        if (seen[v] && (!span || (side ? v <= hi : v >= lo)))
+            pos[n++] = v;
+    return n;
+}
+
+static int testLowBitCands(const lowbit_gen_t *g, const lowbit_cand_t *c,
+        Pos *p, int k)
+{
+    const MultiBaseCheck *chk = g->chk;
+    const int R = chk->sconf.regionSize;
+    const int dsq = 4 * chk->radius * chk->radius;
+    int i, j, l;
+
+    if (k >= g->n || k >= 4)
+    {
+        float rad = getEnclosingRadiusMulti(p, g->n, chk->ax, chk->ay, chk->az,
+            chk->radius);
+        return rad < chk->radius;
+    }
+
+    for (i = 0; i < c->nx[k]; i++)
+    {
+        p[k].x = (g->rx[k] * R + c->x[k][i]) << 4;
+        for (j = 0; j < c->nz[k]; j++)
+        {
+            p[k].z = (g->rz[k] * R + c->z[k][j]) << 4;
+            for (l = 0; l < k; l++)
+            {
+                int dx = abs(p[k].x - p[l].x) + chk->ax;
+                int dz = abs(p[k].z - p[l].z) + chk->az;
+                if (dx*dx + dz*dz > dsq)
+                    break;
+            }
+            if (l == k && testLowBitCands(g, c, p, k+1))
+                return 1;
+        }
+    }
+    return 0;
+}
+
+static int testLowBits(const lowbit_gen_t *g, uint64_t low)
+{
+    const uint64_t M = (1ULL << g->lowBitN) - 1;
+    const uint64_t K = 0x5deece66dULL;
+    lowbit_cand_t c;
+    Pos p[4] = {{0,0},{0,0},{0,0},{0,0}};
+    int k;
+
+    low += (uint64_t) g->chk->sconf.salt;
+    for (k = 0; k < g->n; k++)
+    {
+        uint64_t s = low + g->rx[k] * 341873128712ULL + g->rz[k] * 132897987541ULL;
+        s = (s ^ K) & M;
+        c.nx[k] = getLowBitPositions(g, &s, g->rx[k], g->spanx, g->lox, g->hix, c.x[k]);
+        c.nz[k] = getLowBitPositions(g, &s, g->rz[k], g->spanz, g->loz, g->hiz, c.z[k]);
+        if (!c.nx[k] || !c.nz[k])
+            return 0;
+    }
+    return testLowBitCands(g, &c, p, 0);
+}
+
+static void genLowBitsShare(void *data, int t)
+{
+    lowbit_gen_t *g = (lowbit_gen_t*) data;
+    const uint64_t end = 1ULL << g->lowBitN;
+    long blk;
+    (void) t;
+
+    while ((blk = ATOMIC_ADD(&g->next, 1)) < g->nblocks)
+    {
+        uint64_t v = (uint64_t) blk * LOW_BITS_BLOCK;
+        uint64_t v1 = v + LOW_BITS_BLOCK < end ? v + LOW_BITS_BLOCK : end;
+        for (; v < v1; v++)
+        {
+            if (testLowBits(g, v))
+                g->bits[v >> 6] |= 1ULL << (v & 63);
+        }
+    }
+}
+
+static size_t getLowBitsWords(int lowBitN)
+{
+    return lowBitN >= 6 ? (size_t)1 << (lowBitN - 6) : 1;
+}
+
+// builds the candidate list from the bitset
+static int setLowBitsList(LowBits *lb)
+{
+    uint64_t v, n = 1ULL << lb->lowBitN;
+    uint64_t cnt = 0, i = 0;
+
+    for (v = 0; v < n; v++)
+        cnt += (lb->bits[v >> 6] >> (v & 63)) & 1;
+    lb->cnt = cnt;
+    lb->list = (uint64_t*) malloc((cnt + 1) * sizeof(uint64_t));
+    if (!lb->list)
+        return -1;
+    for (v = 1; v < n; v++)
+    {
+        if ((lb->bits[v >> 6] >> (v & 63)) & 1)
+            lb->list[i++] = v;
+    }
+    lb->list[i] = 0;
+    lb->nlist = i;
+    return 0;
+}
+
+int genLowBits(LowBits *lb, const MultiBaseCheck *chk, int lowBitN,
+        int threads)
+{
+    const int R = chk->sconf.regionSize;
+    const int C = chk->sconf.chunkRange;
+    lowbit_gen_t g;
+    int i, mod;
+
+    memset(lb, 0, sizeof(*lb));
+    lb->chk = *chk;
+
+    // largest power of two that divides the range (but nextInt() takes the
+    // upper bits for powers of two)
+    mod = (C & (C-1)) ? (C & -C) : 1;
+    if (lowBitN > 32)
+        lowBitN = 32;
+    if (lowBitN < 1)
+        lowBitN = 1;
+    while (mod > 1 && (1 << (lowBitN - 17 > 0 ? lowBitN - 17 : 0)) < mod)
+        mod >>= 1;
+    for (i = 0; (1 << i) < mod; i++);
+    if (lowBitN > 17 + i)
+        lowBitN = 17 + i;
+
+    memset(&g, 0, sizeof(g));
+    g.chk = &lb->chk;
+    g.large = (chk->sconf.structType == Monument);
+    for (i = 0; i < 4; i++)
+    {
+        if (chk->regs & (1 << i))
+        {
+            g.rx[g.n] = i & 1;
+            g.rz[g.n] = i >> 1;
+            g.n++;
+        }
+    }
+    g.lox = R - (2*chk->radius - chk->ax) / 16;
+    g.loz = R - (2*chk->radius - chk->az) / 16;
+    g.hix = C-1 - g.lox;
+    g.hiz = C-1 - g.loz;
+    g.spanx = (chk->regs & (MB_00|MB_01)) && (chk->regs & (MB_10|MB_11));
+    g.spanz = (chk->regs & (MB_00|MB_10)) && (chk->regs & (MB_01|MB_11));
+    g.lowBitN = lowBitN;
+    g.mod = mod;
+
+    lb->lowBitN = lowBitN;
+    lb->bits = (uint64_t*) calloc(getLowBitsWords(lowBitN), sizeof(uint64_t));
+    if (!lb->bits)
+        return -1;
+    g.bits = lb->bits;
+
+    if (g.n == 0)
+    {
+        // nothing to constrain
+        memset(lb->bits, 0xff, getLowBitsWords(lowBitN) * sizeof(uint64_t));
+    }
+    else if (mod == 1)
+    {
+        // the lower bits do not matter: test once and fill
+        if (testLowBits(&g, 0))
+            memset(lb->bits, 0xff, getLowBitsWords(lowBitN) * sizeof(uint64_t));
+    }
+    else
+    {
+        g.nblocks = (long)(((1ULL << lowBitN) + LOW_BITS_BLOCK-1) / LOW_BITS_BLOCK);
+        runThreads(threads < 1 ? 1 : threads, genLowBitsShare, &g);
+    }
+    if (lowBitN < 6)
+        lb->bits[0] &= (1ULL << (1 << lowBitN)) - 1;
+
+    if (setLowBitsList(lb))
+    {
+        freeLowBits(lb);
+        return -1;
+    }
+    return 0;
+}
+
+int saveLowBits(const LowBits *lb, const char *path)
+{
+    LowBitsHeader h;
+    uint64_t i;
+    FILE *fp;
+    int err = 0;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "CUBILOWB", 8);
+    h.version = LOW_BITS_VERSION;
+    h.lowBitN = lb->lowBitN;
+    h.cnt = lb->cnt;
+    h.salt = lb->chk.sconf.salt;
+    h.regionSize = lb->chk.sconf.regionSize;
+    h.chunkRange = lb->chk.sconf.chunkRange;
+    h.structType = lb->chk.sconf.structType;
+    h.regs = lb->chk.regs;
+    h.radius = lb->chk.radius;
+    h.ax = lb->chk.ax;
+    h.ay = lb->chk.ay;
+    h.az = lb->chk.az;
+
+    if (!(fp = fopen(path, "wb")))
+        return -1;
+    if (fwrite(&h, sizeof(h), 1, fp) != 1)
+        err = -1;
+    if (!err && hasLowBits(lb, 0))
+    {
+        uint32_t v = 0;
+        if (fwrite(&v, sizeof(v), 1, fp) != 1)
+            err = -1;
+    }
+    for (i = 0; !err && i < lb->nlist; i++)
+    {
+        uint32_t v = (uint32_t) lb->list[i];
+        if (fwrite(&v, sizeof(v), 1, fp) != 1)
+            err = -1;
+    }
+    if (fclose(fp))
+        err = -1;
+    return err;
+}
+
+int loadLowBits(LowBits *lb, const char *path)
+{
+    LowBitsHeader h;
+    uint64_t i;
+    FILE *fp;
+    int err = 0;
+
+    memset(lb, 0, sizeof(*lb));
+    if (!(fp = fopen(path, "rb")))
+        return -1;
+    if (fread(&h, sizeof(h), 1, fp) != 1)
+        err = -2;
+    else if (memcmp(h.magic, "CUBILOWB", 8) != 0 ||
+        h.version != LOW_BITS_VERSION || h.lowBitN < 1 || h.lowBitN > 32 ||
+        h.cnt > (1ULL << h.lowBitN))
+        err = -2;
+
+    if (!err)
+    {
+        lb->chk.sconf.salt = h.salt;
+        lb->chk.sconf.regionSize = h.regionSize;
+        lb->chk.sconf.chunkRange = h.chunkRange;
+        lb->chk.sconf.structType = h.structType;
+        lb->chk.regs = h.regs;
+        lb->chk.radius = h.radius;
+        lb->chk.ax = h.ax;
+        lb->chk.ay = h.ay;
+        lb->chk.az = h.az;
+        lb->lowBitN = h.lowBitN;
+        lb->bits = (uint64_t*) calloc(getLowBitsWords(h.lowBitN), sizeof(uint64_t));
+        if (!lb->bits)
+            err = -1;
+    }
+    for (i = 0; !err && i < h.cnt; i++)
+    {
+        uint32_t v;
+        if (fread(&v, sizeof(v), 1, fp) != 1 || (v >> 1) >> (h.lowBitN - 1))
+            err = -2;
+        else
+            lb->bits[v >> 6] |= 1ULL << (v & 63);
+    }
+    fclose(fp);
+
+    if (!err && setLowBitsList(lb))
+        err = -1;
+    if (err)
+        freeLowBits(lb);
+    return err;
+}
+
+void freeLowBits(LowBits *lb)
+{
+    free(lb->list);
+    free(lb->bits);
+    lb->list = NULL;
+    lb->bits = NULL;
+    lb->cnt = lb->nlist = 0;
 }
 
 
@@ -286,16 +1683,12 @@ static int mkdirp(char *path)
 }
 
 
-#ifdef USE_PTHREAD
-static void *searchAll48Thread(void *data)
-#else
-static DWORD WINAPI searchAll48Thread(LPVOID data)
-#endif
+static void searchAll48Share(void *data, int t)
 {
 // TODO TEST:
 // lower bits with various ranges
 
-    threadinfo_t *info = (threadinfo_t*)data;
+    threadinfo_t *info = (threadinfo_t*)data + t;
 
     uint64_t seed = info->start;
     uint64_t end = info->end;
@@ -389,11 +1782,6 @@ static DWORD WINAPI searchAll48Thread(LPVOID data)
                 break;
         }
     }
-
-#ifdef USE_PTHREAD
-    pthread_exit(NULL);
-#endif
-    return 0;
 }
 
 
@@ -410,10 +1798,12 @@ int searchAll48(
         )
 {
     threadinfo_t *info = (threadinfo_t*) malloc(threads* sizeof(*info));
-    thread_id_t *tids = (thread_id_t*) malloc(threads* sizeof(*tids));
     int i, t;
     int err = 0;
 
+    if (info == NULL)
+        return 1;
+
     if (path)
     {
         size_t pathlen = strlen(path);
@@ -498,29 +1888,7 @@ int searchAll48(
 
 
     // run the threads
-#ifdef USE_PTHREAD
-
-    for (t = 0; t < threads; t++)
-    {
-        pthread_create(&tids[t], NULL, searchAll48Thread, (void*)&info[t]);
-    }
-
-    for (t = 0; t < threads; t++)
-    {
-        pthread_join(tids[t], NULL);
-    }
-
-#else
-
-    for (t = 0; t < threads; t++)
-    {
-        tids[t] = CreateThread(NULL, 0, searchAll48Thread,
-            (LPVOID)&info[t], 0, NULL);
-    }
-
-    WaitForMultipleObjects(threads, tids, TRUE, INFINITE);
-
-#endif
+    runThreads(threads, searchAll48Share, info);
 
     if (stop && *stop)
         goto L_err;
@@ -599,7 +1967,6 @@ int searchAll48(
 L_err:
         err = 1;
 
-    free(tids);
     free(info);
 
     return err;
@@ -672,3 +2039,342 @@ int scanForQuads(
 }
 
 
+// candidates are prefiltered in groups of lanes, and a job is a strip of
+// regions along x for one seed
+enum { QUAD_LANES = 16, QUAD_STRIP = 1024, QUAD_BITS = 32 };
+
+STRUCT(quad_hit_t)
+{
+    int sidx;
+    QuadHit hit;
+};
+
+STRUCT(quad_lanes_t)
+{
+    uint64_t sp[QUAD_LANES];
+    int64_t ci[QUAD_LANES], cj[QUAD_LANES];
+    int n;
+};
+
+STRUCT(quad_batch_t)
+{
+    StructureConfig sconf;
+    int radius;
+    const uint64_t *seeds;
+    const uint64_t *lowBits;
+    int nbits, lowBitN;
+    uint64_t salt, invB;
+    int64_t x, z, w, h;
+    int steps, lo;
+    uint64_t cinv;  // reciprocal of the chunk range
+    int csh;
+    int nstrips, njobs;
+    volatile long next;
+    quad_hit_t **hits;
+    int *nhits, *caps;
+    int err;
+};
+
+/* The first position draws of the structure in region (0,0) have to be near
+ * the upper end of the range for any of the quad-base checks to succeed. This
+ * gives the number of nextInt() calls per coordinate and the (inclusive) bound
+ * that isQuadBase() rejects the coordinates at.
+ */
+static int getQuadPrefilter(const StructureConfig sconf, int radius, int *lo)
+{
+    const int R = sconf.regionSize;
+    const int C = sconf.chunkRange;
+    switch (sconf.structType)
+    {
+    case Swamp_Hut:
+    case Desert_Pyramid:
+    case Jungle_Pyramid:
+    case Igloo:
+    case Village:
+        if (radius == 128)
+        {
+            *lo = 19;
+            return 1;
+        }
+        // fallthrough
+    case Outpost:
+    case Ocean_Ruin:
+    case Shipwreck:
+    case Ruined_Portal:
+    {
+        int cd = radius/8;
+        if (cd < R-C+1)
+            *lo = C; // no base can be in reach
+        else
+            *lo = R - (int)sqrtf(cd*cd - (R-C+1)*(R-C+1));
+        return 1;
+    }
+    case Monument:
+        *lo = (int)(2 * R + (58 - 2*radius + 7) / 8);
+        return 2;
+    default:
+        *lo = -1; // no prefilter
+        return 1;
+    }
+}
+
+static void addQuadHit(quad_batch_t *b, int t, int sidx, uint64_t s48,
+        int64_t i, int64_t j)
+{
+    if (b->nhits[t] >= b->caps[t])
+    {
+        int cap = b->caps[t] ? 2 * b->caps[t] : 64;
+        quad_hit_t *hits = (quad_hit_t*)
+            realloc(b->hits[t], cap * sizeof(quad_hit_t));
+        if (!hits)
+        {
+            b->err = 1;
+            return;
+        }
+        b->hits[t] = hits;
+        b->caps[t] = cap;
+    }
+    quad_hit_t *q = &b->hits[t][b->nhits[t]++];
+    q->sidx = sidx;
+    q->hit.s48 = s48;
+    q->hit.x = (int) i;
+    q->hit.z = (int) j;
+}
+
+static void testQuadLanes(quad_batch_t *b, int t, int sidx, uint64_t s48,
+        quad_lanes_t *ql)
+{
+    const uint64_t M = (1ULL << 48) - 1;
+    const uint64_t K = 0x5deece66dULL;
+    const uint64_t C = b->sconf.chunkRange;
+    const uint64_t inv = b->cinv;
+    const int sh = b->csh;
+    const int lo = b->lo;
+    int pass[QUAD_LANES];
+    int k;
+
+    for (k = ql->n; k < QUAD_LANES; k++)
+        ql->sp[k] = ql->sp[0]; // pad the remaining lanes
+
+    if (b->steps == 1)
+    {
+        for (k = 0; k < QUAD_LANES; k++)
+        {
+            uint64_t s = (ql->sp[k] + b->sconf.salt) ^ K, v;
+            s = (s * K + 0xb) & M; v = s >> 17; int px = (int)(v - (v * inv >> sh) * C);
+            s = (s * K + 0xb) & M; v = s >> 17; int pz = (int)(v - (v * inv >> sh) * C);
+            pass[k] = (px > lo) & (pz > lo);
+        }
+    }
+    else
+    {
+        for (k = 0; k < QUAD_LANES; k++)
+        {
+            uint64_t s = (ql->sp[k] + b->sconf.salt) ^ K, v;
+            s = (s * K + 0xb) & M; v = s >> 17; int px = (int)(v - (v * inv >> sh) * C);
+            s = (s * K + 0xb) & M; v = s >> 17; px += (int)(v - (v * inv >> sh) * C);
+            s = (s * K + 0xb) & M; v = s >> 17; int pz = (int)(v - (v * inv >> sh) * C);
+            s = (s * K + 0xb) & M; v = s >> 17; pz += (int)(v - (v * inv >> sh) * C);
+            pass[k] = (px > lo) & (pz > lo);
+        }
+    }
+
+    for (k = 0; k < ql->n; k++)
+    {
+        if likely(!pass[k])
+            continue;
+        if (isQuadBase(b->sconf, ql->sp[k], b->radius))
+            addQuadHit(b, t, sidx, s48, ql->ci[k], ql->cj[k]);
+    }
+    ql->n = 0;
+}
+
+static inline void addQuadCand(quad_batch_t *b, int t, int sidx, uint64_t s48,
+        quad_lanes_t *ql, int64_t i, int64_t j)
+{
+    if (b->lo < 0)
+    {   // without a prefilter the lanes only add overhead
+        if (isQuadBase(b->sconf, moveStructure(s48, -i, -j), b->radius))
+            addQuadHit(b, t, sidx, s48, i, j);
+        return;
+    }
+    ql->sp[ql->n] = moveStructure(s48, -i, -j);
+    ql->ci[ql->n] = i;
+    ql->cj[ql->n] = j;
+    if (++ql->n == QUAD_LANES)
+        testQuadLanes(b, t, sidx, s48, ql);
+}
+
+static void scanQuadShare(void *data, int t)
+{
+    quad_batch_t *b = (quad_batch_t*) data;
+    const uint64_t m = (1ULL << b->lowBitN);
+    const uint64_t A = 341873128712ULL;
+    const int64_t z0 = b->z, z1 = b->z + b->h;
+    quad_lanes_t ql;
+    int job, k, k0;
+
+    ql.n = 0;
+    while ((job = (int) ATOMIC_ADD(&b->next, 1)) < b->njobs)
+    {
+        int sidx = job / b->nstrips;
+        uint64_t s48 = b->seeds[sidx];
+        int64_t i0 = b->x + (int64_t)(job % b->nstrips) * QUAD_STRIP;
+        int64_t i1 = i0 + QUAD_STRIP - 1;
+        int64_t i, j;
+        if (i1 > b->x + b->w)
+            i1 = b->x + b->w;
+
+        if (b->lowBitN > QUAD_BITS)
+        {   // one constellation at a time, as in scanForQuadBits()
+            for (k = 0; k < b->nbits; k++)
+            {
+                uint64_t lbit = (b->lowBits[k] - b->salt) & (m-1);
+                for (i = i0; i <= i1; i++)
+                {
+                    uint64_t sx = s48 + A * i;
+                    j = (z0 & ~(m-1)) | ((lbit - sx) * b->invB & (m-1));
+                    if (j < z0)
+                        j += m;
+                    for (; j <= z1; j += m)
+                        addQuadCand(b, t, sidx, s48, &ql, i, j);
+                }
+            }
+        }
+        else
+        {   // For each region column, the matching z of every constellation
+            // is (lz[k] - c) mod m above the area, where only c depends on x
+            const uint32_t mm = (uint32_t)(m-1);
+            const uint32_t h = b->h > mm ? mm : (uint32_t) b->h;
+            const uint32_t D = (uint32_t)((A * b->invB) & (m-1));
+            uint32_t lz[QUAD_BITS], r[QUAD_BITS], f[QUAD_BITS];
+
+            for (k0 = 0; k0 < b->nbits; k0 += QUAD_BITS)
+            {
+                int nk = b->nbits - k0 < QUAD_BITS ? b->nbits - k0 : QUAD_BITS;
+                for (k = 0; k < QUAD_BITS; k++)
+                {
+                    uint64_t lbit = b->lowBits[k0 + (k < nk ? k : 0)] - b->salt;
+                    lz[k] = (uint32_t)((lbit * b->invB - z0) & (m-1));
+                }
+                uint32_t c = (uint32_t)(((s48 + A * i0) * b->invB) & (m-1));
+                for (i = i0; i <= i1; i++, c = (c + D) & mm)
+                {
+                    uint32_t any = 0;
+                    for (k = 0; k < QUAD_BITS; k++)
+                    {
+                        r[k] = (lz[k] - c) & mm;
+                        f[k] = r[k] <= h;
+                        any |= f[k];
+                    }
+                    if (!any)
+                        continue;
+                    for (k = 0; k < nk; k++)
+                    {
+                        if (!f[k])
+                            continue;
+                        for (j = z0 + r[k]; j <= z1; j += m)
+                            addQuadCand(b, t, sidx, s48, &ql, i, j);
+                    }
+                }
+            }
+        }
+        if (ql.n)
+            testQuadLanes(b, t, sidx, s48, &ql);
+    }
+}
+
+static int cmpQuadHit(const void *a, const void *b)
+{
+    const quad_hit_t *qa = (const quad_hit_t*) a;
+    const quad_hit_t *qb = (const quad_hit_t*) b;
+    if (qa->sidx != qb->sidx) return qa->sidx < qb->sidx ? -1 : 1;
+    if (qa->hit.x != qb->hit.x) return qa->hit.x < qb->hit.x ? -1 : 1;
+    return qa->hit.z < qb->hit.z ? -1 : qa->hit.z > qb->hit.z;
+}
+
+int scanSeedsForQuads(
+        const StructureConfig sconf, int radius,
+        const uint64_t *seeds, int nseeds,
+        const uint64_t *lowBits, int lowBitN, uint64_t salt,
+        int x, int z, int w, int h,
+        QuadHit *out, int n, int threads)
+{
+    quad_batch_t b;
+    int t, i, cnt = 0;
+
+    if (threads < 1)
+        threads = 1;
+    memset(&b, 0, sizeof(b));
+    b.sconf = sconf;
+    b.radius = radius;
+    b.seeds = seeds;
+    b.lowBits = lowBits;
+    b.lowBitN = lowBitN;
+    b.salt = salt;
+    b.x = x; b.z = z; b.w = w; b.h = h;
+    if (lowBitN == 20)
+        b.invB = 132477ULL;
+    else if (lowBitN == 48)
+        b.invB = 211541297333629ULL;
+    else
+        b.invB = mulInv(132897987541ULL, (1ULL << lowBitN));
+    for (b.nbits = 0; lowBits[b.nbits]; b.nbits++);
+    b.steps = getQuadPrefilter(sconf, radius, &b.lo);
+    // x % C as x - (x * cinv >> csh) * C, exact for 31-bit x
+    for (b.csh = 32; (1 << (b.csh - 32)) < sconf.chunkRange; b.csh++);
+    b.cinv = (1ULL << b.csh) / sconf.chunkRange + 1;
+    b.nstrips = (int)((b.w + QUAD_STRIP) / QUAD_STRIP);
+    b.njobs = nseeds * b.nstrips;
+    b.next = 0;
+
+    b.hits = (quad_hit_t**) calloc(threads, sizeof(*b.hits));
+    b.nhits = (int*) calloc(threads, sizeof(int));
+    b.caps = (int*) calloc(threads, sizeof(int));
+    if (!b.hits || !b.nhits || !b.caps)
+    {
+        b.err = 1;
+        goto L_end;
+    }
+    // the prefilter can reject every base, when the first position draws
+    // cannot exceed the bound, in which case there is nothing to scan
+    if (b.lo >= b.steps * (sconf.chunkRange - 1))
+        nseeds = 0;
+    if (nseeds > 0 && w >= 0 && h >= 0)
+        runThreads(threads, scanQuadShare, &b);
+    if (b.err)
+        goto L_end;
+
+    for (t = 0; t < threads; t++)
+        cnt += b.nhits[t];
+    quad_hit_t *all = (quad_hit_t*) malloc((cnt ? cnt : 1) * sizeof(*all));
+    if (!all)
+    {
+        b.err = 1;
+        goto L_end;
+    }
+    for (cnt = 0, t = 0; t < threads; t++)
+    {
+        if (b.nhits[t] == 0)
+            continue; // the hit list may not be allocated
+        memcpy(all + cnt, b.hits[t], b.nhits[t] * sizeof(*all));
+        cnt += b.nhits[t];
+    }
+    qsort(all, cnt, sizeof(*all), cmpQuadHit);
+    for (i = 0; i < cnt && i < n; i++)
+        out[i] = all[i].hit;
+    free(all);
+
+L_end:
+    if (b.hits)
+    {
+        for (t = 0; t < threads; t++)
+            free(b.hits[t]);
+    }
+    free(b.hits);
+    free(b.nhits);
+    free(b.caps);
+    return b.err ? -1 : cnt;
+}
+
+
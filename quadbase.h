@@ -8,6 +8,12 @@
 #include <math.h>
 
 
+STRUCT(QuadHit)
+{
+    uint64_t s48;   // 48-bit seed
+    int x, z;       // region coordinates of the quad-structure
+};
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -62,11 +68,68 @@ static const uint64_t low20QuadHutBarely[] =
         0xe2739,0xe9918,0xee1c4,0xf520a, 0
 };
 
+// lower 20 bits for tri-structure constellations with the structure size of
+// low20QuadHutBarely, for each missing region in the order of the MB_* bits,
+// e.g. low20TriHutBarely[3] for the regions (MB_00 | MB_10 | MB_01)
+// Like the quad tables, these are bits of the salted seed (s48 + salt), while
+// checkMultiBase() and searchAll48() take the seed itself, so the salt has to
+// be subtracted from them first (or use genLowBits() for the seed bits).
+extern const uint64_t *const low20TriHutBarely[4];
+
 
 // categorize a constellation
 enum { CST_NONE, CST_IDEAL, CST_CLASSIC, CST_NORMAL, CST_BARELY };
 int getQuadHutCst(uint64_t low20);
 
+// regions (x,z) of a multi-structure base, as a bit set for isMultiBase()
+enum
+{
+    MB_00 = 1, MB_10 = 2, MB_01 = 4, MB_11 = 8,
+    MB_QUAD = MB_00 | MB_10 | MB_01 | MB_11,
+};
+
+STRUCT(MultiBaseCheck)
+{
+    StructureConfig sconf;
+    int regs;       // regions of the structures (MB_* bits)
+    int radius;     // maximum enclosing radius
+    int ax, ay, az; // structure size
+    int minSpawn;   // minimum planar spawning spaces at the AFK spot (or zero)
+};
+
+/* A set of lower seed bits for which a constellation can occur, as made by
+ * genLowBits(). Unlike the low20* tables above, the values are lower bits of
+ * the seed itself (the salt is already accounted for), so 'list' can be passed
+ * straight to searchAll48(). The list is terminated by zero, so the candidate
+ * zero is never in it, while it is included in 'cnt' and 'bits' (see
+ * hasLowBits()) and would have to be searched separately.
+ */
+STRUCT(LowBits)
+{
+    MultiBaseCheck chk; // the constellation (minSpawn is not used)
+    int lowBitN;        // number of significant lower bits
+    uint64_t cnt;       // number of candidates
+    uint64_t nlist;     // number of entries in 'list' (cnt without zero)
+    uint64_t *list;     // sorted candidates, zero-terminated (excludes zero)
+    uint64_t *bits;     // membership bit for each of the 2^lowBitN values
+};
+
+enum { LOW_BITS_VERSION = 1 };
+
+/* Header of a low-bit candidate file, which is followed by the 'cnt' sorted
+ * candidates as uint32_t. The fields are in native byte order.
+ */
+STRUCT(LowBitsHeader)
+{
+    char        magic[8];   // "CUBILOWB"
+    uint32_t    version;    // LOW_BITS_VERSION
+    uint32_t    lowBitN;
+    uint64_t    cnt;
+    int32_t     salt, regionSize, chunkRange, structType;
+    int32_t     regs, radius, ax, ay, az;
+    int32_t     reserved;
+};
+
 
 //==============================================================================
 // Multi-Structure-Base Checks
@@ -135,6 +198,42 @@ static inline ATTR(always_inline, const)
 float isQuadBaseLarge (const StructureConfig sconf, uint64_t seed,
         int ax, int ay, int az, int radius);
 
+/* Tests a base for two or three structures (or four, but isQuadBase() will be
+ * faster in that case) in the regions given by the bit set 'regs' of MB_*
+ * flags, e.g. (MB_00 | MB_10 | MB_01) for a tri-structure base without the
+ * region (1,1). The structure sizes are the same as for isQuadBase().
+ *
+ * In contrast to the quad-base checks, the enclosing radius is determined for
+ * the furthest corner of each structure as seen from the center, which works
+ * for any arrangement of the regions. Chunk ranges that are powers of two are
+ * drawn as in getFeatureChunkInRegion().
+ *
+ * The function variants are:
+ *  isMultiBaseFeature() - for features that use a single position draw
+ *  isMultiBaseLarge() - for large structures that average two draws
+ *
+ * Returns the enclosing radius or zero if the seed is not a base for the
+ * specified regions.
+ */
+static inline float isMultiBase(const StructureConfig sconf, uint64_t seed,
+        int regs, int radius);
+
+static inline ATTR(always_inline, const)
+float isMultiBaseFeature (const StructureConfig sconf, uint64_t seed, int regs,
+        int ax, int ay, int az, int radius);
+
+static inline ATTR(always_inline, const)
+float isMultiBaseLarge (const StructureConfig sconf, uint64_t seed, int regs,
+        int ax, int ay, int az, int radius);
+
+/* A check function for searchAll48() that takes a MultiBaseCheck as 'data'.
+ * The seed 's48' is the seed itself, not salted by the structure config.
+ * The base has to be within the enclosing radius and, if 'minSpawn' is
+ * positive, the optimal AFK location has to offer at least that many planar
+ * spawning spaces (see getOptimalAfkMulti()).
+ */
+int checkMultiBase(uint64_t s48, void *data);
+
 
 /* Starts a multi-threaded search through all 48-bit seeds. Since this can
  * potentially be a lengthy calculation, results can be written to temporary
@@ -168,6 +267,40 @@ int searchAll48(
         volatile char *     stop // should be atomic, but is fine as stop flag
         );
 
+/* Generates the set of lower seed bits for which the constellation 'chk' is
+ * possible (ignoring minSpawn), in the manner of the low20Quad* tables. Only
+ * the positions modulo the largest power of two that divides the chunk range
+ * depend on the lower bits: at 'lowBitN' bits this is up to 2^(lowBitN-17).
+ * The width is therefore reduced to where it stops adding information, e.g. to
+ * 20 bits for a chunk range of 24, and for ranges that are odd or powers of two
+ * (which use the upper bits) the set is either complete or empty.
+ *
+ * @lb          : output set, to be released with freeLowBits()
+ * @chk         : constellation and structure size
+ * @lowBitN     : number of lower bits (up to 32)
+ * @threads     : number of threads to use
+ *
+ * Returns zero on success, or -1 if allocation failed.
+ */
+int genLowBits(LowBits *lb, const MultiBaseCheck *chk, int lowBitN,
+        int threads);
+
+/* Saves a low-bit set to a file, or loads one, which has to be released with
+ * freeLowBits(). Returns zero on success, -1 if the file could not be opened,
+ * written or read (or allocation failed), or -2 if the file is not a low-bit
+ * set of a supported version.
+ */
+int saveLowBits(const LowBits *lb, const char *path);
+int loadLowBits(LowBits *lb, const char *path);
+void freeLowBits(LowBits *lb);
+
+/* Checks whether the lower bits of a seed are in a low-bit set. */
+static inline int hasLowBits(const LowBits *lb, uint64_t seed)
+{
+    uint64_t v = seed & ((1ULL << lb->lowBitN) - 1);
+    return (int) (lb->bits[v >> 6] >> (v & 63)) & 1;
+}
+
 /* Finds the optimal AFK location for four structures of size (ax,ay,az),
  * located at the positions of 'p'. The AFK position is determined by looking
  * for whole block coordinates which offer the maximum number of spawning
@@ -185,6 +318,20 @@ int searchAll48(
  */
 Pos getOptimalAfk(Pos p[4], int ax, int ay, int az, int *spcnt);
 
+/* Variant of getOptimalAfk() for any number of structures, 'n', up to four.
+ */
+Pos getOptimalAfkMulti(const Pos *p, int n, int ax, int ay, int az, int *spcnt);
+
+/* Finds the optimal AFK locations for a batch of 'cnt' constellations of 'n'
+ * structures each, which are stored consecutively in 'p', using 'threads'
+ * threads. The results are the same as for getOptimalAfkMulti(), with the
+ * spawning space counts going to 'spcnt' (nullable).
+ *
+ * Returns zero on success, or -1 if allocation failed.
+ */
+int getOptimalAfkBatch(const Pos *p, int n, int cnt, int ax, int ay, int az,
+        Pos *afk, int *spcnt, int threads);
+
 /* Scans the seed 's48' for quad-structures in the given area of region
  * coordiantes. The search is performed for only a specific set of lower bits
  * of the transformed bases (each constellation of quad-structures is
@@ -207,6 +354,25 @@ int scanForQuads(
         const uint64_t *lowBits, int lowBitN, uint64_t salt,
         int x, int z, int w, int h, Pos *qplist, int n);
 
+/* Scans a batch of 48-bit seeds for quad-structures, with the same arguments
+ * and area as scanForQuads(). The candidate bases are collected in groups and
+ * a cheap check of the first structure position is applied to all of them at
+ * once, before the few remaining ones are tested with isQuadBase(). When that
+ * check cannot pass for the given radius, nothing is scanned, and when there
+ * is no such check, the candidates are tested directly. The work is split
+ * into strips of regions for each seed, which 'threads' threads take in turn.
+ *
+ * Up to 'n' results are written to 'out', ordered by the seed index followed
+ * by the region coordinates. Returns the total number of quad-structures
+ * found, or -1 if allocation failed.
+ */
+int scanSeedsForQuads(
+        const StructureConfig sconf, int radius,
+        const uint64_t *seeds, int nseeds,
+        const uint64_t *lowBits, int lowBitN, uint64_t salt,
+        int x, int z, int w, int h,
+        QuadHit *out, int n, int threads);
+
 
 //==============================================================================
 // Implementaions for Functions that Ideally Should be Inlined
@@ -255,6 +421,70 @@ float getEnclosingRadius(
     return sqrad < 0x7fffffff ? sqrtf(sqrad + ay*ay/4.0f) : 0xffff;
 }
 
+/* Determines the radius of the smallest sphere, centered on a block, that
+ * encloses 'n' structures of size (ax,ay,az) at the block positions 'p'. The
+ * center is only considered within 'gap' blocks of every structure.
+ */
+static ATTR(pure)
+float getEnclosingRadiusMulti(const Pos *p, int n, int ax, int ay, int az,
+    int gap)
+{
+    int cbx0 = p[0].x + ax, cbx1 = p[0].x;
+    int cbz0 = p[0].z + az, cbz1 = p[0].z;
+    int dz2[4];
+    int i, x, z, x0, x1, s;
+
+    for (i = 1; i < n; i++)
+    {
+        if (p[i].x + ax > cbx0) cbx0 = p[i].x + ax;
+        if (p[i].x      < cbx1) cbx1 = p[i].x;
+        if (p[i].z + az > cbz0) cbz0 = p[i].z + az;
+        if (p[i].z      < cbz1) cbz1 = p[i].z;
+    }
+    cbx0 -= gap; cbx1 += gap;
+    cbz0 -= gap; cbz1 += gap;
+
+    int sqrad = 0x7fffffff;
+
+#define MULTI_SQ(X, SQ) \
+    for ((SQ) = 0, i = 0; i < n; i++) { \
+        int dx = (X) - p[i].x; \
+        if (p[i].x + ax - (X) > dx) dx = p[i].x + ax - (X); \
+        if ((s = dx*dx + dz2[i]) > (SQ)) (SQ) = s; }
+
+    for (z = cbz0; z <= cbz1; z++)
+    {
+        for (i = 0; i < n; i++)
+        {
+            int dz = z - p[i].z;
+            if (p[i].z + az - z > dz) dz = p[i].z + az - z;
+            dz2[i] = dz*dz;
+        }
+        // the furthest corner is convex along the row, so we can bisect for
+        // the first position where it stops decreasing
+        x0 = cbx0;
+        x1 = cbx1;
+        while (x0 < x1)
+        {
+            int sq0, sq1;
+            x = x0 + (x1 - x0) / 2;
+            MULTI_SQ(x, sq0);
+            MULTI_SQ(x+1, sq1);
+            if (sq1 >= sq0)
+                x1 = x;
+            else
+                x0 = x + 1;
+        }
+        int sq;
+        MULTI_SQ(x0, sq);
+        if (sq < sqrad)
+            sqrad = sq;
+    }
+#undef MULTI_SQ
+
+    return sqrad < 0x7fffffff ? sqrtf(sqrad + ay*ay/4.0f) : 0xffff;
+}
+
 static inline float isQuadBase(const StructureConfig sconf, uint64_t seed, int radius)
 {
     switch(sconf.structType)
@@ -514,6 +744,146 @@ float isQuadBaseLarge(const StructureConfig sconf, uint64_t seed,
     return sqrad < radius ? sqrad : 0;
 }
 
+static inline float isMultiBase(const StructureConfig sconf, uint64_t seed,
+        int regs, int radius)
+{
+    switch(sconf.structType)
+    {
+    case Swamp_Hut:
+        return isMultiBaseFeature(sconf, seed, regs, 7+1, 7+1, 9+1, radius);
+    case Desert_Pyramid:
+    case Jungle_Pyramid:
+    case Igloo:
+    case Village:
+    case Ocean_Ruin:
+    case Shipwreck:
+    case Ruined_Portal:
+        return isMultiBaseFeature(sconf, seed, regs, 0, 0, 0, radius);
+    case Outpost:
+        return isMultiBaseFeature(sconf, seed, regs, 72, 54, 72, radius);
+    case Monument:
+        return isMultiBaseLarge(sconf, seed, regs, 58, 23, 58, radius);
+    default:
+        fprintf(stderr, "isMultiBase: not implemented for structure type %d\n",
+                sconf.structType);
+        exit(-1);
+    }
+
+    return 0;
+}
+
+// nextInt(C) for the state 's', with the special case for powers of two
+static inline ATTR(always_inline, const)
+int getMultiBaseDraw(uint64_t s, int C)
+{
+    if (C & (C-1))
+        return (int)(s >> 17) % C;
+    return (int)(((uint64_t)C * (s >> 17)) >> 31);
+}
+
+static inline ATTR(always_inline, const)
+float isMultiBaseFeature(const StructureConfig sconf, uint64_t seed, int regs,
+        int ax, int ay, int az, int radius)
+{
+    const uint64_t M = (1ULL << 48) - 1;
+    const uint64_t K = 0x5deece66dULL;
+    const uint64_t b = 0xb;
+
+    const int R = sconf.regionSize;
+    const int C = sconf.chunkRange;
+    // structures in neighbouring regions have to be within the diameter, so
+    // on the near side of the region border they are at least at 'lo*' and
+    // on the far side at most at 'hi*'
+    const int lox = R - (2*radius - ax) / 16, hix = C-1 - lox;
+    const int loz = R - (2*radius - az) / 16, hiz = C-1 - loz;
+    const int spanx = (regs & (MB_00|MB_01)) && (regs & (MB_10|MB_11));
+    const int spanz = (regs & (MB_00|MB_10)) && (regs & (MB_01|MB_11));
+    const int dsq = 4*radius*radius;
+
+    Pos p[4];
+    uint64_t s;
+    int i, j, n = 0;
+
+    seed += sconf.salt;
+    for (i = 0; i < 4; i++)
+    {
+        if (!(regs & (1 << i)))
+            continue;
+        int rx = i & 1, rz = i >> 1, x, z;
+        s = seed + rx * 341873128712ULL + rz * 132897987541ULL;
+        s ^= K;
+        s = (s * K + b) & M; x = getMultiBaseDraw(s, C);
+        if (spanx && (rx ? x > hix : x < lox)) return 0;
+        s = (s * K + b) & M; z = getMultiBaseDraw(s, C);
+        if (spanz && (rz ? z > hiz : z < loz)) return 0;
+        p[n].x = (rx * R + x) << 4;
+        p[n].z = (rz * R + z) << 4;
+        // the furthest blocks of two structures have to fit in the diameter
+        for (j = 0; j < n; j++)
+        {
+            int dx = abs(p[n].x - p[j].x) + ax;
+            int dz = abs(p[n].z - p[j].z) + az;
+            if (dx*dx + dz*dz > dsq)
+                return 0;
+        }
+        n++;
+    }
+
+    float sqrad = getEnclosingRadiusMulti(p, n, ax, ay, az, radius);
+    return sqrad < radius ? sqrad : 0;
+}
+
+static inline ATTR(always_inline, const)
+float isMultiBaseLarge(const StructureConfig sconf, uint64_t seed, int regs,
+        int ax, int ay, int az, int radius)
+{
+    const uint64_t M = (1ULL << 48) - 1;
+    const uint64_t K = 0x5deece66dULL;
+    const uint64_t b = 0xb;
+
+    // p1 = nextInt(range); p2 = nextInt(range); pos = (p1+p2)>>1
+    const int R = sconf.regionSize;
+    const int C = sconf.chunkRange;
+    const int lox = R - (2*radius - ax) / 16, hix = C-1 - lox;
+    const int loz = R - (2*radius - az) / 16, hiz = C-1 - loz;
+    const int spanx = (regs & (MB_00|MB_01)) && (regs & (MB_10|MB_11));
+    const int spanz = (regs & (MB_00|MB_10)) && (regs & (MB_01|MB_11));
+    const int dsq = 4*radius*radius;
+
+    Pos p[4];
+    uint64_t s;
+    int i, j, n = 0;
+
+    seed += sconf.salt;
+    for (i = 0; i < 4; i++)
+    {
+        if (!(regs & (1 << i)))
+            continue;
+        int rx = i & 1, rz = i >> 1, x, z;
+        s = seed + rx * 341873128712ULL + rz * 132897987541ULL;
+        s ^= K;
+        s = (s * K + b) & M; x =  getMultiBaseDraw(s, C);
+        s = (s * K + b) & M; x += getMultiBaseDraw(s, C); x >>= 1;
+        if (spanx && (rx ? x > hix : x < lox)) return 0;
+        s = (s * K + b) & M; z =  getMultiBaseDraw(s, C);
+        s = (s * K + b) & M; z += getMultiBaseDraw(s, C); z >>= 1;
+        if (spanz && (rz ? z > hiz : z < loz)) return 0;
+        p[n].x = (rx * R + x) << 4;
+        p[n].z = (rz * R + z) << 4;
+        for (j = 0; j < n; j++)
+        {
+            int dx = abs(p[n].x - p[j].x) + ax;
+            int dz = abs(p[n].z - p[j].z) + az;
+            if (dx*dx + dz*dz > dsq)
+                return 0;
+        }
+        n++;
+    }
+
+    float sqrad = getEnclosingRadiusMulti(p, n, ax, ay, az, radius);
+    return sqrad < radius ? sqrad : 0;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -35,6 +35,15 @@ typedef double      f64;
 #define ATTR(...)               __attribute__((__VA_ARGS__))
 #define BSWAP32(X)              __builtin_bswap32(X)
 #define UNREACHABLE()           __builtin_unreachable()
+#define THREAD_LOCAL            __thread
+
+// atomics on 32-bit integers, used by structures that are shared by threads
+#define ATOMIC_SAFE             1
+#define ATOMIC_LOAD(P)          __atomic_load_n(P, __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(P,V)       __atomic_store_n(P, V, __ATOMIC_RELEASE)
+#define ATOMIC_CAS(P,E,V)       __sync_bool_compare_and_swap(P, E, V)
+#define ATOMIC_ADD(P,V)         __sync_fetch_and_add(P, V)
+#define ATOMIC_FENCE()          __sync_synchronize()
 
 #else
 
@@ -49,9 +58,24 @@ static inline uint32_t BSWAP32(uint32_t x) {
     return x;
 }
 #if _MSC_VER
+#include <intrin.h>
 #define UNREACHABLE()           __assume(0)
+#define THREAD_LOCAL            __declspec(thread)
+#define ATOMIC_SAFE             1
+#define ATOMIC_LOAD(P)          (*(volatile long*)(P))
+#define ATOMIC_STORE(P,V)       _InterlockedExchange((volatile long*)(P), (V))
+#define ATOMIC_CAS(P,E,V)       \
+    (_InterlockedCompareExchange((volatile long*)(P), (V), (E)) == (long)(E))
+#define ATOMIC_ADD(P,V)         _InterlockedExchangeAdd((volatile long*)(P), (V))
+#define ATOMIC_FENCE()          _ReadWriteBarrier()
 #else
 #define UNREACHABLE()           exit(1) // [[noreturn]]
+#define ATOMIC_SAFE             0 // no thread safety, runThreads() serializes
+#define ATOMIC_LOAD(P)          (*(P))
+#define ATOMIC_STORE(P,V)       (*(P) = (V))
+#define ATOMIC_CAS(P,E,V)       (*(P) == (E) ? (*(P) = (V), 1) : 0)
+#define ATOMIC_ADD(P,V)         ((*(P) += (V)) - (V))
+#define ATOMIC_FENCE()
 #endif
 
 #endif
@@ -1,5 +1,6 @@
 #include "finders.h"
 #include "util.h"
+#include "quadbase.h"
 
 #include <sys/time.h>
 #include <time.h>
@@ -221,6 +222,514 @@ int testGeneration()
 }
 
 
+/* Checks that overlapping 1:1 areas agree with each other and with single
+ * position lookups, i.e. that the voronoi stage depends only on the world
+ * position and not on the origin of the request.
+ */
+int testVoronoiOverlap()
+{
+    const int mc_vers[] = { MC_1_15, MC_1_16, MC_1_17, MC_1_21 };
+    const int testcnt = sizeof(mc_vers) / sizeof(int);
+    Generator g;
+    uint64_t s;
+    int test, i, j, ok = 1;
+
+    printf("Testing overlap consistency of 1:1 generation:\n");
+    for (test = 0; test < testcnt; test++)
+    {
+        int mismatch = 0, cnt = 0;
+        setupGenerator(&g, mc_vers[test], 0);
+        for (s = 0; s < 16; s++)
+        {
+            int x = (int)(hash32(s << 5) % 20000) - 10000;
+            int z = (int)(hash32(s << 9) % 20000) - 10000;
+            int dx = 1 + hash32(s << 11) % 15;
+            int dz = 1 + hash32(s << 13) % 15;
+            Range ra = {1, x, z, 40, 40, 64, 1};
+            Range rb = {1, x+dx, z+dz, 40, 40, 64, 1};
+            applySeed(&g, DIM_OVERWORLD, s);
+            int *a = allocCache(&g, ra);
+            int *b = allocCache(&g, rb);
+            genBiomes(&g, a, ra);
+            genBiomes(&g, b, rb);
+            for (j = dz; j < ra.sz; j++)
+            {
+                for (i = dx; i < ra.sx; i++)
+                {
+                    int id = a[j*ra.sx + i];
+                    mismatch += id != b[(j-dz)*rb.sx + (i-dx)];
+                    if ((i ^ j) % 7 == 0)
+                        mismatch += id != getBiomeAt(&g, 1, x+i, 64, z+j);
+                    cnt++;
+                }
+            }
+            free(a);
+            free(b);
+        }
+        printf("  MC %-6s: %d mismatches in %d cells %s\e[0m\n",
+            mc2str(mc_vers[test]), mismatch, cnt,
+            mismatch ? "\e[1;91mFAILED" : "\e[1;92mOK");
+        ok &= !mismatch;
+    }
+    return ok ? 0 : -1;
+}
+
+
+/* Checks that getBiomeCentersIds() joins areas across gaps of fewer than 'tol'
+ * cells, independent of the thread count, and that getBiomeCenters() agrees
+ * with it on a fully generated buffer.
+ */
+int testBiomeCenters()
+{
+    enum { W = 40, H = 12, NMAX = 256 };
+    int ids[W*H];
+    Pos p0[NMAX], p1[NMAX];
+    int s0[NMAX], s1[NMAX];
+    int i, j, gap, tol, t, n0, n1, ok = 1;
+    Range r = {4, 0, 0, W, H, 0, 1};
+
+    printf("Testing biome centers:\n");
+    for (gap = 1; gap <= 4; gap++)
+    {
+        // two blocks of forest, 'gap' cells of plains apart
+        for (j = 0; j < H; j++)
+            for (i = 0; i < W; i++)
+                ids[j*W+i] = (i < 10 || (i >= 10+gap && i < 20+gap)) &&
+                    j >= 2 && j < 10 ? forest : plains;
+        for (tol = 1; tol <= 5; tol++)
+        {
+            for (t = 1; t <= 4; t++)
+            {
+                n0 = getBiomeCentersIds(p0, s0, NULL, NMAX, ids, r,
+                    1ULL << forest, 0, 1, tol, t, NULL);
+                if (n0 != (gap < tol ? 1 : 2) || s0[0] != (n0 == 1 ? 160 : 80))
+                {
+                    printf("  gap %d, tol %d, %d threads: %d areas\n",
+                        gap, tol, t, n0);
+                    ok = 0;
+                }
+            }
+        }
+    }
+
+    Generator g;
+    setupGenerator(&g, MC_1_21, 0);
+    applySeed(&g, DIM_OVERWORLD, 1);
+    Range rg = {4, -128, -128, 256, 256, 16, 1};
+    int *cache = allocCache(&g, rg);
+    genBiomes(&g, cache, rg);
+    for (tol = 1; tol <= 3; tol++)
+    {
+        n0 = getBiomeCenters(p0, s0, NMAX, &g, rg, forest, 4, tol, NULL);
+        n1 = getBiomeCentersIds(p1, s1, NULL, NMAX, cache, rg,
+            1ULL << forest, 0, 4, tol, 4, NULL);
+        if (n0 != n1 || memcmp(p0, p1, n0 * sizeof(Pos)) ||
+            memcmp(s0, s1, n0 * sizeof(int)))
+        {
+            printf("  tol %d: generated %d != buffered %d areas\n", tol, n0, n1);
+            ok = 0;
+        }
+    }
+    free(cache);
+    printf("  %s\e[0m\n", ok ? "\e[1;92mOK" : "\e[1;91mFAILED");
+    return ok ? 0 : -1;
+}
+
+/* Checks the 1.18+ surface height approximation against a reference hash,
+ * that overlapping requests agree, that the coarse estimate stays close, and
+ * that the legacy call with a SurfaceNoise from initSurfaceNoise() gives the
+ * same heights. The heights are also checked against the terrain that the
+ * biomes require: deep oceans are only placed where the seafloor lies below
+ * sea level (y=63), while meadows, groves, slopes and peaks are only placed on
+ * elevated terrain, above it.
+ */
+int testApproxHeight118(uint32_t expect)
+{
+    enum { W = 24, H = 24, D = 8, A = 64 };
+    float y[W*H], ysub[W*H], yfast[W*H], yold[W*H];
+    Generator g;
+    SurfaceNoise sn, snold;
+    uint32_t h = 0;
+    double err = 0;
+    uint64_t s;
+    int i, j, ok = 1, nlow = 0, nhigh = 0;
+
+    printf("Testing 1.18+ surface height approximation:\n");
+    setupGenerator(&g, MC_1_21, 0);
+    for (s = 0; s < 16; s++)
+    {
+        int x = (int)(hash32(s << 5) % 20000) - 10000;
+        int z = (int)(hash32(s << 9) % 20000) - 10000;
+        applySeed(&g, DIM_OVERWORLD, s);
+
+        initSurfaceNoise(&snold, DIM_OVERWORLD, s);
+        initSurfaceNoise118(&sn, s);
+        if (mapApproxHeight(y, NULL, &g, &sn, x, z, W, H) ||
+            mapApproxHeight(ysub, NULL, &g, &sn, x+D, z+D, W-D, H-D) ||
+            mapApproxHeightFast(yfast, NULL, &g, &sn, x, z, W, H) ||
+            mapApproxHeight(yold, NULL, &g, &snold, x, z, W, H))
+        {
+            printf("  mapping failed for seed %d\n", (int) s);
+            ok = 0;
+            break;
+        }
+        if (memcmp(y, yold, sizeof(y)))
+        {
+            printf("  legacy surface noise differs at seed %d\n", (int) s);
+            ok = 0;
+        }
+        for (j = 0; j < H; j++)
+        {
+            for (i = 0; i < W; i++)
+            {
+                float v = y[j*W+i];
+                h = hash32(h ^ hash32((int)floor(v * 16) + (i << 17)));
+                err += fabs(v - yfast[j*W+i]);
+                if (i >= D && j >= D && v != ysub[(j-D)*(W-D) + (i-D)])
+                {
+                    printf("  overlap mismatch at seed %d\n", (int) s);
+                    ok = 0;
+                    i = W; j = H;
+                }
+            }
+        }
+    }
+    err /= 16.0 * W * H;
+    printf("  expecting %08x ... got %08x, coarse deviation %.2f blocks\n",
+        expect, h, err);
+    ok &= (h == expect) && err < 4;
+
+    for (s = 0; ok && s < 4; s++)
+    {   // single cells on a sparse grid, spread over land and sea
+        applySeed(&g, DIM_OVERWORLD, s);
+        initSurfaceNoise118(&sn, s);
+        for (i = 0; i < A*A; i++)
+        {
+            int x = (i % A - A/2) * 64, z = (i / A - A/2) * 64;
+            float v;
+            if (mapApproxHeight(&v, NULL, &g, &sn, x, z, 1, 1))
+            {
+                ok = 0;
+                break;
+            }
+            // the biome at the estimated surface, as y=0 is mostly caves
+            int id = getBiomeAt(&g, 4, x, (int)v >> 2, z);
+            if (isDeepOcean(id))
+            {
+                nlow++;
+                if (v < 63)
+                    continue;
+            }
+            else if (id == meadow || id == grove || id == snowy_slopes ||
+                id == jagged_peaks || id == frozen_peaks || id == stony_peaks)
+            {
+                nhigh++;
+                if (v > 63)
+                    continue;
+            }
+            else continue;
+            printf("  %s at y=%.1f (seed %d)\n", biome2str(MC_1_21, id),
+                v, (int) s);
+            ok = 0;
+        }
+    }
+    printf("  checked %d deep ocean and %d highland cells\n", nlow, nhigh);
+    ok &= nlow > 0 && nhigh > 0;
+    printf("  %s\e[0m\n", ok ? "\e[1;92mOK" : "\e[1;91mFAILED");
+    return ok ? 0 : -1;
+}
+
+
+/* Checks that compressed biome maps, packed from a buffer and generated on
+ * several threads, return the ids of genBiomes() and survive a save and load,
+ * and that files with a bad header, a truncated offset table, an offset past
+ * the end or a corrupt tile encoding are rejected (-2). The file at 'path' is
+ * overwritten and removed.
+ */
+int testPackedBiomes(const char *path)
+{
+    Generator g;
+    PackedBiomes pa, pb, pc;
+    Range r = {4, -333, 97, 301, 203, 15, 1};
+    int tilesiz = 64;
+    int *ids, i, j, ok = 1;
+    FILE *fp;
+
+    printf("Testing packed biome maps:\n");
+    setupGenerator(&g, MC_1_17, 0);
+    applySeed(&g, DIM_OVERWORLD, 1234);
+    ids = allocCache(&g, r);
+    if (!ids || genBiomes(&g, ids, r) ||
+        packBiomes(&pa, ids, r, tilesiz) ||
+        genPackedBiomes(&pb, &g, r, tilesiz, 3))
+    {
+        printf("  packing failed\n");
+        free(ids);
+        return -1;
+    }
+    if (pa.ofs[pa.tw*pa.th] != pb.ofs[pb.tw*pb.th] ||
+        memcmp(pa.data, pb.data, pa.ofs[pa.tw*pa.th]))
+    {
+        printf("  packed and generated maps differ\n");
+        ok = 0;
+    }
+    for (j = 0; j < r.sz; j++)
+    {
+        for (i = 0; i < r.sx; i++)
+        {
+            int id = getPackedBiomeAt(&pb, r.x+i, r.z+j);
+            if (id != ids[j*r.sx+i])
+            {
+                printf("  (%d, %d): %d != %d\n", i, j, id, ids[j*r.sx+i]);
+                ok = 0;
+                i = r.sx; j = r.sz;
+            }
+        }
+    }
+
+    if (savePackedBiomes(&pb, path) || loadPackedBiomes(&pc, path))
+    {
+        printf("  save and load failed\n");
+        ok = 0;
+    }
+    else
+    {
+        size_t cnt = (size_t)pc.tw * pc.th;
+        if (pc.ofs[cnt] != pb.ofs[cnt] ||
+            memcmp(pc.ofs, pb.ofs, (cnt+1) * sizeof(uint64_t)) ||
+            memcmp(pc.data, pb.data, pc.ofs[cnt]))
+        {
+            printf("  loaded map differs\n");
+            ok = 0;
+        }
+        freePackedBiomes(&pc);
+    }
+
+    // corrupt the file in place: header, offsets and a tile encoding
+    long hdr = 8 + 4 + 7*4, tab = hdr + 8 * (long)(pb.tw*pb.th + 1);
+    long mods[][2] = {
+        { 0, 'X' },                 // magic
+        { tab - 1, 0x7f },          // last offset past the end of the file
+        { tab, 3 },                 // tile 0 with 3 bits per cell
+        { tab + 1, 0xff },          // tile 0 with a palette past its end
+    };
+    for (i = 0; i < (int)(sizeof(mods) / sizeof(*mods)); i++)
+    {
+        int c;
+        fp = fopen(path, "r+b");
+        if (!fp || fseek(fp, mods[i][0], SEEK_SET) || (c = fgetc(fp)) < 0 ||
+            fseek(fp, mods[i][0], SEEK_SET) || fputc((int)mods[i][1], fp) < 0)
+        {
+            printf("  could not modify the file\n");
+            ok = 0;
+            if (fp) fclose(fp);
+            break;
+        }
+        fclose(fp);
+        int err = loadPackedBiomes(&pc, path);
+        if (err != -2)
+        {
+            printf("  corruption %d was not rejected: %d\n", i, err);
+            ok = 0;
+        }
+        if (err == 0)
+            freePackedBiomes(&pc);
+        fp = fopen(path, "r+b");
+        if (fp)
+        {
+            fseek(fp, mods[i][0], SEEK_SET);
+            fputc(c, fp);
+            fclose(fp);
+        }
+    }
+    // truncated within the offset table
+    if (savePackedBiomes(&pb, path) == 0 && (fp = fopen(path, "rb")))
+    {
+        unsigned char buf[256];
+        size_t n = fread(buf, 1, sizeof(buf), fp);
+        fclose(fp);
+        fp = fopen(path, "wb");
+        if (fp)
+        {
+            fwrite(buf, 1, n < (size_t)tab - 4 ? n : (size_t)tab - 4, fp);
+            fclose(fp);
+        }
+        if (loadPackedBiomes(&pc, path) != -2)
+        {
+            printf("  truncated file was not rejected\n");
+            ok = 0;
+        }
+    }
+    remove(path);
+
+    freePackedBiomes(&pa);
+    freePackedBiomes(&pb);
+    free(ids);
+    printf("  %s\e[0m\n", ok ? "\e[1;92mOK" : "\e[1;91mFAILED");
+    return ok ? 0 : -1;
+}
+
+
+static int cmpPos(const void *a, const void *b)
+{
+    const Pos *pa = (const Pos*) a, *pb = (const Pos*) b;
+    if (pa->x != pb->x) return pa->x < pb->x ? -1 : 1;
+    return pa->z < pb->z ? -1 : pa->z > pb->z;
+}
+
+int testQuadScan()
+{
+    // the larger radii give enough hits to compare, 96 and 64 are rejected
+    // entirely by the prefilter and 320 leaves no prefilter
+    struct { int stype, radius, lowBitN; const uint64_t *lowBits; } cf[] = {
+        { Swamp_Hut, 192,  1, NULL },
+        { Village,   192,  1, NULL },
+        { Monument,  256,  1, NULL },
+        { Swamp_Hut,  96,  1, NULL },
+        { Outpost,    64,  1, NULL },
+        { Outpost,   320,  1, NULL },
+        { Swamp_Hut, 128, 20, low20QuadHutBarely },
+        { Swamp_Hut, 192, 48, NULL },
+    };
+    // with a salt of 1, the subset values {1, 2} cover all lower bits
+    uint64_t all[] = { 1, 2, 0 };
+    uint64_t lbit48[] = { 0, 0 };
+    enum { NSEEDS = 12, NMAX = 4096 };
+    uint64_t seeds[NSEEDS];
+    QuadHit *qh = (QuadHit*) malloc(NMAX * sizeof(QuadHit));
+    Pos *qp = (Pos*) malloc(NMAX * sizeof(Pos));
+    int i, k, ok = 1;
+
+    printf("Testing batch scan for quad-bases:\n");
+    if (!qh || !qp)
+    {
+        free(qh);
+        free(qp);
+        return -1;
+    }
+    for (i = 0; i < NSEEDS; i++)
+        seeds[i] = (hash32(i) * 0x9e3779b97f4aULL + i) & MASK48;
+
+    for (k = 0; k < (int)(sizeof(cf) / sizeof(*cf)); k++)
+    {
+        StructureConfig sconf;
+        getStructureConfig(cf[k].stype, MC_1_18, &sconf);
+        const uint64_t *lowBits = cf[k].lowBits ? cf[k].lowBits : all;
+        uint64_t salt = cf[k].lowBits ? 0 : 1;
+        if (cf[k].lowBitN == 48)
+        {   // the full base seed of the first hit
+            lowBits = lbit48;
+            salt = 0;
+        }
+        int x = -96, z = -64, w = 191, h = 127;
+        int n = scanSeedsForQuads(sconf, cf[k].radius, seeds, NSEEDS,
+                lowBits, cf[k].lowBitN, salt, x, z, w, h, qh, NMAX, 3);
+        int tot = 0, j = 0;
+        for (i = 0; i < NSEEDS && ok; i++)
+        {
+            int m = scanForQuads(sconf, cf[k].radius, seeds[i],
+                    lowBits, cf[k].lowBitN, salt, x, z, w, h,
+                    qp, NMAX - tot);
+            qsort(qp, m, sizeof(Pos), cmpPos);
+            for (int l = 0; l < m; l++, j++)
+            {
+                if (j >= n || qh[j].s48 != seeds[i] ||
+                    qh[j].x != qp[l].x || qh[j].z != qp[l].z)
+                {
+                    printf("  config %d, seed %d: (%d, %d) not matched\n",
+                        k, i, qp[l].x, qp[l].z);
+                    ok = 0;
+                    break;
+                }
+            }
+            tot += m;
+        }
+        if (ok && n != tot)
+        {
+            printf("  config %d: %d != %d hits\n", k, n, tot);
+            ok = 0;
+        }
+        if (!ok)
+            break;
+        printf("  config %d: %d hits\n", k, n);
+        if (k == 0 && n > 0)
+            lbit48[0] = moveStructure(qh[0].s48, -qh[0].x, -qh[0].z);
+    }
+
+    free(qh);
+    free(qp);
+    printf("  %s\e[0m\n", ok ? "\e[1;92mOK" : "\e[1;91mFAILED");
+    return ok ? 0 : -1;
+}
+
+
+int testLowBits(const char *path)
+{
+    MultiBaseCheck chk;
+    LowBits la, lb;
+    const uint64_t *p;
+    uint64_t i;
+    int n = 0, ok = 1;
+
+    printf("Testing generated lower bits:\n");
+    memset(&chk, 0, sizeof(chk));
+    getStructureConfig(Swamp_Hut, MC_1_18, &chk.sconf);
+    chk.regs = MB_QUAD;
+    chk.radius = 128;
+    chk.ax = 7+1; chk.ay = 7+1; chk.az = 9+1;
+    if (genLowBits(&la, &chk, 20, 4))
+    {
+        printf("  generation failed\n");
+        return -1;
+    }
+    // the table holds bits of the salted seed
+    for (p = low20QuadHutBarely; *p; p++, n++)
+    {
+        if (!hasLowBits(&la, (*p - chk.sconf.salt) & 0xfffff))
+        {
+            printf("  missing 0x%05" PRIx64 "\n", *p);
+            ok = 0;
+        }
+    }
+    if (la.cnt != (uint64_t) n)
+    {
+        printf("  %" PRIu64 " != %d candidates\n", la.cnt, n);
+        ok = 0;
+    }
+
+    if (saveLowBits(&la, path) || loadLowBits(&lb, path))
+    {
+        printf("  save and load failed\n");
+        ok = 0;
+    }
+    else
+    {
+        if (lb.lowBitN != la.lowBitN || lb.cnt != la.cnt ||
+            lb.nlist != la.nlist ||
+            memcmp(lb.list, la.list, (la.nlist + 1) * sizeof(uint64_t)))
+        {
+            printf("  loaded set differs\n");
+            ok = 0;
+        }
+        for (i = 0; i < (1ULL << la.lowBitN); i++)
+        {
+            if (hasLowBits(&la, i) != hasLowBits(&lb, i))
+            {
+                printf("  loaded set differs at 0x%05" PRIx64 "\n", i);
+                ok = 0;
+                break;
+            }
+        }
+        freeLowBits(&lb);
+    }
+    remove(path);
+
+    freeLowBits(&la);
+    printf("  %s\e[0m\n", ok ? "\e[1;92mOK" : "\e[1;91mFAILED");
+    return ok ? 0 : -1;
+}
+
+
 int k_tot;
 struct _f_para { double v; double *buf; int x, z, w, h; };
 int _f1(void *data, int x, int z, double v)
@@ -534,6 +1043,12 @@ int main()
     //testAreas(mc, 0, 256);
     //testCanBiomesGenerate();
     //testGeneration();
+    //testVoronoiOverlap();
+    //testApproxHeight118(0xa9bd7c00);
+    //testBiomeCenters();
+    //testPackedBiomes("packed_test.bin");
+    //testQuadScan();
+    //testLowBits("lowbits_test.bin");
     //findBiomeParaBounds();
 
     return 0;
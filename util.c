@@ -4,6 +4,20 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+typedef HANDLE thread_id_t;
+#else
+#define USE_PTHREAD
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+typedef pthread_t thread_id_t;
+#endif
 
 
 
@@ -518,9 +532,10 @@ int parseBiomeColors(unsigned char biomeColors[256][3], const char *buf)
 }
 
 
-int biomesToImage(unsigned char *pixels,
+// Either 'biomes' or the compact 'biomes8' is given.
+static int biomesToImageImpl(unsigned char *pixels,
         unsigned char biomeColors[256][3], const int *biomes,
-        const unsigned int sx, const unsigned int sy,
+        const uint8_t *biomes8, const unsigned int sx, const unsigned int sy,
         const unsigned int pixscale, const int flip)
 {
     unsigned int i, j;
@@ -530,7 +545,11 @@ int biomesToImage(unsigned char *pixels,
     {
         for (i = 0; i < sx; i++)
         {
-            int id = biomes[j*sx+i];
+            int id;
+            if (biomes8)
+                id = biomes8[j*sx+i] == 0xff ? -1 : biomes8[j*sx+i];
+            else
+                id = biomes[j*sx+i];
             unsigned int r, g, b;
 
             if (id < 0 || id >= 256)
@@ -569,6 +588,24 @@ int biomesToImage(unsigned char *pixels,
     return containsInvalidBiomes;
 }
 
+int biomesToImage(unsigned char *pixels,
+        unsigned char biomeColors[256][3], const int *biomes,
+        const unsigned int sx, const unsigned int sy,
+        const unsigned int pixscale, const int flip)
+{
+    return biomesToImageImpl(pixels, biomeColors, biomes, NULL, sx, sy,
+        pixscale, flip);
+}
+
+int biomesToImage8(unsigned char *pixels,
+        unsigned char biomeColors[256][3], const uint8_t *biomes,
+        const unsigned int sx, const unsigned int sy,
+        const unsigned int pixscale, const int flip)
+{
+    return biomesToImageImpl(pixels, biomeColors, NULL, biomes, sx, sy,
+        pixscale, flip);
+}
+
 int savePPM(const char *path, const unsigned char *pixels, const unsigned int sx, const unsigned int sy)
 {
     FILE *fp = fopen(path, "wb");
@@ -582,3 +619,974 @@ int savePPM(const char *path, const unsigned char *pixels, const unsigned int sx
 }
 
 
+
+STRUCT(thread_arg_t)
+{
+    void (*func)(void *data, int t);
+    void *data;
+    int t;
+    int started;
+};
+
+#ifdef USE_PTHREAD
+static void *runThread(void *arg)
+#else
+static DWORD WINAPI runThread(LPVOID arg)
+#endif
+{
+    thread_arg_t *a = (thread_arg_t*) arg;
+    a->func(a->data, a->t);
+    return 0;
+}
+
+void runThreads(int threads, void (*func)(void *data, int t), void *data)
+{
+    int t;
+    if (threads <= 1)
+    {
+        func(data, 0);
+        return;
+    }
+    if (!ATOMIC_SAFE)
+    {   // the shares rely on atomics, so without them they run in turn
+        for (t = 0; t < threads; t++)
+            func(data, t);
+        return;
+    }
+
+    thread_arg_t *args = (thread_arg_t*) malloc(threads * sizeof(*args));
+    thread_id_t *tids = (thread_id_t*) malloc(threads * sizeof(*tids));
+    if (!args || !tids)
+    {   // without the thread state the shares run in turn
+        for (t = 0; t < threads; t++)
+            func(data, t);
+        free(tids);
+        free(args);
+        return;
+    }
+
+    for (t = 0; t < threads; t++)
+    {
+        args[t].func = func;
+        args[t].data = data;
+        args[t].t = t;
+        args[t].started = 0;
+    }
+
+    // the calling thread takes the first share, as well as those of any
+    // threads that could not be created
+#ifdef USE_PTHREAD
+    for (t = 1; t < threads; t++)
+        args[t].started = !pthread_create(&tids[t], NULL, runThread, (void*)&args[t]);
+    func(data, 0);
+    for (t = 1; t < threads; t++)
+    {
+        if (args[t].started)
+            pthread_join(tids[t], NULL);
+        else
+            func(data, t);
+    }
+#else
+    int n = 0;
+    for (t = 1; t < threads; t++)
+    {
+        tids[n] = CreateThread(NULL, 0, runThread, (LPVOID)&args[t], 0, NULL);
+        if (tids[n])
+        {
+            args[t].started = 1;
+            n++;
+        }
+    }
+    func(data, 0);
+    for (t = 1; t < threads; t++)
+    {
+        if (!args[t].started)
+            func(data, t);
+    }
+    if (n)
+        WaitForMultipleObjects(n, tids, TRUE, INFINITE);
+    for (t = 0; t < n; t++)
+        CloseHandle(tids[t]);
+#endif
+
+    free(tids);
+    free(args);
+}
+
+
+
+// Maps a file into memory for reading (and writing). With 'create', the file
+// is created as needed and resized to '*size', otherwise the whole existing
+// file is mapped and its size is returned in '*size'.
+static void *mapFile(const char *path, size_t *size, int create, int write)
+{
+    void *p;
+#if defined(_WIN32)
+    LARGE_INTEGER siz;
+    HANDLE fh = CreateFileA(path,
+        write ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ,
+        NULL, create ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fh == INVALID_HANDLE_VALUE)
+        return NULL;
+    if (create)
+        siz.QuadPart = *size;
+    else if (!GetFileSizeEx(fh, &siz))
+        siz.QuadPart = 0;
+    *size = (size_t) siz.QuadPart;
+    if (*size == 0)
+    {
+        CloseHandle(fh);
+        return NULL;
+    }
+    HANDLE mh = CreateFileMappingA(fh, NULL,
+        write ? PAGE_READWRITE : PAGE_READONLY, siz.HighPart, siz.LowPart, NULL);
+    p = mh ? MapViewOfFile(mh, write ? FILE_MAP_WRITE : FILE_MAP_READ,
+        0, 0, *size) : NULL;
+    // the view keeps the file mapped after the handles are closed
+    if (mh)
+        CloseHandle(mh);
+    CloseHandle(fh);
+#else
+    struct stat st;
+    int fd = open(path, !write ? O_RDONLY : create ? O_RDWR | O_CREAT : O_RDWR,
+        0644);
+    if (fd < 0)
+        return NULL;
+    if (create)
+    {
+        if (ftruncate(fd, (off_t) *size) != 0)
+            *size = 0;
+    }
+    else
+    {
+        *size = fstat(fd, &st) == 0 ? (size_t) st.st_size : 0;
+    }
+    if (*size == 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    p = mmap(NULL, *size, write ? PROT_READ | PROT_WRITE : PROT_READ,
+        MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+        p = NULL;
+    close(fd);
+#endif
+    return p;
+}
+
+// Writes the bytes [ofs, ofs+len) of a mapping back to the file, waiting for
+// the write to complete.
+static void syncFile(void *p, size_t ofs, size_t len)
+{
+#if defined(_WIN32)
+    FlushViewOfFile((char*) p + ofs, len);
+#else
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t a = ofs / page * page;
+    msync((char*) p + a, ofs + len - a, MS_SYNC);
+#endif
+}
+
+static void unmapFile(void *p, size_t size, int flush)
+{
+#if defined(_WIN32)
+    if (flush)
+        FlushViewOfFile(p, size);
+    UnmapViewOfFile(p);
+#else
+    if (flush)
+        msync(p, size, MS_SYNC);
+    munmap(p, size);
+#endif
+}
+
+static void initBiomeMapHeader(BiomeMapHeader *h, const Generator *g,
+        Range r, int tilesiz)
+{
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, "CUBIOMAP", 8);
+    h->version = BIOME_MAP_VERSION;
+    h->cellsiz = sizeof(int);
+    h->seed = g->seed;
+    h->mc = g->mc;
+    h->dim = g->dim;
+    h->flags = g->flags;
+    h->scale = r.scale;
+    h->x = r.x;
+    h->z = r.z;
+    h->sx = r.sx;
+    h->sz = r.sz;
+    h->y = r.y;
+    h->tilesiz = tilesiz;
+    h->tw = (r.sx + tilesiz - 1) / tilesiz;
+    h->th = (r.sz + tilesiz - 1) / tilesiz;
+    h->dataofs = sizeof(*h) + (uint64_t) h->tw * h->th;
+    h->dataofs = (h->dataofs + 4095) & ~(uint64_t) 4095;
+}
+
+static size_t getBiomeMapSize(const BiomeMapHeader *h)
+{
+    uint64_t tilelen = (uint64_t) h->tilesiz * h->tilesiz * h->cellsiz;
+    return (size_t) (h->dataofs + tilelen * h->tw * h->th);
+}
+
+// Checks that the tile layout of a header is consistent with its extent and
+// that the size of the map is representable.
+static int isBiomeMapHeaderValid(const BiomeMapHeader *h)
+{
+    if (h->sx <= 0 || h->sz <= 0 || h->tilesiz <= 0 || h->tilesiz > 0x4000)
+        return 0;
+    if (h->tw != (int32_t)(((int64_t) h->sx + h->tilesiz - 1) / h->tilesiz) ||
+        h->th != (int32_t)(((int64_t) h->sz + h->tilesiz - 1) / h->tilesiz))
+        return 0;
+    uint64_t n = (uint64_t) h->tw * h->th;
+    uint64_t tilelen = (uint64_t) h->tilesiz * h->tilesiz * h->cellsiz;
+    if (n > INT_MAX || tilelen == 0 ||
+        h->dataofs < sizeof(*h) + n || h->dataofs > SIZE_MAX)
+        return 0;
+    return n <= (SIZE_MAX - h->dataofs) / tilelen;
+}
+
+static void setBiomeMap(BiomeMap *bm, void *p, size_t size)
+{
+    bm->hdr = (BiomeMapHeader*) p;
+    bm->done = (unsigned char*) p + sizeof(BiomeMapHeader);
+    bm->data = (unsigned char*) p + bm->hdr->dataofs;
+    bm->size = size;
+}
+
+int createBiomeMap(BiomeMap *bm, const char *path, const Generator *g,
+        Range r, int tilesiz)
+{
+    BiomeMapHeader h;
+    size_t size, oldsiz;
+    int i, n;
+    void *p;
+
+    memset(bm, 0, sizeof(*bm));
+    if (r.sx <= 0 || r.sz <= 0)
+        return -1;
+    if (tilesiz <= 0)
+        tilesiz = 256;
+    initBiomeMapHeader(&h, g, r, tilesiz);
+    if (!isBiomeMapHeaderValid(&h))
+        return -1;
+    size = getBiomeMapSize(&h);
+
+    p = mapFile(path, &oldsiz, 0, 1);
+    if (p)
+    {
+        // resume an existing map that matches exactly
+        if (oldsiz != size || memcmp(p, &h, sizeof(h)) != 0)
+        {
+            unmapFile(p, oldsiz, 0);
+            return -2;
+        }
+    }
+    else
+    {
+        p = mapFile(path, &size, 1, 1);
+        if (!p)
+            return -1;
+        memcpy(p, &h, sizeof(h));
+    }
+    setBiomeMap(bm, p, size);
+
+    for (n = i = 0; i < h.tw * h.th; i++)
+        n += bm->done[i] != 0;
+    return n;
+}
+
+STRUCT(biome_map_gen_t)
+{
+    BiomeMap *bm;
+    const Generator *g;
+    const int *todo;
+    int n, threads;
+    volatile char *stop;
+};
+
+// the number of finished tiles a thread collects before it syncs them
+enum { BIOME_MAP_SYNC = 64 };
+
+// Writes the pending tiles back to the file with one sync over the range they
+// span, after which their flags can be set.
+static void flushBiomeMapTiles(BiomeMap *bm, const int *pending, int n)
+{
+    const BiomeMapHeader *h = bm->hdr;
+    size_t len = (size_t) h->tilesiz * h->tilesiz * sizeof(int);
+    int i, lo = pending[0], hi = pending[0];
+
+    for (i = 1; i < n; i++)
+    {
+        if (pending[i] < lo) lo = pending[i];
+        if (pending[i] > hi) hi = pending[i];
+    }
+    // the tiles have to be in the file before their flags can be
+    syncFile(bm->hdr, h->dataofs + (size_t) lo * len,
+        (size_t) (hi - lo + 1) * len);
+    ATOMIC_FENCE();
+    for (i = 0; i < n; i++)
+        bm->done[pending[i]] = 1;
+}
+
+static void genBiomeMapShare(void *data, int t)
+{
+    biome_map_gen_t *b = (biome_map_gen_t*) data;
+    const BiomeMapHeader *h = b->bm->hdr;
+    int ts = h->tilesiz;
+    Range r = { h->scale, 0, 0, ts, ts, h->y, 1 };
+    int *cache = allocCache(b->g, r);
+    int pending[BIOME_MAP_SYNC];
+    int i, j, k, np = 0;
+
+    if (!cache)
+        return;
+    for (k = t; k < b->n; k += b->threads)
+    {
+        if (b->stop && *b->stop)
+            break;
+        int tile = b->todo[k];
+        int tx = tile % h->tw;
+        int tz = tile / h->tw;
+        r.x = h->x + tx * ts;
+        r.z = h->z + tz * ts;
+        r.sx = h->sx - tx * ts < ts ? h->sx - tx * ts : ts;
+        r.sz = h->sz - tz * ts < ts ? h->sz - tz * ts : ts;
+        if (genBiomes(b->g, cache, r))
+            continue;
+
+        size_t len = (size_t) ts * ts * sizeof(int);
+        size_t ofs = h->dataofs + (size_t) tile * len;
+        int *out = (int*) ((unsigned char*) b->bm->hdr + ofs);
+        for (j = 0; j < ts; j++)
+        {
+            for (i = 0; i < ts; i++)
+                out[j*ts + i] = (i < r.sx && j < r.sz) ? cache[j*r.sx + i] : -1;
+        }
+        pending[np++] = tile;
+        if (np == BIOME_MAP_SYNC)
+        {
+            flushBiomeMapTiles(b->bm, pending, np);
+            np = 0;
+        }
+    }
+    if (np)
+        flushBiomeMapTiles(b->bm, pending, np);
+    free(cache);
+}
+
+int genBiomeMap(BiomeMap *bm, const Generator *g, int threads,
+        volatile char *stop)
+{
+    const BiomeMapHeader *h = bm->hdr;
+    biome_map_gen_t b;
+    int i, n, cnt;
+
+    if (g->mc != h->mc || g->dim != h->dim || g->flags != h->flags ||
+        g->seed != h->seed)
+    {
+        return -1;
+    }
+
+    n = h->tw * h->th;
+    int *todo = (int*) malloc(n * sizeof(int));
+    if (!todo)
+        return -1;
+    for (cnt = i = 0; i < n; i++)
+    {
+        if (!bm->done[i])
+            todo[cnt++] = i;
+    }
+
+    b.bm = bm;
+    b.g = g;
+    b.todo = todo;
+    b.n = cnt;
+    b.threads = threads < 1 ? 1 : threads > cnt ? cnt : threads;
+    b.stop = stop;
+    if (cnt > 0)
+        runThreads(b.threads, genBiomeMapShare, &b);
+
+    for (n = i = 0; i < cnt; i++)
+        n += bm->done[todo[i]] != 0;
+    free(todo);
+    if (n)
+        syncFile(bm->hdr, sizeof(*h), (size_t) h->tw * h->th);
+    return n;
+}
+
+int openBiomeMap(BiomeMap *bm, const char *path)
+{
+    BiomeMapHeader *h;
+    size_t size;
+    void *p;
+
+    memset(bm, 0, sizeof(*bm));
+    p = mapFile(path, &size, 0, 0);
+    if (!p)
+        return -1;
+    h = (BiomeMapHeader*) p;
+    if (size < sizeof(*h) || memcmp(h->magic, "CUBIOMAP", 8) != 0 ||
+        h->version != BIOME_MAP_VERSION || h->cellsiz != sizeof(int) ||
+        !isBiomeMapHeaderValid(h) || size < getBiomeMapSize(h))
+    {
+        unmapFile(p, size, 0);
+        return -2;
+    }
+    setBiomeMap(bm, p, size);
+    return 0;
+}
+
+void closeBiomeMap(BiomeMap *bm)
+{
+    if (bm->hdr)
+        unmapFile(bm->hdr, bm->size, 1);
+    memset(bm, 0, sizeof(*bm));
+}
+
+const int *getBiomeMapTile(const BiomeMap *bm, int tx, int tz)
+{
+    const BiomeMapHeader *h = bm->hdr;
+    if (tx < 0 || tx >= h->tw || tz < 0 || tz >= h->th)
+        return NULL;
+    size_t tile = (size_t) tz * h->tw + tx;
+    if (!bm->done[tile])
+        return NULL;
+    return (const int*) (bm->data + tile * h->tilesiz * h->tilesiz * sizeof(int));
+}
+
+int getBiomeMapAt(const BiomeMap *bm, int x, int z)
+{
+    const BiomeMapHeader *h = bm->hdr;
+    int ts = h->tilesiz;
+    x -= h->x;
+    z -= h->z;
+    if (x < 0 || x >= h->sx || z < 0 || z >= h->sz)
+        return -1;
+    const int *tile = getBiomeMapTile(bm, x / ts, z / ts);
+    if (!tile)
+        return -1;
+    return tile[(z % ts) * ts + (x % ts)];
+}
+
+
+
+enum { PACKED_RLE = 0x80, PACKED_VERSION = 1 };
+
+// Encodes a tile of n cells of compact ids into 'out', which needs room for
+// 2 + 256 + 2*n bytes. Returns the length of the encoding.
+static size_t encodeBiomeTile(unsigned char *out, const unsigned char *ids,
+        int n)
+{
+    short idx[256];
+    unsigned char *pal = out + 2;
+    int i, np = 0, runs = 1, bits;
+
+    for (i = 0; i < 256; i++)
+        idx[i] = -1;
+    for (i = 0; i < n; i++)
+    {
+        if (idx[ids[i]] < 0)
+        {
+            idx[ids[i]] = np;
+            pal[np++] = ids[i];
+        }
+        if (i && ids[i] != ids[i-1])
+            runs++;
+    }
+    for (bits = 0; (1 << bits) < np; bits = bits ? 2*bits : 1);
+
+    size_t packed = ((size_t)n * bits + 7) >> 3;
+    // runs as (index, length) with lengths up to 255, counted pessimistically
+    size_t rle = 2 * ((size_t)runs + n / 255);
+    unsigned char *dat = pal + np;
+
+    out[1] = (unsigned char)(np - 1);
+    if (rle < packed)
+    {
+        size_t len = 0;
+        out[0] = PACKED_RLE;
+        for (i = 0; i < n; )
+        {
+            int j = i + 1;
+            while (j < n && j - i < 255 && ids[j] == ids[i])
+                j++;
+            dat[len++] = (unsigned char) idx[ids[i]];
+            dat[len++] = (unsigned char)(j - i);
+            i = j;
+        }
+        return (dat - out) + len;
+    }
+
+    out[0] = (unsigned char) bits;
+    memset(dat, 0, packed);
+    if (bits == 8)
+    {
+        for (i = 0; i < n; i++)
+            dat[i] = (unsigned char) idx[ids[i]];
+    }
+    else if (bits)
+    {
+        int per = 8 / bits;
+        for (i = 0; i < n; i++)
+            dat[i / per] |= idx[ids[i]] << ((i % per) * bits);
+    }
+    return (dat - out) + packed;
+}
+
+// Decodes n compact ids of a tile encoding of 'len' bytes. Returns 0 on
+// success, or -1 if the encoding is corrupt.
+static int decodeBiomeTile(unsigned char *ids, const unsigned char *enc,
+        size_t len, int n)
+{
+    if (len < 2)
+        return -1;
+    int bits = enc[0];
+    int np = enc[1] + 1;
+    const unsigned char *pal = enc + 2;
+    const unsigned char *dat = pal + np;
+    const unsigned char *end = enc + len;
+    int i, k;
+
+    if (len < 2 + (size_t)np)
+        return -1;
+
+    if (bits == PACKED_RLE)
+    {
+        for (i = 0; i < n; dat += 2)
+        {
+            if (end - dat < 2 || dat[0] >= np || dat[1] == 0 || dat[1] > n - i)
+                return -1;
+            memset(ids + i, pal[dat[0]], dat[1]);
+            i += dat[1];
+        }
+    }
+    else if (bits == 0)
+    {
+        memset(ids, pal[0], n);
+    }
+    else if (bits == 1 || bits == 2 || bits == 4 || bits == 8)
+    {
+        int per = 8 / bits, mask = (1 << bits) - 1;
+        if ((size_t)(end - dat) < ((size_t)n * bits + 7) >> 3)
+            return -1;
+        for (i = 0; i < n; i += per, dat++)
+        {
+            for (k = 0; k < per && i + k < n; k++)
+            {
+                int idx = (*dat >> (k * bits)) & mask;
+                if (idx >= np)
+                    return -1;
+                ids[i+k] = pal[idx];
+            }
+        }
+    }
+    else
+    {
+        return -1;
+    }
+    return 0;
+}
+
+static int getPackedCell(const unsigned char *enc, int i)
+{
+    int bits = enc[0];
+    const unsigned char *pal = enc + 2;
+    const unsigned char *dat = pal + enc[1] + 1;
+    int id;
+
+    if (bits == PACKED_RLE)
+    {
+        while (i >= dat[1])
+        {
+            i -= dat[1];
+            dat += 2;
+        }
+        id = pal[dat[0]];
+    }
+    else if (bits == 0)
+    {
+        id = pal[0];
+    }
+    else
+    {
+        int per = 8 / bits;
+        id = pal[(dat[i / per] >> ((i % per) * bits)) & ((1 << bits) - 1)];
+    }
+    return id == 0xff ? -1 : id;
+}
+
+static int initPackedBiomes(PackedBiomes *pb, Range r, int tilesiz)
+{
+    memset(pb, 0, sizeof(*pb));
+    if (r.sx <= 0 || r.sz <= 0)
+        return -1;
+    if (tilesiz <= 0)
+        tilesiz = 64;
+    pb->r = r;
+    pb->r.sy = 1;
+    pb->tilesiz = tilesiz;
+    pb->tw = (r.sx + tilesiz - 1) / tilesiz;
+    pb->th = (r.sz + tilesiz - 1) / tilesiz;
+    pb->ofs = (uint64_t*) calloc((size_t)pb->tw * pb->th + 1, sizeof(uint64_t));
+    return pb->ofs ? 0 : -1;
+}
+
+// Copies tile k of a buffer of ids for the whole range into compact ids.
+static void getPackedTileIds(unsigned char *out, const PackedBiomes *pb,
+        const int *ids, int k)
+{
+    int ts = pb->tilesiz;
+    int i0 = (k % pb->tw) * ts;
+    int j0 = (k / pb->tw) * ts;
+    int w = pb->r.sx - i0 < ts ? pb->r.sx - i0 : ts;
+    int h = pb->r.sz - j0 < ts ? pb->r.sz - j0 : ts;
+    if (w < ts || h < ts)
+        memset(out, 0xff, (size_t)ts * ts);
+    compactBiomeIds(out, ts, ids + (size_t)j0 * pb->r.sx + i0, pb->r.sx, w, h);
+}
+
+STRUCT(pack_share_t)
+{
+    PackedBiomes *pb;
+    const Generator *g;
+    const int *ids;
+    unsigned char **buf;    // encodings of each thread
+    size_t *len;            // length of the encoding of each tile
+    int *err;               // error status of each thread
+    int threads;
+};
+
+static void packBiomesShare(void *data, int t)
+{
+    pack_share_t *b = (pack_share_t*) data;
+    PackedBiomes *pb = b->pb;
+    int ts = pb->tilesiz, n = ts * ts;
+    int k, cnt = pb->tw * pb->th;
+    size_t pos = 0, cap = 0;
+    unsigned char *buf = NULL;
+    unsigned char *tile = (unsigned char*) malloc(n + 2 + 256 + 2 * (size_t)n);
+    unsigned char *enc = tile + n;
+    int *cache = NULL;
+    Range r = { pb->r.scale, 0, 0, ts, ts, pb->r.y, 1 };
+
+    if (b->g)
+        cache = allocCache(b->g, r);
+    if (!tile || (b->g && !cache))
+        goto L_err;
+
+    for (k = t; k < cnt; k += b->threads)
+    {
+        if (b->g)
+        {
+            int i0 = (k % pb->tw) * ts;
+            int j0 = (k / pb->tw) * ts;
+            r.x = pb->r.x + i0;
+            r.z = pb->r.z + j0;
+            r.sx = pb->r.sx - i0 < ts ? pb->r.sx - i0 : ts;
+            r.sz = pb->r.sz - j0 < ts ? pb->r.sz - j0 : ts;
+            if (genBiomes(b->g, cache, r) != 0)
+                goto L_err;
+            PackedBiomes sub = *pb;
+            sub.r = r;
+            sub.tw = 1;
+            getPackedTileIds(tile, &sub, cache, 0);
+        }
+        else
+        {
+            getPackedTileIds(tile, pb, b->ids, k);
+        }
+        size_t len = encodeBiomeTile(enc, tile, n);
+        if (pos + len > cap)
+        {
+            size_t newcap = cap ? 2 * cap : 4096;
+            while (pos + len > newcap)
+                newcap *= 2;
+            unsigned char *p = (unsigned char*) realloc(buf, newcap);
+            if (!p)
+                goto L_err;
+            buf = p;
+            cap = newcap;
+        }
+        memcpy(buf + pos, enc, len);
+        pos += len;
+        b->len[k] = len;
+    }
+    b->buf[t] = buf;
+    free(cache);
+    free(tile);
+    return;
+
+L_err:
+    b->err[t] = -1;
+    free(buf);
+    free(cache);
+    free(tile);
+}
+
+static int packBiomesImpl(PackedBiomes *pb, const Generator *g,
+        const int *ids, Range r, int tilesiz, int threads)
+{
+    pack_share_t b;
+    int k, t, cnt, err = 0;
+
+    if (initPackedBiomes(pb, r, tilesiz) != 0)
+    {
+        freePackedBiomes(pb);
+        return -1;
+    }
+    cnt = pb->tw * pb->th;
+    if (threads < 1)
+        threads = 1;
+    if (threads > cnt)
+        threads = cnt;
+
+    b.pb = pb;
+    b.g = g;
+    b.ids = ids;
+    b.threads = threads;
+    b.buf = (unsigned char**) calloc(threads, sizeof(*b.buf));
+    b.len = (size_t*) calloc(cnt, sizeof(*b.len));
+    b.err = (int*) calloc(threads, sizeof(*b.err));
+    if (!b.buf || !b.len || !b.err)
+        err = -1;
+    else
+        runThreads(threads, packBiomesShare, &b);
+
+    for (t = 0; t < threads && !err; t++)
+        err = b.err[t];
+    if (!err)
+    {
+        // concatenate the tiles of the threads in order
+        for (k = 0; k < cnt; k++)
+            pb->ofs[k+1] = pb->ofs[k] + b.len[k];
+        pb->data = (unsigned char*) malloc(pb->ofs[cnt] ? pb->ofs[cnt] : 1);
+        if (!pb->data)
+            err = -1;
+    }
+    for (t = 0; b.buf && t < threads; t++)
+    {
+        size_t pos = 0;
+        for (k = t; !err && k < cnt; k += threads)
+        {
+            memcpy(pb->data + pb->ofs[k], b.buf[t] + pos, b.len[k]);
+            pos += b.len[k];
+        }
+        free(b.buf[t]);
+    }
+    free(b.buf);
+    free(b.len);
+    free(b.err);
+    if (err)
+        freePackedBiomes(pb);
+    return err;
+}
+
+int packBiomes(PackedBiomes *pb, const int *ids, Range r, int tilesiz)
+{
+    return packBiomesImpl(pb, NULL, ids, r, tilesiz, 1);
+}
+
+int genPackedBiomes(PackedBiomes *pb, const Generator *g, Range r,
+        int tilesiz, int threads)
+{
+    return packBiomesImpl(pb, g, NULL, r, tilesiz, threads);
+}
+
+void freePackedBiomes(PackedBiomes *pb)
+{
+    free(pb->ofs);
+    free(pb->data);
+    memset(pb, 0, sizeof(*pb));
+}
+
+// Decodes tile k of a compressed map.
+static int decodePackedTile(unsigned char *ids, const PackedBiomes *pb,
+        size_t k)
+{
+    return decodeBiomeTile(ids, pb->data + pb->ofs[k],
+        pb->ofs[k+1] - pb->ofs[k], pb->tilesiz * pb->tilesiz);
+}
+
+int unpackBiomeTile(const PackedBiomes *pb, int tx, int tz, int *out)
+{
+    int i, n = pb->tilesiz * pb->tilesiz;
+    if (tx < 0 || tx >= pb->tw || tz < 0 || tz >= pb->th)
+        return -1;
+    unsigned char *ids = (unsigned char*) malloc(n);
+    if (!ids)
+        return -1;
+    if (decodePackedTile(ids, pb, (size_t)tz * pb->tw + tx) != 0)
+    {
+        free(ids);
+        return -1;
+    }
+    for (i = 0; i < n; i++)
+        out[i] = ids[i] == 0xff ? -1 : ids[i];
+    free(ids);
+    return 0;
+}
+
+int getPackedBiomeAt(const PackedBiomes *pb, int x, int z)
+{
+    int ts = pb->tilesiz;
+    x -= pb->r.x;
+    z -= pb->r.z;
+    if (x < 0 || x >= pb->r.sx || z < 0 || z >= pb->r.sz)
+        return -1;
+    const unsigned char *enc = pb->data + pb->ofs[(z / ts) * pb->tw + x / ts];
+    return getPackedCell(enc, (z % ts) * ts + (x % ts));
+}
+
+int packedBiomesToImage(unsigned char *pixels,
+        unsigned char biomeColors[256][3], const PackedBiomes *pb,
+        const unsigned int pixscale, const int flip)
+{
+    int ts = pb->tilesiz, sx = pb->r.sx, sz = pb->r.sz;
+    int i, j, ti, tj, ret = 0;
+    unsigned char *tile = (unsigned char*) malloc(ts * ts);
+    uint8_t *band = (uint8_t*) malloc((size_t)sx * ts);
+
+    if (!tile || !band)
+        ret = -1;
+    for (tj = 0; tj < pb->th && !ret; tj++)
+    {
+        int j0 = tj * ts;
+        int h = sz - j0 < ts ? sz - j0 : ts;
+        for (ti = 0; ti < pb->tw; ti++)
+        {
+            int i0 = ti * ts;
+            int w = sx - i0 < ts ? sx - i0 : ts;
+            if (decodePackedTile(tile, pb, (size_t)tj * pb->tw + ti) != 0)
+            {
+                ret = -1;
+                break;
+            }
+            for (j = 0; j < h; j++)
+            {
+                for (i = 0; i < w; i++)
+                    band[(size_t)j * sx + i0 + i] = tile[j * ts + i];
+            }
+        }
+        if (ret)
+            break;
+        // the rows of the image are upside down unless flipped
+        size_t row = flip ? j0 : sz - j0 - h;
+        ret |= biomesToImage8(pixels + 3 * row * pixscale * pixscale * sx,
+            biomeColors, band, sx, h, pixscale, flip);
+    }
+    free(band);
+    free(tile);
+    return ret;
+}
+
+STRUCT(packed_header_t)
+{
+    char        magic[8];   // "CUBIOPAK"
+    uint32_t    version;
+    int32_t     scale, x, z, sx, sz, y;
+    int32_t     tilesiz;
+};
+
+int savePackedBiomes(const PackedBiomes *pb, const char *path)
+{
+    packed_header_t h;
+    size_t cnt = (size_t)pb->tw * pb->th;
+    FILE *fp = fopen(path, "wb");
+    if (!fp)
+        return -1;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "CUBIOPAK", 8);
+    h.version = PACKED_VERSION;
+    h.scale = pb->r.scale;
+    h.x = pb->r.x;
+    h.z = pb->r.z;
+    h.sx = pb->r.sx;
+    h.sz = pb->r.sz;
+    h.y = pb->r.y;
+    h.tilesiz = pb->tilesiz;
+    int ok =
+        fwrite(&h, sizeof(h), 1, fp) == 1 &&
+        fwrite(pb->ofs, sizeof(uint64_t), cnt+1, fp) == cnt+1 &&
+        fwrite(pb->data, 1, pb->ofs[cnt], fp) == pb->ofs[cnt];
+    fclose(fp);
+    return ok ? 0 : -1;
+}
+
+int loadPackedBiomes(PackedBiomes *pb, const char *path)
+{
+    packed_header_t h;
+    size_t k, cnt;
+    long fsize;
+    unsigned char *tile = NULL;
+    int ret = -2;
+    FILE *fp = fopen(path, "rb");
+    memset(pb, 0, sizeof(*pb));
+    if (!fp)
+        return -1;
+    if (fseek(fp, 0, SEEK_END) != 0 || (fsize = ftell(fp)) < 0 ||
+        fseek(fp, 0, SEEK_SET) != 0)
+    {
+        ret = -1;
+        goto L_end;
+    }
+    if (fread(&h, sizeof(h), 1, fp) != 1 || memcmp(h.magic, "CUBIOPAK", 8) ||
+        h.version != PACKED_VERSION || h.tilesiz <= 0 || h.tilesiz > 4096 ||
+        h.sx <= 0 || h.sz <= 0)
+    {
+        goto L_end;
+    }
+    Range r = { h.scale, h.x, h.z, h.sx, h.sz, h.y, 1 };
+    cnt = (size_t)((h.sx + (int64_t)h.tilesiz - 1) / h.tilesiz) *
+          (size_t)((h.sz + (int64_t)h.tilesiz - 1) / h.tilesiz);
+    // the offset table has to fit into the file
+    if ((uint64_t)cnt + 1 > ((uint64_t)fsize - sizeof(h)) / sizeof(uint64_t))
+        goto L_end;
+    if (initPackedBiomes(pb, r, h.tilesiz) != 0)
+    {
+        ret = -1;
+        goto L_end;
+    }
+    if (fread(pb->ofs, sizeof(uint64_t), cnt+1, fp) != cnt+1)
+    {
+        ret = -1;
+        goto L_fail;
+    }
+    // the offsets have to be increasing and stay within the file
+    if (pb->ofs[0] != 0 ||
+        pb->ofs[cnt] > (uint64_t)fsize - sizeof(h) - (cnt+1) * sizeof(uint64_t))
+        goto L_fail;
+    for (k = 0; k < cnt; k++)
+    {
+        if (pb->ofs[k+1] < pb->ofs[k])
+            goto L_fail;
+    }
+    pb->data = (unsigned char*) malloc(pb->ofs[cnt] ? pb->ofs[cnt] : 1);
+    tile = (unsigned char*) malloc((size_t)h.tilesiz * h.tilesiz);
+    if (!pb->data || !tile)
+    {
+        ret = -1;
+        goto L_fail;
+    }
+    if (fread(pb->data, 1, pb->ofs[cnt], fp) != pb->ofs[cnt])
+    {
+        ret = -1;
+        goto L_fail;
+    }
+    // validate the tiles once, so that the cell lookups can trust them
+    for (k = 0; k < cnt; k++)
+    {
+        if (decodePackedTile(tile, pb, k) != 0)
+            goto L_fail;
+    }
+    ret = 0;
+    goto L_end;
+L_fail:
+    freePackedBiomes(pb);
+L_end:
+    free(tile);
+    fclose(fp);
+    return ret;
+}
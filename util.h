@@ -2,6 +2,8 @@
 #define UTIL_H_
 
 
+#include "generator.h"
+
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -47,6 +49,12 @@ int biomesToImage(unsigned char *pixels,
         const unsigned int sx, const unsigned int sy,
         const unsigned int pixscale, const int flip);
 
+/// same as biomesToImage() for the compact ids of genBiomes8()
+int biomesToImage8(unsigned char *pixels,
+        unsigned char biomeColors[256][3], const uint8_t *biomes,
+        const unsigned int sx, const unsigned int sy,
+        const unsigned int pixscale, const int flip);
+
 /* Save the pixel buffer (e.g. from biomesToImage) to the given path as an PPM
  * image file. Returns 0 if successful, or -1 if the file could not be opened,
  * or 1 if not all the pixel data could be written to the file.
@@ -54,6 +62,145 @@ int biomesToImage(unsigned char *pixels,
 int savePPM(const char* path, const unsigned char *pixels,
         const unsigned int sx, const unsigned int sy);
 
+/* Runs 'func(data, t)' for each t in [0, threads) on its own thread, where the
+ * calling thread takes t = 0, and returns once all of them have finished. The
+ * shares of threads that cannot be created run on the calling thread instead.
+ */
+void runThreads(int threads, void (*func)(void *data, int t), void *data);
+
+
+enum { BIOME_MAP_VERSION = 1 };
+
+/* Header of a biome map file. The header is followed by one completion flag
+ * byte per tile, and the tiles start at the page aligned offset 'dataofs'.
+ * Each tile holds tilesiz * tilesiz cells of 'cellsiz' bytes in row-major
+ * order, where the cells outside the map extent are -1. The fields are in
+ * native byte order.
+ */
+STRUCT(BiomeMapHeader)
+{
+    char        magic[8];   // "CUBIOMAP"
+    uint32_t    version;    // BIOME_MAP_VERSION
+    uint32_t    cellsiz;    // bytes per cell
+    uint64_t    seed;
+    int32_t     mc, dim;
+    uint32_t    flags;
+    int32_t     scale, x, z, sx, sz, y;
+    int32_t     tilesiz;    // tile width and height in cells
+    int32_t     tw, th;     // number of tiles along x and z
+    uint64_t    dataofs;    // file offset of the first tile
+};
+
+/* A memory-mapped biome map file. Only the tiles that are accessed get paged
+ * in, so maps can be much larger than the available memory.
+ */
+STRUCT(BiomeMap)
+{
+    BiomeMapHeader *hdr;
+    unsigned char *done;    // completion flag of each tile
+    unsigned char *data;    // first tile
+    size_t size;            // size of the mapping
+};
+
+/* Creates a biome map file for the area 'r' (which should have sy = 1) of a
+ * generator that has had its seed applied, made up of tiles of tilesiz^2
+ * cells. If the file already exists with a matching header, it is reopened
+ * instead, so that an interrupted generation can be resumed.
+ * Returns the number of tiles that are already completed, or -1 if the file
+ * could not be created or mapped, or -2 if the existing file is of a different
+ * layout or generator.
+ */
+int createBiomeMap(BiomeMap *bm, const char *path, const Generator *g,
+        Range r, int tilesiz);
+
+/* Generates the tiles of a biome map that are not completed yet, using the
+ * given number of threads. The generator has to match the one the map was
+ * created with. The flag of each tile is only set once the tile is written
+ * back to the file, so the generation can be stopped (or interrupted) and
+ * resumed at any time. Each thread writes its tiles back in batches, so an
+ * interruption loses at most the last batch of each thread. Returns the number
+ * of generated tiles, or -1 if the generator does not match or the memory
+ * could not be allocated.
+ */
+int genBiomeMap(BiomeMap *bm, const Generator *g, int threads,
+        volatile char *stop);
+
+/* Opens an existing biome map file for reading.
+ * Returns 0 on success, -1 if the file could not be opened or mapped, or -2 if
+ * it is not a biome map of a supported version or its header is inconsistent.
+ */
+int openBiomeMap(BiomeMap *bm, const char *path);
+
+/* Flushes and unmaps a biome map. */
+void closeBiomeMap(BiomeMap *bm);
+
+/* Gets the cells of tile (tx, tz), counted from the map origin, or NULL if the
+ * tile is outside of the map or has not been completed.
+ */
+const int *getBiomeMapTile(const BiomeMap *bm, int tx, int tz);
+
+/* Gets the biome at the cell (x, z) of the map range, i.e. at scale 1:scale,
+ * or -1 if the cell is outside of the map or its tile is not completed.
+ */
+int getBiomeMapAt(const BiomeMap *bm, int x, int z);
+
+
+/* A compressed biome map of a 2D range, split into tiles of tilesiz^2 cells
+ * that are encoded independently, so any tile can be accessed without
+ * decoding the rest. Each tile is stored with a palette of its biomes, and
+ * either as bit-packed palette indices (0, 1, 2, 4 or 8 bits per cell) or as
+ * runs along its rows, whichever is smaller. The tiles are stored in order,
+ * where tile k occupies data[ofs[k], ofs[k+1]).
+ */
+STRUCT(PackedBiomes)
+{
+    Range r;
+    int tilesiz;
+    int tw, th;             // number of tiles along x and z
+    uint64_t *ofs;          // tw * th + 1 tile offsets
+    unsigned char *data;
+};
+
+/* Compresses the biome ids of the range 'r' (as from genBiomes(), sy = 1) in
+ * tiles of tilesiz^2 cells. Returns 0 on success, or -1 on failure, in which
+ * case 'pb' is left empty.
+ */
+int packBiomes(PackedBiomes *pb, const int *ids, Range r, int tilesiz);
+
+/* Generates and compresses the range 'r' tile by tile, using the given number
+ * of threads, so that the uncompressed map is never held in memory.
+ * Returns 0 on success.
+ */
+int genPackedBiomes(PackedBiomes *pb, const Generator *g, Range r,
+        int tilesiz, int threads);
+
+void freePackedBiomes(PackedBiomes *pb);
+
+/* Decodes tile (tx, tz) into 'out' with tilesiz^2 entries, where the cells
+ * outside the range are -1. Returns 0 on success, or -1 if the tile is outside
+ * of the map or corrupt.
+ */
+int unpackBiomeTile(const PackedBiomes *pb, int tx, int tz, int *out);
+
+/* Gets the biome at the cell (x, z) of the range, or -1 if it is outside. */
+int getPackedBiomeAt(const PackedBiomes *pb, int x, int z);
+
+/* Same as biomesToImage() for the whole range of a compressed map, which is
+ * decoded one row of tiles at a time.
+ */
+int packedBiomesToImage(unsigned char *pixels,
+        unsigned char biomeColors[256][3], const PackedBiomes *pb,
+        const unsigned int pixscale, const int flip);
+
+/* Saves and loads compressed maps. The load returns 0 on success, -1 if the
+ * file could not be read (or allocation failed), or -2 if it is not in a
+ * supported format or is corrupt, where the offsets and every tile are checked
+ * before the map is accepted. The save
+ * returns 0 on success, or -1 if the file could not be written.
+ */
+int savePackedBiomes(const PackedBiomes *pb, const char *path);
+int loadPackedBiomes(PackedBiomes *pb, const char *path);
+
 #ifdef __cplusplus
 }
 #endif